@@ -76,11 +76,13 @@ check_include_file(unistd.h HAVE_UNISTD_H)
 check_include_file(utime.h HAVE_UTIME_H)
 check_include_file(valgrind/valgrind.h HAVE_VALGRIND_VALGRIND_H)
 check_include_file(windows.h HAVE_WINDOWS_H)
+check_include_file(zlib.h HAVE_ZLIB_H)
 
 # library checks
 INCLUDE(CheckLibraryExists)
 check_library_exists(pthread pthread_create "" HAVE_LIBPTHREAD)
 check_library_exists(dl dlopen "" HAVE_LIBDL)
+check_library_exists(z compress2 "" HAVE_LIBZ)
 
 IF (HAVE_LIBDL)
     SET(LIBDL "dl")
@@ -88,6 +90,19 @@ ELSE (HAVE_LIBDL)
     SET(LIBDL "")
 ENDIF (HAVE_LIBDL)
 
+IF (HAVE_LIBPTHREAD)
+    SET(LIBPTHREAD "pthread")
+ELSE (HAVE_LIBPTHREAD)
+    SET(LIBPTHREAD "")
+ENDIF (HAVE_LIBPTHREAD)
+
+# zlib is used to compress debug sections.
+IF (HAVE_LIBZ AND HAVE_ZLIB_H)
+    SET(LIBZ "z")
+ELSE (HAVE_LIBZ AND HAVE_ZLIB_H)
+    SET(LIBZ "")
+ENDIF (HAVE_LIBZ AND HAVE_ZLIB_H)
+
 # function checks
 INCLUDE(CheckSymbolExists)
 INCLUDE(CheckFunctionExists)
@@ -214,18 +229,15 @@ endif( MSVC )
 # FIXME: Signal handler return type, currently hardcoded to 'void'
 set(RETSIGTYPE void)
 
-#if( LLVM_ENABLE_THREADS )
-#  if( HAVE_PTHREAD_H OR WIN32 )
-#    set(ENABLE_THREADS 1)
-#  endif( HAVE_PTHREAD_H OR WIN32 )
-#endif( LLVM_ENABLE_THREADS )
-#
-#if( ENABLE_THREADS )
-#  message(STATUS "Threads enabled.")
-#else( ENABLE_THREADS )
-#  message(STATUS "Threads disabled.")
-#endif( ENABLE_THREADS )
-set(LLVM_MULTITHREADED 0)
+# Threads are used to render sections concurrently during output.
+if( HAVE_PTHREAD_H AND HAVE_PTHREAD_MUTEX_LOCK AND NOT WIN32 )
+  set(ENABLE_THREADS 1)
+  set(LLVM_MULTITHREADED 1)
+  message(STATUS "Threads enabled.")
+else( HAVE_PTHREAD_H AND HAVE_PTHREAD_MUTEX_LOCK AND NOT WIN32 )
+  set(LLVM_MULTITHREADED 0)
+  message(STATUS "Threads disabled.")
+endif( HAVE_PTHREAD_H AND HAVE_PTHREAD_MUTEX_LOCK AND NOT WIN32 )
 
 if(WIN32)
   if(CYGWIN)
@@ -0,0 +1,85 @@
+#! /usr/bin/env python
+# DWARF CFI CIE sharing benchmark
+#
+# Generates sources with many .cfi_startproc/.cfi_endproc blocks and reports
+# the time to assemble each with .eh_frame and .debug_frame output.  In the
+# "shared" input every function has the same initial instructions, so all
+# FDEs share one CIE; in the "distinct" input each function's initial CFA
+# offset differs, so each FDE needs its own CIE and the cost of finding a
+# matching CIE dominates.
+#
+# Usage: cfi_cie.py <yasm executable> [functions]
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+def gen(n, distinct):
+    lines = [".text\n"]
+    for i in range(n):
+        lines.append("f%d:\n    .cfi_startproc\n" % i)
+        if distinct:
+            lines.append("    .cfi_def_cfa_offset %d\n" % (8 + 8 * i))
+        lines.append("    pushq %rbp\n"
+                     "    .cfi_def_cfa_offset 16\n"
+                     "    .cfi_offset 6, -16\n"
+                     "    movq %rsp, %rbp\n"
+                     "    .cfi_def_cfa_register 6\n"
+                     "    popq %rbp\n"
+                     "    .cfi_def_cfa 7, 8\n"
+                     "    ret\n"
+                     "    .cfi_endproc\n")
+    lines.append("    .cfi_sections .eh_frame, .debug_frame\n")
+    return "".join(lines)
+
+def run(yasm, src, outdir):
+    fn = os.path.join(outdir, "in.s")
+    f = open(fn, "w")
+    try:
+        f.write(src)
+    finally:
+        f.close()
+    out = os.path.join(outdir, "out.o")
+    start = time.time()
+    rc = subprocess.call([yasm, "-p", "gas", "-f", "elf64", "-o", out, fn])
+    end = time.time()
+    if rc != 0:
+        sys.exit("yasm failed with exit code %d" % rc)
+    return end - start
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: %s <yasm executable> [functions]" % sys.argv[0])
+    yasm = sys.argv[1]
+    n = len(sys.argv) > 2 and int(sys.argv[2]) or 100000
+    outdir = tempfile.mkdtemp()
+    stime = run(yasm, gen(n, False), outdir)
+    dtime = run(yasm, gen(n, True), outdir)
+    print("%d functions: shared CIE %.3f s, distinct CIEs %.3f s"
+          % (n, stime, dtime))
+
+if __name__ == "__main__":
+    main()
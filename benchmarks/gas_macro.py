@@ -0,0 +1,95 @@
+#! /usr/bin/env python
+# GAS macro expansion benchmark
+#
+# Generates a source file with many .macro/.irp expansions and the same code
+# written out by hand, assembles both, and reports the time for each.
+#
+# Usage: gas_macro.py <yasm executable> [invocations]
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+MACROS = """\
+.macro round a, b, c
+    addl \\a, \\b
+    xorl \\b, \\c
+    roll $7, \\c
+.endm
+.macro entry name, val
+\\name\\()_lbl: .long \\val, \\name\\()_lbl
+.endm
+"""
+
+def gen_macro(n):
+    lines = [MACROS]
+    for i in range(n):
+        lines.append("round %eax, %ebx, %ecx\n")
+        lines.append("entry e%d, %d\n" % (i, i))
+    lines.append(".irp r, %eax, %ebx, %ecx, %edx\n    incl \\r\n.endr\n")
+    return "".join(lines)
+
+def gen_plain(n):
+    lines = []
+    for i in range(n):
+        lines.append("    addl %eax, %ebx\n    xorl %ebx, %ecx\n"
+                     "    roll $7, %ecx\n")
+        lines.append("e%d_lbl: .long %d, e%d_lbl\n" % (i, i, i))
+    for r in ("%eax", "%ebx", "%ecx", "%edx"):
+        lines.append("    incl %s\n" % r)
+    return "".join(lines)
+
+def run(yasm, src, outdir):
+    fn = os.path.join(outdir, "in.s")
+    f = open(fn, "w")
+    try:
+        f.write(src)
+    finally:
+        f.close()
+    out = os.path.join(outdir, "out.o")
+    start = time.time()
+    rc = subprocess.call([yasm, "-p", "gas", "-f", "elf32", "-o", out, fn])
+    end = time.time()
+    if rc != 0:
+        sys.exit("yasm failed with exit code %d" % rc)
+    return end - start, os.path.getsize(out)
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: %s <yasm executable> [invocations]" % sys.argv[0])
+    yasm = sys.argv[1]
+    n = len(sys.argv) > 2 and int(sys.argv[2]) or 100000
+    outdir = tempfile.mkdtemp()
+    mtime, msize = run(yasm, gen_macro(n), outdir)
+    ptime, psize = run(yasm, gen_plain(n), outdir)
+    if msize != psize:
+        sys.exit("output size mismatch: %d (macro) vs %d (plain)"
+                 % (msize, psize))
+    print("%d invocations: macro %.3f s, expanded by hand %.3f s"
+          % (n, mtime, ptime))
+
+if __name__ == "__main__":
+    main()
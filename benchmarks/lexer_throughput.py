@@ -0,0 +1,110 @@
+#! /usr/bin/env python
+# Lexer throughput benchmark
+#
+# Generates large machine-generated-style sources for the GAS and NASM
+# parsers (long symbol names, padding whitespace, line comments, and string
+# data), assembles each, and reports input throughput in MB/s.  The inputs
+# are chosen so that most of the time is spent in the lexer; compare runs of
+# two yasm builds to measure lexer changes.
+#
+# Usage: lexer_throughput.py <yasm executable> [megabytes] [repeat]
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+COMMENT = "this line was produced by a code generator; it has no meaning"
+
+def gen_gas(size):
+    lines = []
+    total = 0
+    i = 0
+    while total < size:
+        name = "_ZN9generated9namespace15function_number%dEv" % i
+        chunk = ("%s:\t\t\t\t# %s\n"
+                 "\tmovl\t%%eax, %s(%%rip)\t\t# %s\n"
+                 "\t.ascii\t\"string literal %d for the generated function\"\n"
+                 "\t\t\t\t\t\t# %s %s\n"
+                 % (name, COMMENT, name, COMMENT, i, COMMENT, COMMENT))
+        lines.append(chunk)
+        total += len(chunk)
+        i += 1
+    return "".join(lines)
+
+def gen_nasm(size):
+    lines = ["bits 64\ndefault rel\n"]
+    total = 0
+    i = 0
+    while total < size:
+        name = "generated_namespace_function_number_%d" % i
+        chunk = ("%s:\t\t\t\t; %s\n"
+                 "\tmov\t[%s], eax\t\t; %s\n"
+                 "\tdb\t'string literal %d for the generated function'\n"
+                 "\t\t\t\t\t\t; %s %s\n"
+                 % (name, COMMENT, name, COMMENT, i, COMMENT, COMMENT))
+        lines.append(chunk)
+        total += len(chunk)
+        i += 1
+    return "".join(lines)
+
+def run(yasm, args, src, outdir, repeat):
+    fn = os.path.join(outdir, "in.asm")
+    f = open(fn, "w")
+    try:
+        f.write(src)
+    finally:
+        f.close()
+    out = os.path.join(outdir, "out.o")
+    best = None
+    for i in range(repeat):
+        start = time.time()
+        rc = subprocess.call([yasm] + args + ["-o", out, fn])
+        elapsed = time.time() - start
+        if rc != 0:
+            sys.exit("yasm failed with exit code %d" % rc)
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: %s <yasm executable> [megabytes] [repeat]"
+                 % sys.argv[0])
+    yasm = sys.argv[1]
+    mb = len(sys.argv) > 2 and int(sys.argv[2]) or 20
+    repeat = len(sys.argv) > 3 and int(sys.argv[3]) or 3
+    outdir = tempfile.mkdtemp()
+    for parser, gen, args in (
+            ("gas", gen_gas, ["-p", "gas", "-f", "elf64"]),
+            ("nasm", gen_nasm, ["-p", "nasm", "-f", "elf64"])):
+        src = gen(mb * 1024 * 1024)
+        secs = run(yasm, args, src, outdir, repeat)
+        print("%-5s %6.1f MB in %.3f s: %.1f MB/s"
+              % (parser, len(src) / 1048576.0, secs,
+                 len(src) / 1048576.0 / secs))
+
+if __name__ == "__main__":
+    main()
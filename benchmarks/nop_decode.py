@@ -0,0 +1,127 @@
+#! /usr/bin/env python
+# Alignment padding decode benchmark
+#
+# Generates a loop made of 64-byte blocks, each ending in alignment padding
+# of a different length, assembles it once per --tune setting, links it
+# against a small C timing driver, and reports the time per loop iteration.
+# Since the padding lies on the executed path, the difference between
+# tunings is the front-end cost of decoding the NOP sequences each one
+# emits on the host processor.
+#
+# Usage: nop_decode.py <yasm executable> [iterations] [repeat]
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+import os
+import subprocess
+import sys
+import tempfile
+
+TUNINGS = ("generic", "intel", "amd")
+
+# Padding lengths exercised by each loop iteration (one 64-byte block each).
+PADS = (1, 3, 7, 9, 11, 12, 15, 16, 20, 24, 31, 40, 48, 59)
+
+# Fillers for the payload residue after the 5-byte moves; none are NOPs.
+RESIDUE = {
+    0: "",
+    1: "\tcdq\n",
+    2: "\txor ecx, ecx\n",
+    3: "\txor r8d, r8d\n",
+    4: "\tlea rcx, [rdx+1]\n",
+}
+
+DRIVER = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern void pad_loop(unsigned long iters);
+
+int main(int argc, char **argv)
+{
+    unsigned long iters = strtoul(argv[1], NULL, 0);
+    struct timespec start, end;
+    pad_loop(1000);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pad_loop(iters);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%f\n", ((end.tv_sec - start.tv_sec) * 1e9 +
+                    (end.tv_nsec - start.tv_nsec)) / iters);
+    return 0;
+}
+"""
+
+def gen_loop():
+    regs = ("eax", "ecx", "edx", "esi")
+    lines = ["bits 64\nsection .text\nglobal pad_loop\n",
+             "align 64\npad_loop:\n"]
+    for pad in PADS:
+        payload = 64 - pad
+        for i in range(payload // 5):
+            lines.append("\tmov %s, %d\n" % (regs[i % len(regs)], i))
+        lines.append(RESIDUE[payload % 5])
+        lines.append("\talign 64\n")
+    lines.append("\tdec rdi\n\tjnz pad_loop\n\tret\n")
+    lines.append("section .note.GNU-stack noalloc noexec nowrite progbits\n")
+    return "".join(lines)
+
+def write(fn, text):
+    f = open(fn, "w")
+    try:
+        f.write(text)
+    finally:
+        f.close()
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: %s <yasm executable> [iterations] [repeat]"
+                 % sys.argv[0])
+    yasm = sys.argv[1]
+    iters = len(sys.argv) > 2 and int(sys.argv[2]) or 2000000
+    repeat = len(sys.argv) > 3 and int(sys.argv[3]) or 5
+    cc = os.environ.get("CC", "cc")
+    outdir = tempfile.mkdtemp()
+    src = os.path.join(outdir, "loop.asm")
+    driver = os.path.join(outdir, "driver.c")
+    write(src, gen_loop())
+    write(driver, DRIVER)
+    print("%d padding bytes per iteration" % sum(PADS))
+    for tune in TUNINGS:
+        obj = os.path.join(outdir, "loop-%s.o" % tune)
+        exe = os.path.join(outdir, "bench-%s" % tune)
+        if subprocess.call([yasm, "-f", "elf64", "--tune=" + tune,
+                            "-o", obj, src]) != 0:
+            sys.exit("yasm failed for tuning %s" % tune)
+        if subprocess.call([cc, "-O2", "-o", exe, driver, obj]) != 0:
+            sys.exit("%s failed to link benchmark" % cc)
+        best = None
+        for i in range(repeat):
+            ns = float(subprocess.Popen([exe, str(iters)],
+                                        stdout=subprocess.PIPE)
+                       .communicate()[0])
+            if best is None or ns < best:
+                best = ns
+        print("%-8s %8.2f ns/iteration" % (tune, best))
+
+if __name__ == "__main__":
+    main()
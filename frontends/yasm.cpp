@@ -106,6 +106,11 @@ static cl::alias arch_keyword_long("arch",
     cl::value_desc("arch"),
     cl::aliasopt(arch_keyword));
 
+// --branches-within-32B-boundaries
+static cl::opt<bool> branches_within_32B("branches-within-32B-boundaries",
+    cl::desc("keep x86 branches from crossing or ending on 32-byte "
+             "boundaries"));
+
 // -D, -d
 static cl::list<std::string> predefine_macros("D",
     cl::desc("Pre-define a macro, optionally to value"),
@@ -156,6 +161,14 @@ static cl::list<bool> execstack("execstack",
 static cl::list<bool> noexecstack("noexecstack",
     cl::desc("don't require executable stack for this object"));
 
+// --bigobj
+static cl::opt<bool> big_obj("bigobj",
+    cl::desc("Use big object file header (win32/win64 only)"));
+
+// --compress-debug-sections
+static cl::opt<bool> compress_debug("compress-debug-sections",
+    cl::desc("Compress debugging sections (elf only)"));
+
 // -f, --oformat
 static cl::opt<std::string> objfmt_keyword("f",
     cl::desc("Select object format (list with -f help)"),
@@ -197,6 +210,17 @@ static cl::alias include_paths_alias("i",
     cl::aliasopt(include_paths),
     cl::Prefix);
 
+// -j, --jobs
+static cl::opt<unsigned int> output_threads("j",
+    cl::desc("Use at most <n> threads to generate output (0 = all CPUs)"),
+    cl::value_desc("n"),
+    cl::Prefix,
+    cl::init(0));
+static cl::alias output_threads_long("jobs",
+    cl::desc("Alias for -j"),
+    cl::value_desc("n"),
+    cl::aliasopt(output_threads));
+
 // -L, --lformat
 static cl::opt<std::string> listfmt_keyword("L",
     cl::desc("Select list format (list with -L help)"),
@@ -246,6 +270,15 @@ static cl::opt<int> optimize_level("O",
     cl::Prefix,
     cl::Hidden);
 
+// -Os
+static cl::opt<bool> optimize_size("Os",
+    cl::desc("Select shortest equivalent instruction encodings"));
+
+// --tune
+static cl::opt<std::string> tune_name("tune",
+    cl::desc("Tune alignment padding for processor"),
+    cl::value_desc("cpu"));
+
 // -N, --plugin
 #ifndef BUILD_STATIC
 static cl::list<std::string> plugin_names("N",
@@ -471,6 +504,10 @@ ConfigureObject(yasm::Object& object)
 {
     yasm::Object::Config& config = object.getConfig();
 
+    config.OutputThreads = output_threads;
+    config.BigObj = big_obj;
+    config.CompressDebug = compress_debug;
+
     // Walk through execstack and noexecstack in parallel, ordering by command
     // line argument position.
     unsigned int exec_pos = 0, exec_num = 0;
@@ -699,6 +736,10 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     if (!machine_name.empty())
         assembler.setMachine(machine_name, diags);
 
+    // Set tuning if specified.
+    if (!tune_name.empty())
+        assembler.setTune(tune_name, diags);
+
     if (diags.hasFatalErrorOccurred())
         return EXIT_FAILURE;
 
@@ -719,6 +760,10 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     headers.SetSearchPaths(dirs, 0, false);
 
     assembler.getArch()->setVar("force_strict", force_strict);
+    if (branches_within_32B)
+        assembler.getArch()->setVar("branch_boundary", 32);
+    if (optimize_size)
+        assembler.getArch()->setVar("optimize_size", 1);
 
     // open the input file or STDIN (for filename of "-")
     if (in_filename == "-")
@@ -139,6 +139,12 @@ static cl::list<bool> noexecstack("noexecstack",
 static cl::list<bool> no_signed_overflow("J",
     cl::desc("don't warn about signed overflow"));
 
+// --jobs
+static cl::opt<unsigned int> output_threads("jobs",
+    cl::desc("use at most <n> threads to generate output (0 = all CPUs)"),
+    cl::value_desc("n"),
+    cl::init(0));
+
 // -I
 static cl::list<std::string> include_paths("I",
     cl::desc("Add include path"),
@@ -156,6 +162,33 @@ static cl::list<std::string> plugin_names("plugin",
     cl::value_desc("plugin"));
 #endif
 
+// --compress-debug-sections, --nocompress-debug-sections
+static cl::opt<bool> compress_debug("compress-debug-sections",
+    cl::desc("compress DWARF debug sections using zlib (elf only)"));
+static cl::opt<bool> nocompress_debug("nocompress-debug-sections",
+    cl::desc("don't compress DWARF debug sections"));
+
+// --gdwarf-64
+static cl::opt<bool> dwarf64("gdwarf-64",
+    cl::desc("generate 64-bit DWARF debugging information (elf64 only)"));
+
+// -mbig-obj
+static cl::opt<bool> big_obj("mbig-obj",
+    cl::desc("generate big object files (win32/win64 only)"));
+
+// -mbranches-within-32B-boundaries
+static cl::opt<bool> branches_within_32B("mbranches-within-32B-boundaries",
+    cl::desc("align branches within 32-byte boundaries"));
+
+// -Os
+static cl::opt<bool> optimize_size("Os",
+    cl::desc("select shortest equivalent instruction encodings"));
+
+// -mtune
+static cl::opt<std::string> tune_name("mtune",
+    cl::desc("tune alignment padding for CPU"),
+    cl::value_desc("cpu"));
+
 // -o
 static cl::opt<std::string> obj_filename("o",
     cl::desc("Name of object-file output"),
@@ -326,6 +359,12 @@ ConfigureObject(yasm::Object& object)
 {
     yasm::Object::Config& config = object.getConfig();
 
+    config.OutputThreads = output_threads;
+    config.BigObj = big_obj;
+    config.CompressDebug = compress_debug &&
+        (!nocompress_debug ||
+         compress_debug.getPosition() > nocompress_debug.getPosition());
+
     // Walk through execstack and noexecstack in parallel, ordering by command
     // line argument position.
     unsigned int exec_pos = 0, exec_num = 0;
@@ -384,11 +423,27 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     // Set parser.
     assembler.setParser("gas", diags);
 
+    // Set tuning if specified.
+    if (!tune_name.empty())
+        assembler.setTune(tune_name, diags);
+
     if (diags.hasFatalErrorOccurred())
         return EXIT_FAILURE;
 
+    if (branches_within_32B)
+        assembler.getArch()->setVar("branch_boundary", 32);
+    if (optimize_size)
+        assembler.getArch()->setVar("optimize_size", 1);
+
     // Set debug format to dwarf2pass if it's legal for this object format.
-    if (assembler.isOkDebugFormat("dwarf2pass"))
+    // 64-bit DWARF must be legal if requested.
+    if (dwarf64)
+    {
+        assembler.setDebugFormat("dwarf64pass", diags);
+        if (diags.hasFatalErrorOccurred())
+            return EXIT_FAILURE;
+    }
+    else if (assembler.isOkDebugFormat("dwarf2pass"))
     {
         assembler.setDebugFormat("dwarf2pass", diags);
         if (diags.hasFatalErrorOccurred())
@@ -333,7 +333,7 @@ DumpContents(const yasm::Object& object)
         if (sect->isBSS())
             continue;
 
-        unsigned long size = sect->bytecodes_back().getNextOffset();
+        uint64_t size = sect->bytecodes_back().getNextOffset();
         if (size == 0)
             continue;   // empty
 
@@ -309,6 +309,12 @@ public:
     /// @return True on success, false on failure (variable does not exist).
     virtual bool setVar(llvm::StringRef var, unsigned long val) = 0;
 
+    /// Set the processor to tune generated code (e.g. alignment padding)
+    /// for.  The default implementation recognizes no tunings.
+    /// @param tune     processor name
+    /// @return False if unrecognized tuning.
+    virtual bool setTune(llvm::StringRef tune);
+
     /// Determine if a custom parser (ParseInsn) should be used.  The default
     /// implementation returns false.
     /// @note This can be parser-dependent, so call setParser() first.
@@ -97,6 +97,12 @@ public:
     /// @return False on error.
     bool setMachine(llvm::StringRef machine, Diagnostic& diags);
 
+    /// Set the processor the architecture should tune generated code for.
+    /// @param tune             processor name
+    /// @param diags            diagnostic reporting
+    /// @return False on error.
+    bool setTune(llvm::StringRef tune, Diagnostic& diags);
+
     /// Set the parser.
     /// @param parser_keyword   parser keyword
     /// @param diags            diagnostic reporting
@@ -280,6 +280,7 @@ public:
   ~Diagnostic();
 
   void setSourceManager(SourceManager* smgr) { SrcMgr = smgr; }
+  SourceManager* getSourceManager() const { return SrcMgr; }
 
   //===--------------------------------------------------------------------===//
   //  Diagnostic characterization methods, used by a client to customize how
@@ -269,6 +269,15 @@ add_error("err_missing_or_invalid_immediate",
           "missing or invalid immediate expression")
 add_error("err_rept_without_endr", ".rept without matching .endr")
 add_error("err_endr_without_rept", ".endr without matching .rept")
+add_error("err_irp_without_endr", "%0 without matching .endr")
+add_error("err_macro_without_endm", ".macro without matching .endm")
+add_error("err_endm_without_macro", ".endm without matching .macro")
+add_error("err_macro_redefined", "macro '%0' was already defined")
+add_error("err_macro_missing_arg",
+          "missing value for required parameter '%0' of macro '%1'")
+add_error("err_macro_too_many_args",
+          "too many positional arguments for macro '%0'")
+add_error("err_macro_too_deep", "macro '%0' nested too deeply")
 add_error("err_bad_argument_to_syntax_dir", "bad argument to syntax directive")
 add_warning("warn_popsection_without_pushsection",
             ".popsection without corresponding .pushsection; ignored")
@@ -693,6 +702,8 @@ add_error("err_expected_merge_entity_size",
           "entity size for SHF_MERGE not specified")
 add_error("err_expected_group_name",
           "group name for SHF_GROUP not specified")
+add_warning("warn_elf_no_compress",
+            "compressed debug sections not supported in this build; ignored")
 
 # ELF/DWARF CFI
 add_error("err_nested_cfi",
@@ -720,6 +731,8 @@ add_warning("warn_outside_def",
             "%0 pseudo-op used outside of .def/.endef; ignored")
 add_warning("warn_endef_before_def",
             ".endef pseudo-op used before .def; ignored")
+add_error("err_coff_too_many_sections",
+          "%0 sections exceeds maximum of %1; use big object format")
 
 # Win32 object format
 add_error("err_win32_align_too_big",
@@ -33,6 +33,7 @@
 #include <memory>
 #include <vector>
 
+#include "llvm/System/DataTypes.h"
 #include "yasmx/Basic/SourceLocation.h"
 #include "yasmx/Config/export.h"
 #include "yasmx/Config/functional.h"
@@ -74,8 +75,8 @@ public:
     typedef TR1::function<void (Bytecode& bc,
                                 int id,
                                 const Value& value,
-                                long neg_thres,
-                                long pos_thres)>
+                                int64_t neg_thres,
+                                int64_t pos_thres)>
         AddSpanFunc;
 
     typedef std::auto_ptr<Bytecode> Ptr;
@@ -108,7 +109,7 @@ public:
         /// @return False if an error occurred.
         /// @note May store to bytecode updated expressions.
         virtual bool CalcLen(Bytecode& bc,
-                             /*@out@*/ unsigned long* len,
+                             /*@out@*/ uint64_t* len,
                              const Bytecode::AddSpanFunc& add_span,
                              Diagnostic& diags)
             = 0;
@@ -136,13 +137,13 @@ public:
         /// @return False if an error occurred.
         /// @note May store to bytecode updated expressions.
         virtual bool Expand(Bytecode& bc,
-                            unsigned long* len,
+                            uint64_t* len,
                             int span,
-                            long old_val,
-                            long new_val,
+                            int64_t old_val,
+                            int64_t new_val,
                             bool* keep,
-                            /*@out@*/ long* neg_thres,
-                            /*@out@*/ long* pos_thres,
+                            /*@out@*/ int64_t* neg_thres,
+                            /*@out@*/ int64_t* pos_thres,
                             Diagnostic& diags);
 
         /// Output a bytecode.
@@ -241,39 +242,49 @@ public:
     /// Get the offset of the bytecode.
     /// @return Offset of the bytecode in bytes.
     /// @warning Only valid /after/ optimization.
-    unsigned long getOffset() const { return m_offset; }
+    uint64_t getOffset() const
+    {
+        if (m_fused_host)
+            return m_fused_host->m_offset + m_offset;
+        return m_offset;
+    }
 
     /// Set the offset of the bytecode.
     /// @internal Should be used by Object::optimize() only.
     /// @param offset       new offset of the bytecode
-    void setOffset(unsigned long offset) { m_offset = offset; }
+    void setOffset(uint64_t offset) { m_offset = offset; }
 
     /// Get the offset of the start of the tail of the bytecode.
     /// @return Offset of the tail in bytes.
-    unsigned long getTailOffset() const { return m_offset + getFixedLen(); }
+    uint64_t getTailOffset() const { return getOffset() + getFixedLen(); }
 
     /// Get the offset of the next bytecode (the next bytecode doesn't have to
     /// actually exist).
     /// @return Offset of the next bytecode in bytes.
     /// @warning Only valid /after/ optimization.
-    unsigned long getNextOffset() const
-    { return m_offset + getTotalLen(); }
+    uint64_t getNextOffset() const
+    { return getOffset() + getTotalLen(); }
 
     /// Get the total length of the bytecode.
     /// @return Total length of the bytecode in bytes.
     /// @warning Only valid /after/ optimization.
-    unsigned long getTotalLen() const
-    { return static_cast<unsigned long>(m_fixed.size()) + m_len; }
+    uint64_t getTotalLen() const
+    { return static_cast<uint64_t>(m_fixed.size()) + m_len; }
 
-    /// Get the fixed length of the bytecode.
+    /// Get the fixed length of the bytecode.  For a fused bytecode, this is
+    /// the length of the data it contributed to its host.
     /// @return Length in bytes.
-    unsigned long getFixedLen() const
-    { return static_cast<unsigned long>(m_fixed.size()); }
+    uint64_t getFixedLen() const
+    {
+        if (m_fused_host)
+            return m_len;
+        return static_cast<uint64_t>(m_fixed.size());
+    }
 
     /// Get the tail (dynamic) length of the bytecode.
     /// @return Length of the bytecode in bytes.
     /// @warning Only valid /after/ optimization.
-    unsigned long getTailLen() const { return m_len; }
+    uint64_t getTailLen() const { return m_fused_host ? 0 : m_len; }
 
     /// Resolve EQUs in a bytecode and calculate its minimum size.
     /// Generates dependent bytecode spans for cases where, if the length
@@ -299,11 +310,11 @@ public:
     /// @note May store to bytecode updated expressions and the updated
     ///       length.
     bool Expand(int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
 
     /// Output a bytecode.
@@ -320,11 +331,12 @@ public:
     /// @param offset       offset to set this bytecode to
     /// @param diags        diagnostic reporting
     /// @return Offset of next bytecode.
-    unsigned long UpdateOffset(unsigned long offset, Diagnostic& diags);
+    uint64_t UpdateOffset(uint64_t offset, Diagnostic& diags);
 
     SourceLocation getSource() const { return m_source; }
 
-    unsigned long getIndex() const { return m_index; }
+    unsigned long getIndex() const
+    { return m_fused_host ? m_fused_host->m_index : m_index; }
     void setIndex(unsigned long idx) { m_index = idx; }
 
     Contents::SpecialType getSpecial() const;
@@ -351,6 +363,7 @@ public:
               SourceLocation source);
         void swap(Fixup& oth);
         unsigned int getOffset() const { return m_off; }
+        void setOffset(unsigned int off) { m_off = off; }
 
 #ifdef WITH_XML
         /// Write an XML representation.  For debugging purposes.
@@ -365,6 +378,32 @@ public:
 
     void AppendFixup(const Fixup& fixup) { m_fixed_fixups.push_back(fixup); }
 
+    /// Render the tail contents into the fixed portion and remove the
+    /// contents.  Only valid once the bytecode's offset and length are
+    /// final, and only for contents whose output is plain bytes (no
+    /// values or gaps), such as resolved alignment or org padding.
+    /// @param diags        diagnostic reporting
+    /// @return False if an error occurred.
+    bool ConvertTailToFixed(Diagnostic& diags);
+
+    /// Move the fixed data and fixups of a following bytecode onto the end
+    /// of this one.  Neither bytecode may have tail contents.  The other
+    /// bytecode is left empty but stays valid: its offset and index are
+    /// forwarded to this bytecode, so existing locations that refer to it
+    /// (labels, expressions) continue to resolve to the same place, and it
+    /// keeps reporting its original length.
+    /// @param oth          bytecode to fuse into this one
+    void Fuse(Bytecode& oth);
+
+    /// Get the bytecode this bytecode's data was fused into.
+    /// @return Host bytecode, or NULL if not fused.
+    const Bytecode* getFusedHost() const { return m_fused_host; }
+
+    /// Determine if any values in the fixed portion need conversion
+    /// at output time.
+    /// @return True if there are fixups.
+    bool hasFixups() const { return !m_fixed_fixups.empty(); }
+
 #ifdef WITH_XML
     /// Write an XML representation.  For debugging purposes.
     /// @param out          XML node
@@ -387,14 +426,20 @@ private:
     /*@dependent@*/ BytecodeContainer* m_container;
 
     /// Total length of tail contents (not including multiple copies).
-    unsigned long m_len;
+    /// If fused, this is instead the length of the fixed data that was
+    /// moved into the host bytecode.
+    uint64_t m_len;
 
     /// Source location where bytecode tail was defined.
     SourceLocation m_source;
 
     /// Offset of bytecode from beginning of its section.
-    /// 0-based, ~0UL (e.g. all 1 bits) if unknown.
-    unsigned long m_offset;
+    /// 0-based, all 1 bits if unknown.
+    /// If fused, this is instead the offset within the host bytecode.
+    uint64_t m_offset;
+
+    /// Bytecode this bytecode's data was fused into (NULL if not fused).
+    /*@dependent@*/ /*@null@*/ Bytecode* m_fused_host;
 
     /// Unique integer index of bytecode.  Used during optimization.
     unsigned long m_index;
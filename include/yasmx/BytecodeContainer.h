@@ -73,7 +73,7 @@ public:
     /// @param size     number of bytes of gap
     /// @param source   source location
     /// @return Reference to gap bytecode.
-    Bytecode& AppendGap(unsigned long size, SourceLocation source);
+    Bytecode& AppendGap(uint64_t size, SourceLocation source);
 
     /// Start a new bytecode at the end of the container.  Factory function.
     /// @return Reference to new bytecode.
@@ -100,6 +100,14 @@ public:
 
     stdx::ptr_vector<Bytecode>::size_type size() { return m_bcs.size(); }
 
+    /// Bytecodes whose data has been fused into a preceding bytecode by
+    /// FuseBytecodes(), in their original order.  These are no longer
+    /// part of the main bytecode list but keep their source locations and
+    /// (forwarded) offsets, so listings and existing locations can still
+    /// refer to them.
+    const_bc_iterator fused_begin() const { return m_fused.begin(); }
+    const_bc_iterator fused_end() const { return m_fused.end(); }
+
     /// Get location for start of a bytecode container.
     Location getBeginLoc()
     {
@@ -115,6 +123,11 @@ public:
     /// @note Errors/warnings are stored into errwarns.
     void Finalize(Diagnostic& diags);
 
+    /// Merge each run of adjacent bytecodes that have no tail contents
+    /// into the first bytecode of the run.  Must be called after
+    /// Finalize() and before optimization.
+    void FuseBytecodes();
+
     /// Optimize this container.  Generally, Object::Optimize() should be
     /// called instead to optimize the entire object at once.
     /// @param diags        diagnostic reporting
@@ -144,6 +157,10 @@ private:
     stdx::ptr_vector<Bytecode> m_bcs;
     stdx::ptr_vector_owner<Bytecode> m_bcs_owner;
 
+    /// Bytecodes fused into others; see fused_begin().
+    stdx::ptr_vector<Bytecode> m_fused;
+    stdx::ptr_vector_owner<Bytecode> m_fused_owner;
+
     bool m_last_gap;        ///< Last bytecode is a gap bytecode
 };
 
@@ -202,6 +219,25 @@ void AppendData(BytecodeContainer& container,
                 SourceLocation source,
                 Diagnostic& diags);
 
+/// Append a data value to the end of a section, borrowing the expression.
+/// Intended for long data lists: the caller can reuse a single expression
+/// for every item.  Constant values are written directly into the fixed
+/// portion of the current bytecode; only values that don't simplify to
+/// an integer are copied into a fixup.
+/// @param sect         section
+/// @param expr         data value; contents are unspecified on return
+/// @param size         storage size (in bytes) for the data value
+/// @param arch         architecture
+/// @param source       source location
+/// @param diags        diagnostic reporting
+YASM_LIB_EXPORT
+void AppendData(BytecodeContainer& container,
+                Expr& expr,
+                unsigned int size,
+                const Arch& arch,
+                SourceLocation source,
+                Diagnostic& diags);
+
 /// Append a string value to the end of a section.
 /// @param sect         section
 /// @param str          string/data (may contain 0 values)
@@ -86,7 +86,7 @@ public:
 
     /// Get the total number of bytes (and gap) output.
     /// @return Number of bytes output.
-    unsigned long getNumOutput() const { return m_num_output; }
+    uint64_t getNumOutput() const { return m_num_output; }
 
     /// Output a value.
     ///
@@ -111,13 +111,23 @@ public:
     /// program is run.
     /// @param size         gap size, in bytes
     /// @param source       source location
-    inline void OutputGap(unsigned long size, SourceLocation source);
+    inline void OutputGap(uint64_t size, SourceLocation source);
 
     /// Output a sequence of bytes.
     /// @param bytes        bytes to output
     /// @param source       source location
     inline void OutputBytes(const Bytes& bytes, SourceLocation source);
 
+    /// Output a sequence of bytes held in memory not owned by a Bytes
+    /// object, such as a memory-mapped file.  Unlike OutputBytes(), the
+    /// data is not expected to be staged in a scratch buffer first.
+    /// @param data         bytes to output
+    /// @param size         number of bytes to output
+    /// @param source       source location
+    inline void OutputBuffer(const unsigned char* data,
+                             uint64_t size,
+                             SourceLocation source);
+
     /// Convert a value to bytes.  Called by OutputValue() so that
     /// implementations can keep track of relocations and verify legal
     /// expressions.
@@ -154,7 +164,7 @@ protected:
     /// Overrideable implementation of OutputGap().
     /// @param size         gap size, in bytes
     /// @param source       source location
-    virtual void DoOutputGap(unsigned long size,
+    virtual void DoOutputGap(uint64_t size,
                              SourceLocation source) = 0;
 
     /// Overrideable implementation of OutputBytes().
@@ -163,6 +173,16 @@ protected:
     virtual void DoOutputBytes(const Bytes& bytes,
                                SourceLocation source) = 0;
 
+    /// Overrideable implementation of OutputBuffer().  The base
+    /// implementation copies the data through DoOutputBytes() in
+    /// fixed-size chunks, so memory use stays bounded for any size.
+    /// @param data         bytes to output
+    /// @param size         number of bytes to output
+    /// @param source       source location
+    virtual void DoOutputBuffer(const unsigned char* data,
+                                uint64_t size,
+                                SourceLocation source);
+
 private:
     friend class Bytecode;
 
@@ -172,7 +192,7 @@ private:
     Diagnostic& m_diags;        ///< Diagnostic reporting
     Bytes m_scratch;            ///< Reusable scratch area
     Bytes m_bc_scratch;         ///< Reusable scratch area for Bytecode class
-    unsigned long m_num_output; ///< Total number of bytes+gap output
+    uint64_t m_num_output;      ///< Total number of bytes+gap output
 };
 
 inline Bytes&
@@ -207,7 +227,7 @@ BytecodeOutput::OutputSymbol(SymbolRef sym,
 }
 
 inline void
-BytecodeOutput::OutputGap(unsigned long size, SourceLocation source)
+BytecodeOutput::OutputGap(uint64_t size, SourceLocation source)
 {
     DoOutputGap(size, source);
     m_num_output += size;
@@ -217,7 +237,16 @@ inline void
 BytecodeOutput::OutputBytes(const Bytes& bytes, SourceLocation source)
 {
     DoOutputBytes(bytes, source);
-    m_num_output += static_cast<unsigned long>(bytes.size());
+    m_num_output += static_cast<uint64_t>(bytes.size());
+}
+
+inline void
+BytecodeOutput::OutputBuffer(const unsigned char* data,
+                             uint64_t size,
+                             SourceLocation source)
+{
+    DoOutputBuffer(data, size, source);
+    m_num_output += size;
 }
 
 /// No-output specialization of BytecodeOutput.
@@ -235,8 +264,11 @@ protected:
     bool ConvertValueToBytes(Value& value,
                              Location loc,
                              NumericOutput& num_out);
-    void DoOutputGap(unsigned long size, SourceLocation source);
+    void DoOutputGap(uint64_t size, SourceLocation source);
     void DoOutputBytes(const Bytes& bytes, SourceLocation source);
+    void DoOutputBuffer(const unsigned char* data,
+                        uint64_t size,
+                        SourceLocation source);
 };
 
 /// Stream output specialization of BytecodeOutput.
@@ -252,8 +284,11 @@ public:
     ~BytecodeStreamOutput();
 
 protected:
-    void DoOutputGap(unsigned long size, SourceLocation source);
+    void DoOutputGap(uint64_t size, SourceLocation source);
     void DoOutputBytes(const Bytes& bytes, SourceLocation source);
+    void DoOutputBuffer(const unsigned char* data,
+                        uint64_t size,
+                        SourceLocation source);
 
     llvm::raw_ostream& m_os;
 };
@@ -555,6 +555,22 @@ public:
               const Expr& rhs,
               SourceLocation source = SourceLocation());
 
+    /// Like Calc(), but if the operands are plain integers, compute the
+    /// result immediately instead of building an operator tree.  Operations
+    /// that would be an error (e.g. divide by zero) are left in the tree so
+    /// that Simplify() reports them.
+    /// @param op       operator
+    /// @param source   operator source location
+    void CalcFold(Op::Op op, SourceLocation source = SourceLocation());
+
+    /// Binary version of CalcFold().
+    /// @param op       operator
+    /// @param rhs      right hand side of operation
+    /// @param source   operator source location
+    void CalcFold(Op::Op op,
+                  const Expr& rhs,
+                  SourceLocation source = SourceLocation());
+
     /// @defgroup lowlevel Low Level Manipulators
     /// Functions to manipulate the innards of the expression terms.
     /// Use with caution.
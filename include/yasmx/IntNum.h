@@ -296,6 +296,18 @@ public:
     /// Determine if intnum will fit in a signed "long" without saturating.
     bool isInt() const;
 
+    /// Convert an intnum to an unsigned 64-bit value.
+    /// @note Parameter intnum is saturated to fit into 64 bits.  Use
+    ///       isOkSize() to check for overflow.
+    /// @return Unsigned 64-bit value of intn.
+    uint64_t getUInt64() const;
+
+    /// Convert an intnum to a signed 64-bit value.
+    /// @note Parameter intnum is saturated to fit into 64 bits.  Use
+    ///       isOkSize() to check for overflow.
+    /// @return Signed 64-bit value of intn.
+    int64_t getInt64() const;
+
     /// Check to see if intnum will fit without overflow into size bits.
     /// @param intn         intnum
     /// @param size         number of bits of output space
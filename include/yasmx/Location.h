@@ -29,6 +29,7 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
+#include "llvm/System/DataTypes.h"
 #include "yasmx/Config/export.h"
 
 
@@ -48,11 +49,11 @@ class IntNum;
 struct YASM_LIB_EXPORT Location
 {
     Bytecode* bc;
-    unsigned long off;
+    uint64_t off;
 
     /// Get real offset (bc offset + off)
     /// @return Offset.
-    unsigned long getOffset() const;
+    uint64_t getOffset() const;
 
 #ifdef WITH_XML
     /// Write an XML representation.  For debugging purposes.
@@ -76,6 +76,19 @@ public:
         /// Advise linker that stack should be non-executable.
         /// Defaults to false.
         bool NoExecStack;
+
+        /// Use an extended object format header that lifts the usual
+        /// limits on section count (only supported by some object formats,
+        /// e.g. win32/win64 "bigobj").  Defaults to false.
+        bool BigObj;
+
+        /// Compress debugging sections (only supported by some object
+        /// formats, e.g. ELF SHF_COMPRESSED).  Defaults to false.
+        bool CompressDebug;
+
+        /// Maximum number of threads used to render section contents
+        /// during output; 0 uses one per processor.  Defaults to 0.
+        unsigned int OutputThreads;
     };
 
     /// Constructor.  A default section is created as the first
@@ -91,7 +104,9 @@ public:
     /// Destructor.
     ~Object();
 
-    /// Finalize an object after parsing.
+    /// Finalize an object after parsing.  If successful, also fuses
+    /// adjacent fixed-only bytecodes in each section (see
+    /// BytecodeContainer::FuseBytecodes()).
     /// @param diags    diagnostic reporting
     void Finalize(Diagnostic& diags);
 
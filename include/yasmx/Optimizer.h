@@ -29,6 +29,7 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
+#include "llvm/System/DataTypes.h"
 #include "yasmx/Config/export.h"
 #include "yasmx/Support/scoped_ptr.h"
 #include "yasmx/DebugDumper.h"
@@ -38,6 +39,7 @@ namespace yasm
 {
 
 class Bytecode;
+class BytecodeContainer;
 class Diagnostic;
 class Value;
 
@@ -50,12 +52,22 @@ public:
     void AddSpan(Bytecode& bc,
                  int id,
                  const Value& value,
-                 long neg_thres,
-                 long pos_thres);
+                 int64_t neg_thres,
+                 int64_t pos_thres);
     void AddOffsetSetter(Bytecode& bc);
 
-    // Step1a: Set bytecode indexes, initial offsets, add spans and
-    // offset setters using the above functions.
+    /// Get the number of spans added so far.  Used during step 1a to
+    /// tell if a bytecode's length can change during optimization.
+    unsigned long getNumSpans() const;
+
+    /// Step 1a for one bytecode container: set bytecode indexes and
+    /// initial offsets, and add spans and offset setters.  Offsets are
+    /// final up to the first bytecode that can change length, so offset
+    /// setters (align, org) before that point are not tracked; outside of
+    /// BSS sections their padding becomes fixed data instead.
+    /// @param container    bytecode container
+    /// @param bc_index     next bytecode index (updated)
+    void Step1a(BytecodeContainer& container, unsigned long* bc_index);
 
     void Step1b();
 
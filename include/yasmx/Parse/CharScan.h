@@ -0,0 +1,71 @@
+#ifndef YASM_PARSE_CHARSCAN_H
+#define YASM_PARSE_CHARSCAN_H
+//
+// Block character scanners for the lexers
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Config/export.h"
+
+
+namespace yasm
+{
+
+// These scanners search a lexer buffer for the first character that ends a
+// run of "uninteresting" characters.  All of them stop at a nul character,
+// so they may be used on any nul-terminated buffer.  When SSE2 or AVX2 is
+// available (detected at runtime), whole 16 or 32 byte blocks are examined
+// at once.  Loads are aligned to the block size, so a scan never touches a
+// page beyond the one holding the terminating nul.
+
+/// Skip spaces and tabs.
+/// @param ptr      start of scan
+/// @return First character that is not ' ' or '\\t'.
+YASM_LIB_EXPORT
+const char* ScanHorzSpace(const char* ptr);
+
+/// Find the end of the body of a line comment.
+/// @param ptr      start of scan
+/// @return First '\\n', '\\r', '\\\\', or nul character.
+YASM_LIB_EXPORT
+const char* ScanLineComment(const char* ptr);
+
+/// Skip the common identifier characters [A-Za-z0-9_].  Lexers with
+/// additional identifier characters should continue checking with their
+/// own character tables from the returned position.
+/// @param ptr      start of scan
+/// @return First character not in [A-Za-z0-9_].
+YASM_LIB_EXPORT
+const char* ScanIdentifier(const char* ptr);
+
+/// Find the end of a run of plain string literal characters.
+/// @param ptr      start of scan
+/// @param endch    closing quote character
+/// @return First endch, '\\n', '\\r', '\\\\', or nul character.
+YASM_LIB_EXPORT
+const char* ScanStringLiteral(const char* ptr, char endch);
+
+} // namespace yasm
+
+#endif
@@ -52,6 +52,7 @@ class YASM_LIB_EXPORT IdentifierInfo
     {
         DID_INSN_LOOKUP = 0x0001,   // Set if DoInsnLookup() done.
         DID_REG_LOOKUP  = 0x0002,   // Set if DoRegLookup() done.
+        DID_DIR_LOOKUP  = 0x0200,   // Set if setDirective() called.
 
         // Only one of the below flags can be set at a time; the bit set
         // determines what kind of object m_info points to.
@@ -74,6 +75,7 @@ class YASM_LIB_EXPORT IdentifierInfo
     void* m_insn;       // Pointer to instruction/prefix data.
     void* m_reg;        // Pointer to register data.
     void* m_custom;     // Pointer to custom data.
+    void* m_dir;        // Pointer to parser directive data (may be 0).
 
     llvm::StringMapEntry<IdentifierInfo*>* m_entry;
 
@@ -90,6 +92,7 @@ public:
         : m_insn(0)
         , m_reg(0)
         , m_custom(0)
+        , m_dir(0)
         , m_token_id(Token::unknown)
         , m_flags(0)
     {}
@@ -227,6 +230,23 @@ public:
         m_flags = IS_CUSTOM | DID_INSN_LOOKUP | DID_REG_LOOKUP;
         m_custom = const_cast<void*>(reinterpret_cast<const void*>(d));
     }
+
+    // parser directive cache interface; the parser owning the identifier
+    // table defines what the directive data is.  Independent of the
+    // other lookups (a name can be both a directive and a symbol).
+    bool isDirLookupDone() const { return (m_flags & DID_DIR_LOOKUP) != 0; }
+    template<typename T>
+    T* getDirective() const
+    {
+        assert((m_flags & DID_DIR_LOOKUP) != 0 && "directive lookup not done");
+        return static_cast<T*>(m_dir);
+    }
+    template<typename T>
+    void setDirective(T* d)
+    {
+        m_flags |= DID_DIR_LOOKUP;
+        m_dir = const_cast<void*>(reinterpret_cast<const void*>(d));
+    }
 };
 
 /// IdentifierTable - This table implements an efficient mapping from strings to
@@ -112,6 +112,15 @@ protected:
         return ptr;
     }
   
+    /// Get the value of a digit character that has already been validated
+    /// for the radix.
+    static unsigned int DigitValue(char ch)
+    {
+        if (ch <= '9')
+            return ch - '0';
+        return (ch | 0x20) - 'a' + 10;
+    }
+
     /// Read and skip over any binary digits, up to End.
     /// Return a pointer to the first non-binary digit or End.
     const char* SkipBinaryDigits(const char* ptr)
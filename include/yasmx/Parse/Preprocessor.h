@@ -32,6 +32,7 @@
 //
 #include <cassert>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -131,16 +132,35 @@ public:
     /// tokens has a permanent owner somewhere, so they do not need to be copied.
     /// If it is true, it assumes the array of tokens is allocated with new[] and
     /// must be freed.
+    ///
+    /// The token stream is lexed Repeat times in succession without making
+    /// copies of the tokens.
     void EnterTokenStream(const Token* toks,
                           unsigned int num_toks,
                           bool disable_macro_expansion,
-                          bool owns_tokens);
+                          bool owns_tokens,
+                          unsigned long repeat = 1);
+
+    /// Add a "macro" context to the top of the include stack that returns
+    /// 'passes' passes of tokens from the specified pass source (see
+    /// TokenPassSource), which it takes ownership of.  Unlike a repeated
+    /// token stream, the tokens may differ from pass to pass.
+    void EnterTokenStream(std::auto_ptr<TokenPassSource> source,
+                          unsigned long passes,
+                          bool disable_macro_expansion);
 
     /// Pop the current lexer/macro exp off the top of the
     /// lexer stack.  This should only be used in situations where the current
     /// state of the top-of-stack lexer is known.
     void RemoveTopOfLexerStack();
 
+    /// Return true if the include stack is too deep to enter another
+    /// include file or token stream (e.g. due to infinite recursion).
+    bool isIncludeStackFull() const
+    {
+        return m_include_macro_stack.size() >= MaxAllowedIncludeStackDepth-1;
+    }
+
     /// From the point that this method is called, and until
     /// CommitBacktrackedTokens() or Backtrack() is called, the Preprocessor
     /// keeps track of the lexed tokens so that a subsequent Backtrack() call
@@ -324,7 +344,7 @@ protected:
     
     enum
     {
-        /// Maximum depth of includes.
+        /// Maximum depth of includes and token streams.
         MaxAllowedIncludeStackDepth = 200
     };
 
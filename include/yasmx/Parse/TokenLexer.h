@@ -30,6 +30,8 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 //
+#include <memory>
+
 #include "yasmx/Basic/SourceLocation.h"
 #include "yasmx/Config/export.h"
 
@@ -43,6 +45,25 @@ class MacroInfo;
 class Preprocessor;
 class Token;
 
+/// Provides the tokens for each pass of a repeated token stream whose
+/// passes differ, such as a body with a different value substituted on
+/// each pass.  Only the tokens of the current pass need to be kept.
+class YASM_LIB_EXPORT TokenPassSource
+{
+public:
+    virtual ~TokenPassSource();
+
+    /// Get the tokens for a pass.  The tokens must stay valid until the
+    /// next call or until the source is destroyed.
+    /// @param pass         pass number (passes are requested in order,
+    ///                     starting from 0)
+    /// @param toks         first token (output)
+    /// @param num_toks     number of tokens (output); may be 0
+    virtual void getPass(unsigned long pass,
+                         const Token** toks,
+                         unsigned* num_toks) = 0;
+};
+
 /// TokenLexer - This implements a lexer that returns token from a macro body
 /// or token stream instead of lexing from a character buffer.  This is used for
 /// macro expansion, for example.
@@ -77,6 +98,17 @@ class YASM_LIB_EXPORT TokenLexer
     /// This is the next token that Lex will return.
     unsigned m_cur_token;
 
+    /// Number of times the token stream remains to be replayed after the
+    /// current pass (used for repeated token streams such as .rept).
+    unsigned long m_repeat;
+
+    /// If non-null, provides the tokens for each pass instead of replaying
+    /// the same tokens.  Owned by the TokenLexer.
+    TokenPassSource* m_source;
+
+    /// Current pass number of m_source.
+    unsigned long m_pass;
+
     /// The source location range where this macro was instantiated.
     SourceLocation m_instantiate_loc_start, m_instantiate_loc_end;
 
@@ -118,12 +150,26 @@ public:
 #endif
     /// Create a TokenLexer for the specified token stream.  If 'OwnsTokens' is
     /// specified, this takes ownership of the tokens and delete[]'s them when
-    /// the token lexer is empty.
+    /// the token lexer is empty.  The stream is returned 'repeat' times in
+    /// succession.
     TokenLexer(const Token* tok_array, unsigned num_toks,
-               bool disable_expansion, bool owns_tokens, Preprocessor& pp)
-        : /*m_macro(0), m_actual_args(0),*/ m_pp(pp), m_owns_tokens(false)
+               bool disable_expansion, bool owns_tokens, Preprocessor& pp,
+               unsigned long repeat = 1)
+        : /*m_macro(0), m_actual_args(0),*/ m_pp(pp), m_source(0)
+        , m_owns_tokens(false)
     {
-        Init(tok_array, num_toks, disable_expansion, owns_tokens);
+        Init(tok_array, num_toks, disable_expansion, owns_tokens, repeat);
+    }
+
+    /// Create a TokenLexer that returns 'passes' passes of tokens from
+    /// the specified pass source.
+    TokenLexer(std::auto_ptr<TokenPassSource> source,
+               unsigned long passes,
+               bool disable_expansion,
+               Preprocessor& pp)
+        : m_pp(pp), m_source(0), m_owns_tokens(false)
+    {
+        Init(source, passes, disable_expansion);
     }
 
     /// Initialize this TokenLexer with the specified token stream.
@@ -131,8 +177,19 @@ public:
     ///
     /// DisableExpansion is true when macro expansion of tokens lexed from this
     /// stream should be disabled.
+    ///
+    /// Repeat is the number of times the token stream should be returned;
+    /// the tokens are replayed in place rather than copied.  A repeat count
+    /// of 0 results in an empty stream.
     void Init(const Token* tok_array, unsigned num_toks,
-              bool disable_macro_expansion, bool owns_tokens);
+              bool disable_macro_expansion, bool owns_tokens,
+              unsigned long repeat = 1);
+
+    /// Initialize this TokenLexer to return 'passes' passes of tokens from
+    /// the specified pass source, which it takes ownership of.
+    void Init(std::auto_ptr<TokenPassSource> source,
+              unsigned long passes,
+              bool disable_macro_expansion);
 
     ~TokenLexer() { destroy(); }
 
@@ -147,11 +204,14 @@ public:
 private:
     void destroy();
 
+    /// Set the lexical properties the first token of a pass takes on.
+    void setFirstTokenFlags();
+
     /// Return true if the next lex call will pop this macro off the
     /// include stack.
     bool isAtEnd() const
     {
-        return m_cur_token == m_num_tokens;
+        return m_cur_token == m_num_tokens && m_repeat == 0;
     }
 
 #if 0
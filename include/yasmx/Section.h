@@ -106,6 +106,9 @@ public:
     /// @param reloc        relocation
     void AddReloc(std::auto_ptr<Reloc> reloc);
 
+    /// Delete all relocations of a section.
+    void ClearRelocs();
+
     typedef stdx::ptr_vector<Reloc> Relocs;
     typedef Relocs::iterator reloc_iterator;
     typedef Relocs::const_iterator const_reloc_iterator;
@@ -0,0 +1,154 @@
+#ifndef YASM_SECTIONRENDERER_H
+#define YASM_SECTIONRENDERER_H
+///
+/// @file
+/// @brief Concurrent section rendering interface.
+///
+/// @license
+///  Copyright (C) 2010  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+/// @endlicense
+///
+#include <vector>
+
+#include "llvm/System/DataTypes.h"
+#include "yasmx/Config/export.h"
+#include "yasmx/Support/scoped_ptr.h"
+
+
+namespace llvm { class raw_ostream; }
+
+namespace yasm
+{
+
+class Diagnostic;
+class Object;
+class Section;
+
+/// Renders the contents (bytes and relocations) of the sections of an
+/// object, using multiple threads when the platform supports them.  Once
+/// Optimize() has finished the sections are independent, so they can be
+/// rendered concurrently.
+///
+/// An object format whose file layout depends on relocations or final
+/// section sizes first calls Prepare(), which renders every section
+/// without keeping its contents.  Section contents are then written in
+/// order with Output() between Start() and Finish().  With a single
+/// thread, Output() renders each section straight into the output stream.
+/// Otherwise worker threads render sections ahead of the writer into
+/// memory buffers; each worker holds a bounded amount of unwritten
+/// contents, and sections too large for that are rendered by the writer.
+///
+/// Diagnostics are reported exactly as if the sections had been rendered
+/// one at a time, in order: a section that reports any diagnostic while
+/// being rendered on a worker thread has its output discarded and is
+/// rendered again on the calling thread.
+class YASM_LIB_EXPORT SectionRenderer
+{
+public:
+    /// Constructor.  The sections of the object must not change during
+    /// the lifetime of the renderer.
+    /// @param object       object
+    /// @param diags        diagnostic reporting
+    SectionRenderer(Object& object, Diagnostic& diags);
+
+    /// Destructor.  Calls Finish().
+    virtual ~SectionRenderer();
+
+    /// Render all sections of the object, discarding their contents.
+    /// Afterwards the relocations and sizes of all sections are final.
+    /// @param nthreads     maximum number of threads to use; 0 uses one
+    ///                     per processor
+    void Prepare(unsigned int nthreads = 0);
+
+    /// Start output of section contents.
+    /// @param nthreads     maximum number of threads to use (including the
+    ///                     calling thread); 0 uses one per processor
+    void Start(unsigned int nthreads = 0);
+
+    /// Render the contents of a section into an output stream.  Sections
+    /// must be output in increasing order; sections that are skipped are
+    /// not output.  After Prepare(), diagnostics have already been
+    /// reported and are not reported again.
+    /// @param n            section number (in object order)
+    /// @param os           output stream
+    void Output(unsigned int n, llvm::raw_ostream& os);
+
+    /// Finish output, stopping any worker threads.  Until this is called,
+    /// sections that have not been output may still be rendered (and
+    /// their relocations regenerated) by worker threads.
+    void Finish();
+
+protected:
+    /// Render a section.  Called concurrently for different sections, so
+    /// implementations must only modify state belonging to the section,
+    /// and must report diagnostics only through the provided diags (which
+    /// is not necessarily the object's).  A section may be rendered more
+    /// than once; its relocations are cleared before each attempt.
+    /// @param sect         section
+    /// @param os           output stream for section contents
+    /// @param diags        diagnostic reporting
+    virtual void RenderSection(Section& sect,
+                               llvm::raw_ostream& os,
+                               Diagnostic& diags) = 0;
+
+    /// Determine if sections are being rendered by Prepare().
+    /// @return True if the rendered contents will be discarded.
+    bool isPreparing() const { return m_preparing; }
+
+private:
+    SectionRenderer(const SectionRenderer&);                  // not implemented
+    const SectionRenderer& operator=(const SectionRenderer&); // not implemented
+
+    class Worker;
+    friend class Worker;
+    class PrepareWorker;
+    friend class PrepareWorker;
+    class Pipeline;
+    friend class Pipeline;
+
+    /// Get the number of threads to render with.
+    /// @param nthreads     requested number of threads; 0 for one per
+    ///                     processor
+    unsigned int getThreadCount(unsigned int nthreads) const;
+
+    /// Render section n.
+    void DoRender(unsigned int n, llvm::raw_ostream& os, Diagnostic& diags);
+
+    /// Render section n on the calling thread for output.
+    void DoOutput(unsigned int n, llvm::raw_ostream& os);
+
+    Diagnostic& m_diags;
+    std::vector<Section*> m_sects;      ///< Sections in object order
+    uint64_t m_total;                   ///< Total size of section contents
+    bool m_preparing;                   ///< Inside Prepare()
+    bool m_prepared;                    ///< Prepare() has finished
+
+    /// Worker threads rendering ahead of Output(); NULL when rendering
+    /// on the calling thread.
+    util::scoped_ptr<Pipeline> m_pipeline;
+};
+
+} // namespace yasm
+
+#endif
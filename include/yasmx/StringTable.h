@@ -31,6 +31,7 @@
 ///
 #include <vector>
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
 
@@ -42,6 +43,11 @@ namespace yasm
 
 /// A string table of 0-terminated strings.  Always begins with a 0-length
 /// string (a single 0 byte) at offset 0.
+///
+/// In merging mode, each distinct string is stored only once.  In addition,
+/// strings registered with Add() before Finalize() is called are laid out
+/// so that a string which is the tail of another (e.g. ".text" and
+/// ".rela.text") shares the longer string's storage.
 class YASM_LIB_EXPORT StringTable
 {
 public:
@@ -49,7 +55,8 @@ public:
     /// @param first_index  Indexes will be returned and interpreted
     ///                     as if the first string starts at this offset.
     ///                     Defaults to 0.
-    explicit StringTable(unsigned long first_index=0);
+    /// @param merge        Enable merging mode.  Defaults to false.
+    explicit StringTable(unsigned long first_index=0, bool merge=false);
 
     /// Construct from iterator.
     template <typename InputIterator>
@@ -58,6 +65,7 @@ public:
                 unsigned long first_index=0)
         : m_storage(first, last)
         , m_first_index(first_index)
+        , m_merge(false)
     {}
 
     /// Destructor.
@@ -69,6 +77,15 @@ public:
     /// @return String index.
     unsigned long getIndex(llvm::StringRef str);
 
+    /// Register a string to be laid out by Finalize().  Only has an effect
+    /// in merging mode; the index is obtained afterwards with getIndex().
+    /// @param str      String
+    void Add(llvm::StringRef str);
+
+    /// Lay out all strings registered with Add() since the last call,
+    /// merging strings that are tails of other strings.
+    void Finalize();
+
     /// Get the string corresponding to a particular index.  Due to legal use
     /// of substrings, no error checking is performed except for trying to read
     /// past the end of the string table.
@@ -94,6 +111,13 @@ public:
 private:
     std::vector<char> m_storage;
     unsigned long m_first_index;
+
+    /// Merging mode enabled?
+    bool m_merge;
+
+    /// Index of each string in merging mode.  Strings registered with Add()
+    /// but not yet laid out by Finalize() map to a placeholder.
+    llvm::StringMap<unsigned long> m_index;
 };
 
 } // namespace yasm
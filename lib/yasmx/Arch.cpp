@@ -53,6 +53,12 @@ Arch::AddDirectives(Directives& dirs, llvm::StringRef parser)
 {
 }
 
+bool
+Arch::setTune(llvm::StringRef tune)
+{
+    return false;
+}
+
 bool
 Arch::hasParseInsn() const
 {
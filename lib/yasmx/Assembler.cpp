@@ -122,6 +122,19 @@ Assembler::setMachine(llvm::StringRef machine, Diagnostic& diags)
     return true;
 }
 
+bool
+Assembler::setTune(llvm::StringRef tune, Diagnostic& diags)
+{
+    if (!m_arch->setTune(tune))
+    {
+        diags.Report(SourceLocation(), diag::fatal_module_combo)
+            << "tuning" << tune
+            << "architecture" << m_arch_module->getKeyword();
+        return false;
+    }
+    return true;
+}
+
 bool
 Assembler::setParser(llvm::StringRef parser_keyword, Diagnostic& diags)
 {
@@ -51,6 +51,40 @@ STATISTIC(tail_output, "Total number of tail bytes output");
 
 using namespace yasm;
 
+namespace {
+/// Captures the tail output of a bytecode into a byte buffer.
+class TailCapture : public BytecodeOutput
+{
+public:
+    TailCapture(Bytes& bytes, Diagnostic& diags)
+        : BytecodeOutput(diags), m_bytes(bytes)
+    {}
+    ~TailCapture() {}
+
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out)
+    {
+        assert(false && "cannot capture values in tail");
+        return false;
+    }
+
+protected:
+    void DoOutputGap(uint64_t size, SourceLocation source)
+    {
+        assert(false && "cannot capture gaps in tail");
+    }
+
+    void DoOutputBytes(const Bytes& bytes, SourceLocation source)
+    {
+        m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+    }
+
+private:
+    Bytes& m_bytes;
+};
+} // anonymous namespace
+
 Bytecode::Contents::Contents()
 {
 }
@@ -61,13 +95,13 @@ Bytecode::Contents::~Contents()
 
 bool
 Bytecode::Contents::Expand(Bytecode& bc,
-                           unsigned long* len,
+                           uint64_t* len,
                            int span,
-                           long old_val,
-                           long new_val,
+                           int64_t old_val,
+                           int64_t new_val,
                            bool* keep,
-                           /*@out@*/ long* neg_thres,
-                           /*@out@*/ long* pos_thres,
+                           /*@out@*/ int64_t* neg_thres,
+                           /*@out@*/ int64_t* pos_thres,
                            Diagnostic& diags)
 {
     assert(false && "bytecode does not have any dependent spans");
@@ -96,6 +130,7 @@ Bytecode::Bytecode(std::auto_ptr<Contents> contents, SourceLocation source)
       m_len(0),
       m_source(source),
       m_offset(0),
+      m_fused_host(0),
       m_index(~0UL)
 {
 }
@@ -105,6 +140,7 @@ Bytecode::Bytecode()
       m_container(0),
       m_len(0),
       m_offset(0),
+      m_fused_host(0),
       m_index(~0UL)
 {
 }
@@ -115,6 +151,7 @@ Bytecode::Bytecode(const Bytecode& oth)
       m_len(oth.m_len),
       m_source(oth.m_source),
       m_offset(oth.m_offset),
+      m_fused_host(oth.m_fused_host),
       m_index(oth.m_index)
 {}
 
@@ -132,6 +169,7 @@ Bytecode::swap(Bytecode& oth)
     std::swap(m_len, oth.m_len);
     std::swap(m_source, oth.m_source);
     std::swap(m_offset, oth.m_offset);
+    std::swap(m_fused_host, oth.m_fused_host);
     std::swap(m_index, oth.m_index);
 }
 
@@ -176,7 +214,7 @@ Bytecode::CalcLen(const AddSpanFunc& add_span, Diagnostic& diags)
         m_len = 0;
         return true;
     }
-    unsigned long len;
+    uint64_t len;
     if (!m_contents->CalcLen(*this, &len, add_span, diags))
         return false;
     m_len = len;
@@ -185,16 +223,16 @@ Bytecode::CalcLen(const AddSpanFunc& add_span, Diagnostic& diags)
 
 bool
 Bytecode::Expand(int span,
-                 long old_val,
-                 long new_val,
+                 int64_t old_val,
+                 int64_t new_val,
                  bool* keep,
-                 /*@out@*/ long* neg_thres,
-                 /*@out@*/ long* pos_thres,
+                 /*@out@*/ int64_t* neg_thres,
+                 /*@out@*/ int64_t* pos_thres,
                  Diagnostic& diags)
 {
     if (m_contents.get() == 0)
         return true;
-    unsigned long len = m_len;
+    uint64_t len = m_len;
     if (!m_contents->Expand(*this, &len, span, old_val, new_val, keep,
                             neg_thres, pos_thres, diags))
         return false;
@@ -205,7 +243,7 @@ Bytecode::Expand(int span,
 bool
 Bytecode::Output(BytecodeOutput& bc_out)
 {
-    unsigned long start = bc_out.getNumOutput();
+    uint64_t start = bc_out.getNumOutput();
 
     // make a copy of fixed portion
     Bytes& fixed = bc_out.m_bc_scratch;
@@ -264,17 +302,62 @@ Bytecode::Output(BytecodeOutput& bc_out)
     return true;
 }
 
-unsigned long
-Bytecode::UpdateOffset(unsigned long offset, Diagnostic& diags)
+bool
+Bytecode::ConvertTailToFixed(Diagnostic& diags)
+{
+    if (m_contents.get() == 0)
+        return true;
+
+    Bytes tail;
+    TailCapture capture(tail, diags);
+    if (!m_contents->Output(*this, capture))
+        return false;
+    assert(tail.size() == m_len && "tail output length mismatch");
+
+    m_fixed.insert(m_fixed.end(), tail.begin(), tail.end());
+    m_contents.reset(0);
+    m_len = 0;
+    return true;
+}
+
+void
+Bytecode::Fuse(Bytecode& oth)
+{
+    assert(m_contents.get() == 0 && oth.m_contents.get() == 0 &&
+           "cannot fuse bytecodes with tail contents");
+    assert(m_fused_host == 0 && oth.m_fused_host == 0 &&
+           "bytecode already fused");
+
+    unsigned int delta = static_cast<unsigned int>(m_fixed.size());
+    m_fixed.insert(m_fixed.end(), oth.m_fixed.begin(), oth.m_fixed.end());
+    m_fixed_fixups.reserve(m_fixed_fixups.size() + oth.m_fixed_fixups.size());
+    for (std::vector<Fixup>::iterator i=oth.m_fixed_fixups.begin(),
+         end=oth.m_fixed_fixups.end(); i != end; ++i)
+    {
+        m_fixed_fixups.push_back(*i);
+        m_fixed_fixups.back().setOffset(i->getOffset() + delta);
+    }
+
+    // Release the other bytecode's storage; only its identity, position and
+    // length are kept.
+    oth.m_len = oth.m_fixed.size();
+    Bytes().swap(oth.m_fixed);
+    std::vector<Fixup>().swap(oth.m_fixed_fixups);
+    oth.m_fused_host = this;
+    oth.m_offset = delta;
+}
+
+uint64_t
+Bytecode::UpdateOffset(uint64_t offset, Diagnostic& diags)
 {
     if (m_contents.get() != 0 &&
         m_contents->getSpecial() == Contents::SPECIAL_OFFSET)
     {
         // Recalculate/adjust len of offset-based bytecodes here
         bool keep = false;
-        long neg_thres = 0;
-        long pos_thres = static_cast<long>(getNextOffset());
-        Expand(1, 0, static_cast<long>(offset+getFixedLen()), &keep,
+        int64_t neg_thres = 0;
+        int64_t pos_thres = static_cast<int64_t>(getNextOffset());
+        Expand(1, 0, static_cast<int64_t>(offset+getFixedLen()), &keep,
                &neg_thres, &pos_thres, diags);
     }
     m_offset = offset;
@@ -315,12 +398,12 @@ pugi::xml_node
 Bytecode::Write(pugi::xml_node out) const
 {
     pugi::xml_node root = out.append_child("Bytecode");
-    if (m_index != ~0UL)
-        root.append_attribute("index") = m_index;
+    if (getIndex() != ~0UL)
+        root.append_attribute("index") = getIndex();
     root.append_attribute("id") =
         llvm::Twine::utohexstr((uint64_t)this).str().c_str();
     root.append_attribute("source") = m_source.getRawEncoding();
-    root.append_attribute("offset") = m_offset;
+    root.append_attribute("offset") = getOffset();
 
     if (!m_fixed.empty())
         append_child(root, "Fixed", m_fixed);
@@ -26,6 +26,9 @@
 //
 #include "yasmx/BytecodeContainer.h"
 
+#define DEBUG_TYPE "BytecodeContainer"
+
+#include "llvm/ADT/Statistic.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/BytecodeOutput.h"
 #include "yasmx/Bytecode.h"
@@ -33,13 +36,15 @@
 #include "yasmx/Optimizer.h"
 
 
+STATISTIC(num_fused, "Number of bytecodes fused into a preceding bytecode");
+
 using namespace yasm;
 
 namespace {
 class GapBytecode : public Bytecode::Contents
 {
 public:
-    GapBytecode(unsigned long size);
+    GapBytecode(uint64_t size);
     ~GapBytecode();
 
     /// Finalizes the bytecode after parsing.
@@ -47,7 +52,7 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
@@ -56,7 +61,7 @@ public:
 
     /// Increase the gap size.
     /// @param size     size in bytes
-    void Extend(unsigned long size);
+    void Extend(uint64_t size);
 
     llvm::StringRef getType() const;
 
@@ -68,11 +73,11 @@ public:
 #endif // WITH_XML
 
 private:
-    unsigned long m_size;       ///< size of gap (in bytes)
+    uint64_t m_size;            ///< size of gap (in bytes)
 };
 } // anonymous namespace
 
-GapBytecode::GapBytecode(unsigned long size)
+GapBytecode::GapBytecode(uint64_t size)
     : m_size(size)
 {
 }
@@ -89,7 +94,7 @@ GapBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 GapBytecode::CalcLen(Bytecode& bc,
-                     /*@out@*/ unsigned long* len,
+                     /*@out@*/ uint64_t* len,
                      const Bytecode::AddSpanFunc& add_span,
                      Diagnostic& diags)
 {
@@ -117,7 +122,7 @@ GapBytecode::clone() const
 }
 
 void
-GapBytecode::Extend(unsigned long size)
+GapBytecode::Extend(uint64_t size)
 {
     m_size += size;
 }
@@ -135,6 +140,7 @@ GapBytecode::Write(pugi::xml_node out) const
 BytecodeContainer::BytecodeContainer(Section* sect)
     : m_sect(sect),
       m_bcs_owner(m_bcs),
+      m_fused_owner(m_fused),
       m_last_gap(false)
 {
     // A container always has at least one bytecode.
@@ -157,7 +163,7 @@ BytecodeContainer::AppendBytecode(std::auto_ptr<Bytecode> bc)
 }
 
 Bytecode&
-BytecodeContainer::AppendGap(unsigned long size, SourceLocation source)
+BytecodeContainer::AppendGap(uint64_t size, SourceLocation source)
 {
     if (m_last_gap)
     {
@@ -205,10 +211,45 @@ BytecodeContainer::Finalize(Diagnostic& diags)
         bc->Finalize(diags);
 }
 
+void
+BytecodeContainer::FuseBytecodes()
+{
+    stdx::ptr_vector<Bytecode> kept;
+    kept.reserve(m_bcs.size());
+
+    // The first (empty) bytecode is always kept as-is.
+    bc_iterator bc = m_bcs.begin(), end = m_bcs.end();
+    kept.push_back(&(*bc));
+    ++bc;
+
+    Bytecode* host = 0;
+    for (; bc != end; ++bc)
+    {
+        if (bc->hasContents())
+        {
+            kept.push_back(&(*bc));
+            host = 0;
+        }
+        else if (host == 0)
+        {
+            kept.push_back(&(*bc));
+            host = &(*bc);
+        }
+        else
+        {
+            host->Fuse(*bc);
+            m_fused.push_back(&(*bc));
+            ++num_fused;
+        }
+    }
+
+    m_bcs.swap(kept);
+}
+
 void
 BytecodeContainer::UpdateOffsets(Diagnostic& diags)
 {
-    unsigned long offset = 0;
+    uint64_t offset = 0;
     m_bcs.front().setOffset(0);
     for (bc_iterator bc=m_bcs.begin(), end=m_bcs.end(); bc != end; ++bc)
         offset = bc->UpdateOffset(offset, diags);
@@ -221,29 +262,7 @@ BytecodeContainer::Optimize(Diagnostic& diags)
 
     // Step 1a
     unsigned long bc_index = 0;
-    unsigned long offset = 0;
-
-    // Set the offset of the first (empty) bytecode.
-    m_bcs.front().setIndex(bc_index++);
-    m_bcs.front().setOffset(0);
-
-    // Iterate through the remainder, if any.
-    for (bc_iterator bc=m_bcs.begin(), bcend=m_bcs.end(); bc != bcend; ++bc)
-    {
-        bc->setIndex(bc_index++);
-        bc->setOffset(offset);
-
-        if (bc->CalcLen(TR1::bind(&Optimizer::AddSpan, &opt,
-                                  _1, _2, _3, _4, _5),
-                        diags))
-        {
-            if (bc->getSpecial() == Bytecode::Contents::SPECIAL_OFFSET)
-                opt.AddOffsetSetter(*bc);
-
-            offset = bc->getNextOffset();
-        }
-    }
-
+    opt.Step1a(*this, &bc_index);
     if (diags.hasErrorOccurred())
         return;
 
@@ -55,6 +55,24 @@ BytecodeOutput::ConvertSymbolToBytes(SymbolRef sym,
     return true;
 }
 
+void
+BytecodeOutput::DoOutputBuffer(const unsigned char* data,
+                               uint64_t size,
+                               SourceLocation source)
+{
+    static const uint64_t BLOCK_SIZE = 65536;
+
+    Bytes bytes;
+    while (size > 0)
+    {
+        uint64_t chunk = size > BLOCK_SIZE ? BLOCK_SIZE : size;
+        bytes.assign(data, data+chunk);
+        DoOutputBytes(bytes, source);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
 BytecodeNoOutput::~BytecodeNoOutput()
 {
 }
@@ -75,7 +93,7 @@ BytecodeNoOutput::ConvertValueToBytes(Value& value,
 }
 
 void
-BytecodeNoOutput::DoOutputGap(unsigned long size, SourceLocation source)
+BytecodeNoOutput::DoOutputGap(uint64_t size, SourceLocation source)
 {
     // expected
 }
@@ -88,15 +106,25 @@ BytecodeNoOutput::DoOutputBytes(const Bytes& bytes, SourceLocation source)
     Diag(source, diag::warn_nobits_data);
 }
 
+void
+BytecodeNoOutput::DoOutputBuffer(const unsigned char* data,
+                                 uint64_t size,
+                                 SourceLocation source)
+{
+    if (size == 0)
+        return;
+    Diag(source, diag::warn_nobits_data);
+}
+
 BytecodeStreamOutput::~BytecodeStreamOutput()
 {
 }
 
 void
-BytecodeStreamOutput::DoOutputGap(unsigned long size, SourceLocation source)
+BytecodeStreamOutput::DoOutputGap(uint64_t size, SourceLocation source)
 {
     // Warn that gaps are converted to 0 and write out the 0's.
-    static const unsigned long BLOCK_SIZE = 4096;
+    static const uint64_t BLOCK_SIZE = 4096;
 
     if (size == 0)
         return;
@@ -121,3 +149,13 @@ BytecodeStreamOutput::DoOutputBytes(const Bytes& bytes, SourceLocation source)
     // Output bytes to file
     m_os << bytes;
 }
+
+void
+BytecodeStreamOutput::DoOutputBuffer(const unsigned char* data,
+                                     uint64_t size,
+                                     SourceLocation source)
+{
+    // Write straight from the caller's buffer; no staging copy
+    m_os.write(reinterpret_cast<const char*>(data),
+               static_cast<size_t>(size));
+}
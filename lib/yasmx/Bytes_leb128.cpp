@@ -34,8 +34,6 @@
 
 using namespace yasm;
 
-static llvm::APInt staticbv(IntNum::BITVECT_NATIVE_SIZE, 0);
-
 static inline uint64_t
 Extract(const llvm::APInt& bv, unsigned int width, unsigned int lsb)
 {
@@ -54,7 +52,29 @@ yasm::WriteLEB128(Bytes& bytes, const IntNum& intn, bool sign)
         return 1;
     }
 
-    const llvm::APInt* bv = intn.getBV(&staticbv);
+    // Values that fit in a long are encoded directly.
+    if (intn.isInt() && (sign || intn.getSign() > 0))
+    {
+        long v = intn.getInt();
+        Bytes::size_type orig_size = bytes.size();
+        for (;;)
+        {
+            unsigned char byte = static_cast<unsigned char>(v & 0x7f);
+            v >>= 7;
+            if (sign ? ((v == 0 && (byte & 0x40) == 0) ||
+                        (v == -1 && (byte & 0x40) != 0))
+                     : v == 0)
+            {
+                bytes.push_back(byte);
+                break;
+            }
+            bytes.push_back(byte | 0x80);
+        }
+        return static_cast<unsigned long>(bytes.size()-orig_size);
+    }
+
+    llvm::APInt localbv(IntNum::BITVECT_NATIVE_SIZE, 0);
+    const llvm::APInt* bv = intn.getBV(&localbv);
     int size;
     if (sign)
         size = bv->getMinSignedBits();
@@ -77,7 +97,24 @@ yasm::SizeLEB128(const IntNum& intn, bool sign)
     if (intn.isZero())
         return 1;
 
-    const llvm::APInt* bv = intn.getBV(&staticbv);
+    // Values that fit in a long are sized directly.
+    if (intn.isInt() && (sign || intn.getSign() > 0))
+    {
+        long v = intn.getInt();
+        unsigned long size = 1;
+        for (;;)
+        {
+            bool signbit = (v & 0x40) != 0;
+            v >>= 7;
+            if (sign ? ((v == 0 && !signbit) || (v == -1 && signbit))
+                     : v == 0)
+                return size;
+            ++size;
+        }
+    }
+
+    llvm::APInt localbv(IntNum::BITVECT_NATIVE_SIZE, 0);
+    const llvm::APInt* bv = intn.getBV(&localbv);
     if (sign)
         return (bv->getMinSignedBits()+6)/7;
     else
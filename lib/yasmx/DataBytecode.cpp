@@ -58,20 +58,62 @@ yasm::AppendByte(BytecodeContainer& container,
     bc.AppendFixed(1, expr, source);
 }
 
-void
-yasm::AppendData(BytecodeContainer& container,
-                 const IntNum& val,
-                 unsigned int size,
-                 const Arch& arch)
+/// Write an integer data value of the given size and endianness to the
+/// end of a fixed buffer.
+static void
+WriteData(Bytes& fixed, const IntNum& val, unsigned int size,
+          EndianState endian)
 {
-    Bytecode& bc = container.FreshBytecode();
+    // Native-sized values are stored byte by byte without a temporary
+    // buffer; this is the common case for long constant data lists.
+    if (size <= sizeof(long) && val.isInt())
+    {
+        unsigned long v = static_cast<unsigned long>(val.getInt());
+        Bytes::size_type off = fixed.size();
+        fixed.resize(off+size);
+        if (endian.isBigEndian())
+        {
+            for (unsigned int i=size; i>0; --i, v >>= 8)
+                fixed[off+i-1] = static_cast<unsigned char>(v & 0xFF);
+        }
+        else
+        {
+            for (unsigned int i=0; i<size; ++i, v >>= 8)
+                fixed[off+i] = static_cast<unsigned char>(v & 0xFF);
+        }
+        return;
+    }
+
     Bytes zero;
     zero.resize(size);
-    arch.setEndian(zero);
+    zero.setEndian(endian);
     NumericOutput numout(zero);
     numout.setSize(size*8);
     numout.OutputInteger(val);
-    bc.getFixed().insert(bc.getFixed().end(), zero.begin(), zero.end());
+    fixed.insert(fixed.end(), zero.begin(), zero.end());
+}
+
+/// Get the data endianness of an architecture.
+static EndianState
+getEndian(const Arch& arch, Bytes& fixed)
+{
+    // Arch only knows how to set the endianness of a Bytes, so borrow
+    // the fixed buffer for a moment rather than allocating one.
+    EndianState orig = fixed;
+    arch.setEndian(fixed);
+    EndianState endian = fixed;
+    fixed.setEndian(orig);
+    return endian;
+}
+
+void
+yasm::AppendData(BytecodeContainer& container,
+                 const IntNum& val,
+                 unsigned int size,
+                 const Arch& arch)
+{
+    Bytes& fixed = container.FreshBytecode().getFixed();
+    WriteData(fixed, val, size, getEndian(arch, fixed));
 }
 
 void
@@ -80,14 +122,7 @@ yasm::AppendData(BytecodeContainer& container,
                  unsigned int size,
                  EndianState endian)
 {
-    Bytecode& bc = container.FreshBytecode();
-    Bytes zero;
-    zero.resize(size);
-    zero.setEndian(endian);
-    NumericOutput numout(zero);
-    numout.setSize(size*8);
-    numout.OutputInteger(val);
-    bc.getFixed().insert(bc.getFixed().end(), zero.begin(), zero.end());
+    WriteData(container.FreshBytecode().getFixed(), val, size, endian);
 }
 
 void
@@ -108,6 +143,26 @@ yasm::AppendData(BytecodeContainer& container,
     bc.AppendFixed(size, expr, source);
 }
 
+void
+yasm::AppendData(BytecodeContainer& container,
+                 Expr& expr,
+                 unsigned int size,
+                 const Arch& arch,
+                 SourceLocation source,
+                 Diagnostic& diags)
+{
+    expr.Simplify(diags);
+    if (expr.isIntNum())
+    {
+        AppendData(container, expr.getIntNum(), size, arch);
+        return;
+    }
+    std::auto_ptr<Expr> e(new Expr);
+    e->swap(expr);
+    Bytecode& bc = container.FreshBytecode();
+    bc.AppendFixed(size, e, source);
+}
+
 void
 yasm::AppendData(BytecodeContainer& container,
                  llvm::StringRef str,
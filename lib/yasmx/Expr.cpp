@@ -778,6 +778,34 @@ again:
         root.Zero();    // If operator has no children, replace it with a zero.
 }
 
+void
+Expr::CalcFold(Op::Op op, SourceLocation source)
+{
+    if (op < Op::NONNUM && isIntNum() && isUnary(op))
+    {
+        m_terms.front().getIntNum()->CalcAssert(op);
+        return;
+    }
+    Calc(op, source);
+}
+
+void
+Expr::CalcFold(Op::Op op, const Expr& rhs, SourceLocation source)
+{
+    if (op < Op::NONNUM && !isUnary(op) && isIntNum() && rhs.isIntNum())
+    {
+        const IntNum* rhs_intn = rhs.m_terms.front().getIntNum();
+        bool is_div = (op == Op::DIV || op == Op::SIGNDIV ||
+                       op == Op::MOD || op == Op::SIGNMOD);
+        if (!is_div || !rhs_intn->isZero())
+        {
+            m_terms.front().getIntNum()->CalcAssert(op, *rhs_intn);
+            return;
+        }
+    }
+    Calc(op, rhs, source);
+}
+
 void
 Expr::Simplify(Diagnostic& diags, bool simplify_reg_mul)
 {
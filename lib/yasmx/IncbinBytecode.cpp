@@ -53,7 +53,7 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
@@ -118,7 +118,11 @@ IncbinBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
             diags.Report(bc.getSource(), diag::err_incbin_start_not_absolute);
             return false;
         }
-        m_start.reset(val.getAbs()->clone());
+        // A zero start is simplified away entirely
+        if (val.hasAbs())
+            m_start.reset(val.getAbs()->clone());
+        else
+            m_start.reset(0);
     }
 
     if (m_maxlen)
@@ -131,24 +135,27 @@ IncbinBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
             diags.Report(bc.getSource(), diag::err_incbin_maxlen_not_absolute);
             return false;
         }
-        m_maxlen.reset(val.getAbs()->clone());
+        if (val.hasAbs())
+            m_maxlen.reset(val.getAbs()->clone());
+        else
+            m_maxlen.reset(new Expr(0));
     }
     return true;
 }
 
 bool
 IncbinBytecode::CalcLen(Bytecode& bc,
-                        /*@out@*/ unsigned long* len,
+                        /*@out@*/ uint64_t* len,
                         const Bytecode::AddSpanFunc& add_span,
                         Diagnostic& diags)
 {
-    unsigned long start = 0, maxlen = 0xFFFFFFFFUL;
+    uint64_t start = 0, maxlen = 0;
 
     // Try to convert start to integer value
     if (m_start)
     {
         if (m_start->isIntNum())
-            start = m_start->getIntNum().getUInt();
+            start = m_start->getIntNum().getUInt64();
         else
         {
             // FIXME
@@ -161,7 +168,7 @@ IncbinBytecode::CalcLen(Bytecode& bc,
     if (m_maxlen)
     {
         if (m_maxlen->isIntNum())
-            maxlen = m_maxlen->getIntNum().getUInt();
+            maxlen = m_maxlen->getIntNum().getUInt64();
         else
         {
             // FIXME
@@ -171,7 +178,7 @@ IncbinBytecode::CalcLen(Bytecode& bc,
     }
 
     // Compute length of incbin from start, maxlen, and len
-    unsigned long flen = m_buf->getBufferSize();
+    uint64_t flen = m_buf->getBufferSize();
     if (start > flen)
     {
         diags.Report(bc.getSource(), diag::warn_incbin_start_after_eof);
@@ -190,21 +197,20 @@ IncbinBytecode::CalcLen(Bytecode& bc,
 bool
 IncbinBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
 {
-    unsigned long start = 0;
+    uint64_t start = 0;
 
     // Convert start to integer value
     if (m_start)
     {
         assert(m_start->isIntNum()
                && "could not determine start in incbin::output");
-        start = m_start->getIntNum().getUInt();
+        start = m_start->getIntNum().getUInt64();
     }
 
-    // Copy len bytes
-    Bytes& bytes = bc_out.getScratch();
-    bytes.Write(reinterpret_cast<const unsigned char*>(m_buf->getBufferStart())
-                + start, bc.getTailLen());
-    bc_out.OutputBytes(bytes, bc.getSource());
+    // Output len bytes directly from the (possibly mmap'ed) file buffer
+    bc_out.OutputBuffer(
+        reinterpret_cast<const unsigned char*>(m_buf->getBufferStart()) + start,
+        bc.getTailLen(), bc.getSource());
     return true;
 }
 
@@ -218,8 +224,8 @@ IncbinBytecode*
 IncbinBytecode::clone() const
 {
     return new IncbinBytecode(m_filename,
-                              std::auto_ptr<Expr>(m_start->clone()),
-                              std::auto_ptr<Expr>(m_maxlen->clone()));
+        std::auto_ptr<Expr>(m_start ? m_start->clone() : 0),
+        std::auto_ptr<Expr>(m_maxlen ? m_maxlen->clone() : 0));
 }
 
 #ifdef WITH_XML
@@ -35,6 +35,7 @@
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Mutex.h"
 #include "yasmx/Basic/Diagnostic.h"
 
 
@@ -52,6 +53,11 @@ static llvm::APInt op2static(IntNum::BITVECT_NATIVE_SIZE, 0);
 /// Static bitvect used for sign extension.
 static llvm::APInt signext_bv(IntNum::BITVECT_NATIVE_SIZE, 0);
 
+/// Guards the static bitvects above.  Only locks when running multithreaded
+/// (e.g. while sections are rendered concurrently); small values never
+/// touch the static bitvects and don't need it.
+static llvm::sys::SmartMutex<true> static_bv_lock;
+
 enum
 {
     SV_BITS = std::numeric_limits<IntNumData::SmallValue>::digits,
@@ -149,7 +155,6 @@ HexDigitValue(char ch)
     if (ch >= '0' && ch <= '9') return ch-'0';
     if (ch >= 'a' && ch <= 'f') return ch-'a'+10;
     if (ch >= 'A' && ch <= 'F') return ch-'A'+10;
-    if (ch == '_') return 0;
     return ~0;
 }
 
@@ -169,13 +174,14 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
     }
 
     // For radixes of power-of-two values, the bits required is accurately and
-    // easily computed.  For radix 10, we use a rough approximation.
+    // easily computed.  For radix 10, we use a rough approximation that
+    // rounds up (log2(10) < 10/3).
     switch (radix)
     {
-        case 2:     minbits += (len-minbits); break;
-        case 8:     minbits += (len-minbits) * 3; break;
-        case 16:    minbits += (len-minbits) * 4; break;
-        case 10:    minbits += ((len-minbits) * 64) / 22; break;
+        case 2:     minbits += len; break;
+        case 8:     minbits += len * 3; break;
+        case 16:    minbits += len * 4; break;
+        case 10:    minbits += (len * 10 + 2) / 3; break;
         default:
         {
             unsigned int max_bits_per_digit = 1;
@@ -194,6 +200,8 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
         for (llvm::StringRef::iterator i = begin, end = str.end();
              i != end; ++i)
         {
+            if (*i == '_')
+                continue;
             unsigned int c = HexDigitValue(*i);
             assert(c < radix && "invalid digit for given radix");
             v = v*radix + c;
@@ -203,6 +211,7 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
     }
 
     // long case
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     conv_bv = 0;
 
     // Figure out if we can shift instead of multiply
@@ -219,6 +228,8 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
     bool overflowed = false;
     for (llvm::StringRef::iterator i=begin, end=str.end(); i != end; ++i)
     {
+        if (*i == '_')
+            continue;
         unsigned int c = HexDigitValue(*i);
 
         // If this letter is out of bound for this radix, reject it.
@@ -251,7 +262,7 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
     }
 
     setBV(conv_bv);
-    return overflowed;
+    return !overflowed;
 }
 
 IntNum::IntNum(const IntNum& rhs)
@@ -425,6 +436,7 @@ IntNum::CalcImpl(Op::Op op,
 
     // Always do computations with in full bit vector.
     // Bit vector results must be calculated through intermediate storage.
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* op1 = getBV(&op1static);
     const llvm::APInt* op2 = 0;
     if (operand)
@@ -605,6 +617,7 @@ void
 IntNum::SignExtend(unsigned int size)
 {
     // For now, always implement with full bit vector.
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     llvm::APInt* bv = getBV(&signext_bv);
     bv->trunc(size);
     bv->sext(BITVECT_NATIVE_SIZE);
@@ -698,6 +711,44 @@ IntNum::isInt() const
     return (m_val.sv >= LONG_MIN && m_val.sv <= LONG_MAX);
 }
 
+uint64_t
+IntNum::getUInt64() const
+{
+    if (m_type == INTNUM_SV)
+    {
+        if (m_val.sv < 0)
+            return 0;
+        return static_cast<uint64_t>(m_val.sv);
+    }
+
+    // Handle bigval
+    if (m_val.bv->isNegative())
+        return 0;
+    if (m_val.bv->getActiveBits() > 64)
+        return std::numeric_limits<uint64_t>::max();
+    return m_val.bv->getZExtValue();
+}
+
+int64_t
+IntNum::getInt64() const
+{
+    if (m_type == INTNUM_SV)
+    {
+        if (m_val.sv < std::numeric_limits<int64_t>::min())
+            return std::numeric_limits<int64_t>::min();
+        if (m_val.sv > std::numeric_limits<int64_t>::max())
+            return std::numeric_limits<int64_t>::max();
+        return static_cast<int64_t>(m_val.sv);
+    }
+
+    // Handle bigval
+    if (m_val.bv->getMinSignedBits() <= 64)
+        return m_val.bv->getSExtValue();
+    if (m_val.bv->isNegative())
+        return std::numeric_limits<int64_t>::min();
+    return std::numeric_limits<int64_t>::max();
+}
+
 bool
 IntNum::isOkSize(unsigned int size, unsigned int rshift, int rangetype) const
 {
@@ -809,6 +860,7 @@ yasm::Compare(const IntNum& lhs, const IntNum& rhs)
         return 0;
     }
 
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* op1 = lhs.getBV(&op1static);
     const llvm::APInt* op2 = rhs.getBV(&op2static);
     if (op1->slt(*op2))
@@ -824,6 +876,7 @@ yasm::operator==(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv == rhs.m_val.sv;
 
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* op1 = lhs.getBV(&op1static);
     const llvm::APInt* op2 = rhs.getBV(&op2static);
     return op1->eq(*op2);
@@ -835,6 +888,7 @@ yasm::operator<(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv < rhs.m_val.sv;
 
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* op1 = lhs.getBV(&op1static);
     const llvm::APInt* op2 = rhs.getBV(&op2static);
     return op1->slt(*op2);
@@ -846,6 +900,7 @@ yasm::operator>(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv > rhs.m_val.sv;
 
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* op1 = lhs.getBV(&op1static);
     const llvm::APInt* op2 = rhs.getBV(&op2static);
     return op1->sgt(*op2);
@@ -881,10 +936,13 @@ IntNum::getStr(llvm::SmallVectorImpl<char>& str,
                 fmt = "%lX";
             break;
         default:
+        {
             // fall back to bigval
+            llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
             getBV(&conv_bv)->toString(str, static_cast<unsigned>(base), true,
                                       lowercase);
             return;
+        }
     }
 
     char s[40];
@@ -938,6 +996,7 @@ IntNum::Print(llvm::raw_ostream& os,
               bool showbase,
               int bits) const
 {
+    llvm::sys::SmartScopedLock<true> lock(static_bv_lock);
     const llvm::APInt* bv = getBV(&conv_bv);
 
     if (bv->isNegative())
@@ -51,20 +51,20 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
     /// Recalculates the bytecode's length based on an expanded span
     /// length.
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
 
     /// Convert a bytecode into its byte representation.
@@ -105,7 +105,7 @@ LEB128Bytecode::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 LEB128Bytecode::CalcLen(Bytecode& bc,
-                        /*@out@*/ unsigned long* len,
+                        /*@out@*/ uint64_t* len,
                         const Bytecode::AddSpanFunc& add_span,
                         Diagnostic& diags)
 {
@@ -132,13 +132,13 @@ LEB128Bytecode::CalcLen(Bytecode& bc,
 
 bool
 LEB128Bytecode::Expand(Bytecode& bc,
-                       unsigned long* len,
+                       uint64_t* len,
                        int span,
-                       long old_val,
-                       long new_val,
+                       int64_t old_val,
+                       int64_t new_val,
                        bool* keep,
-                       /*@out@*/ long* neg_thres,
-                       /*@out@*/ long* pos_thres,
+                       /*@out@*/ int64_t* neg_thres,
+                       /*@out@*/ int64_t* pos_thres,
                        Diagnostic& diags)
 {
     unsigned long size = SizeLEB128(new_val, m_value.isSigned());
@@ -150,15 +150,23 @@ LEB128Bytecode::Expand(Bytecode& bc,
         m_value.setSize(size);
     }
 
+    // Once the encoding can hold any 64-bit span value it can't grow further
+    unsigned int bits = static_cast<unsigned int>(size*7);
+    if (bits >= 64)
+    {
+        *keep = false;
+        return true;
+    }
+
     if (m_value.isSigned())
     {
-        *neg_thres = -(1<<(size*7-1));
-        *pos_thres = (1<<(size*7-1))-1;
+        *neg_thres = -(static_cast<int64_t>(1)<<(bits-1));
+        *pos_thres = (static_cast<int64_t>(1)<<(bits-1))-1;
     }
     else
     {
         *neg_thres = 0;
-        *pos_thres = (1<<(size*7))-1;
+        *pos_thres = static_cast<int64_t>((static_cast<uint64_t>(1)<<bits)-1);
     }
     *keep = true;
     return true;
@@ -35,7 +35,7 @@
 
 using namespace yasm;
 
-unsigned long
+uint64_t
 Location::getOffset() const
 {
     return bc->getOffset() + off;
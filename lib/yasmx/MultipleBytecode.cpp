@@ -28,6 +28,10 @@
 
 #define DEBUG_TYPE "MultipleBytecode"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
 #include "llvm/ADT/Statistic.h"
 #include "yasmx/Bytecode.h"
 #include "yasmx/BytecodeOutput.h"
@@ -40,6 +44,7 @@
 STATISTIC(num_multiple, "Number of multiple bytecodes");
 STATISTIC(num_skip, "Number of skip bytecodes");
 STATISTIC(num_fill, "Number of fill bytecodes");
+STATISTIC(num_replicated, "Number of multiples output by replication");
 
 using namespace yasm;
 
@@ -66,15 +71,15 @@ public:
     pugi::xml_node Write(pugi::xml_node out) const;
 #endif // WITH_XML
 
-    void setInt(long val) { m_int = val; }
-    long getInt() const { return m_int; }
+    void setInt(int64_t val) { m_int = val; }
+    int64_t getInt() const { return m_int; }
 
 private:
     /// Number of times contents is repeated.
     Expr m_expr;
 
     /// Number of times contents is repeated, integer version.
-    long m_int;
+    int64_t m_int;
 };
 
 class MultipleBytecode : public Bytecode::Contents
@@ -89,20 +94,20 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
     /// Recalculates the bytecode's length based on an expanded span
     /// length.
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
 
     /// Convert a bytecode into its byte representation.
@@ -142,20 +147,20 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
     /// Recalculates the bytecode's length based on an expanded span
     /// length.
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
 
     /// Convert a bytecode into its byte representation.
@@ -232,7 +237,7 @@ Multiple::CalcLen(Bytecode& bc,
             return false;
         }
         else
-            m_int = num.getInt();
+            m_int = num.getInt64();
     }
     else
     {
@@ -267,8 +272,8 @@ Multiple::CalcForOutput(SourceLocation source, Diagnostic& diags)
         diags.Report(source, diag::err_multiple_negative);
         return false;
     }
-    assert(m_int == num.getInt() && "multiple changed after optimize");
-    m_int = num.getInt();
+    assert(m_int == num.getInt64() && "multiple changed after optimize");
+    m_int = num.getInt64();
     return true;
 }
 
@@ -283,6 +288,50 @@ Multiple::Write(pugi::xml_node out) const
 }
 #endif // WITH_XML
 
+/// Output a byte pattern repeated count times.  The pattern is replicated
+/// into a block of up to 64 KiB by repeated doubling, so the number of
+/// output calls depends on the total size rather than the repeat count.
+static void
+OutputReplicated(BytecodeOutput& bc_out,
+                 const Bytes& pattern,
+                 uint64_t count,
+                 SourceLocation source)
+{
+    static const unsigned long BLOCK_SIZE = 65536;
+
+    unsigned long plen = static_cast<unsigned long>(pattern.size());
+    if (plen == 0 || count == 0)
+        return;
+
+    unsigned long per_block = std::max(BLOCK_SIZE / plen, 1UL);
+    if (per_block > count)
+        per_block = static_cast<unsigned long>(count);
+
+    Bytes block;
+    block.resize(per_block * plen);     // zero-filled
+
+    // An all-zero pattern needs no copying at all.
+    if (std::count(pattern.begin(), pattern.end(), 0) !=
+        static_cast<std::ptrdiff_t>(plen))
+    {
+        std::memcpy(&block[0], &pattern[0], plen);
+        for (unsigned long filled = plen; filled < block.size(); )
+        {
+            unsigned long n = std::min(filled, block.size() - filled);
+            std::memcpy(&block[filled], &block[0], n);
+            filled += n;
+        }
+    }
+
+    for (; count >= per_block; count -= per_block)
+        bc_out.OutputBytes(block, source);
+    if (count > 0)
+    {
+        block.resize(static_cast<size_t>(count * plen));
+        bc_out.OutputBytes(block, source);
+    }
+}
+
 MultipleBytecode::MultipleBytecode(std::auto_ptr<BytecodeContainer> contents,
                                    std::auto_ptr<Expr> e)
     : m_multiple(e)
@@ -332,8 +381,8 @@ public:
     void operator() (Bytecode& bc,
                      int id,
                      const Value& value,
-                     long neg_thres,
-                     long pos_thres);
+                     int64_t neg_thres,
+                     int64_t pos_thres);
 
 private:
     Bytecode& m_outer_bc;
@@ -346,8 +395,8 @@ void
 AddSpanInner::operator() (Bytecode& bc,
                           int id,
                           const Value& value,
-                          long neg_thres,
-                          long pos_thres)
+                          int64_t neg_thres,
+                          int64_t pos_thres)
 {
     int outer_id = id + (id < 0 ? -m_base : m_base);
     m_outer_addspan(m_outer_bc, outer_id, value, neg_thres, pos_thres);
@@ -355,7 +404,7 @@ AddSpanInner::operator() (Bytecode& bc,
 
 bool
 MultipleBytecode::CalcLen(Bytecode& bc,
-                          /*@out@*/ unsigned long* len,
+                          /*@out@*/ uint64_t* len,
                           const Bytecode::AddSpanFunc& add_span,
                           Diagnostic& diags)
 {
@@ -364,7 +413,7 @@ MultipleBytecode::CalcLen(Bytecode& bc,
 
     AddSpanInner add_span_inner(bc, add_span);
     int base = 100;
-    unsigned long ilen = 0;
+    uint64_t ilen = 0;
     for (BytecodeContainer::bc_iterator i = m_contents->bytecodes_begin(),
          end = m_contents->bytecodes_end(); i != end; ++i)
     {
@@ -381,13 +430,13 @@ MultipleBytecode::CalcLen(Bytecode& bc,
 
 bool
 MultipleBytecode::Expand(Bytecode& bc,
-                         unsigned long* len,
+                         uint64_t* len,
                          int span,
-                         long old_val,
-                         long new_val,
+                         int64_t old_val,
+                         int64_t new_val,
                          bool* keep,
-                         /*@out@*/ long* neg_thres,
-                         /*@out@*/ long* pos_thres,
+                         /*@out@*/ int64_t* neg_thres,
+                         /*@out@*/ int64_t* pos_thres,
                          Diagnostic& diags)
 {
     if (span < 0)
@@ -425,9 +474,34 @@ MultipleBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
     if (!m_multiple.CalcForOutput(bc.getSource(), bc_out.getDiagnostics()))
         return false;
 
-    unsigned long total_len = 0;
-    unsigned long pos = 0;
-    for (long mult=0, multend=m_multiple.getInt(); mult<multend;
+    // If the contents are plain bytes (no fixups or tail contents, so
+    // nothing can differ between repetitions), gather them once and
+    // replicate them rather than outputting each bytecode every time.
+    bool plain = true;
+    for (BytecodeContainer::bc_iterator i = m_contents->bytecodes_begin(),
+         end = m_contents->bytecodes_end(); i != end; ++i)
+    {
+        if (i->hasContents() || i->hasFixups())
+        {
+            plain = false;
+            break;
+        }
+    }
+    if (plain)
+    {
+        Bytes& bytes = bc_out.getScratch();
+        for (BytecodeContainer::bc_iterator i = m_contents->bytecodes_begin(),
+             end = m_contents->bytecodes_end(); i != end; ++i)
+            bytes.insert(bytes.end(), i->getFixed().begin(),
+                         i->getFixed().end());
+        OutputReplicated(bc_out, bytes, m_multiple.getInt(), bc.getSource());
+        ++num_replicated;
+        return true;
+    }
+
+    uint64_t total_len = 0;
+    uint64_t pos = 0;
+    for (int64_t mult=0, multend=m_multiple.getInt(); mult<multend;
          mult++, pos += total_len)
     {
         for (BytecodeContainer::bc_iterator i = m_contents->bytecodes_begin(),
@@ -501,7 +575,7 @@ FillBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 FillBytecode::CalcLen(Bytecode& bc,
-                      /*@out@*/ unsigned long* len,
+                      /*@out@*/ uint64_t* len,
                       const Bytecode::AddSpanFunc& add_span,
                       Diagnostic& diags)
 {
@@ -514,13 +588,13 @@ FillBytecode::CalcLen(Bytecode& bc,
 
 bool
 FillBytecode::Expand(Bytecode& bc,
-                     unsigned long* len,
+                     uint64_t* len,
                      int span,
-                     long old_val,
-                     long new_val,
+                     int64_t old_val,
+                     int64_t new_val,
                      bool* keep,
-                     /*@out@*/ long* neg_thres,
-                     /*@out@*/ long* pos_thres,
+                     /*@out@*/ int64_t* neg_thres,
+                     /*@out@*/ int64_t* pos_thres,
                      Diagnostic& diags)
 {
     if (span < 0)
@@ -558,8 +632,7 @@ FillBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
     num_out.EmitWarnings(bc_out.getDiagnostics());
     num_out.ClearWarnings();
 
-    for (long mult=0, multend=m_multiple.getInt(); mult<multend; mult++)
-        bc_out.OutputBytes(bytes, source);
+    OutputReplicated(bc_out, bytes, m_multiple.getInt(), source);
 
     return true;
 }
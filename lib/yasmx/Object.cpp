@@ -119,6 +119,9 @@ Object::Object(llvm::StringRef src_filename,
     m_options.DisableGlobalSubRelative = false;
     m_config.ExecStack = false;
     m_config.NoExecStack = false;
+    m_config.BigObj = false;
+    m_config.CompressDebug = false;
+    m_config.OutputThreads = 0;
 }
 
 void
@@ -142,6 +145,12 @@ Object::Finalize(Diagnostic& diags)
 {
     std::for_each(m_sections.begin(), m_sections.end(),
                   TR1::bind(&Section::Finalize, _1, TR1::ref(diags)));
+    if (diags.hasErrorOccurred())
+        return;
+
+    // Merge runs of fixed-only bytecodes so later passes walk fewer.
+    std::for_each(m_sections.begin(), m_sections.end(),
+                  TR1::bind(&Section::FuseBytecodes, _1));
 }
 
 void
@@ -325,31 +334,7 @@ Object::Optimize(Diagnostic& diags)
     // Step 1a
     for (section_iterator sect=m_sections.begin(), sectend=m_sections.end();
          sect != sectend; ++sect)
-    {
-        unsigned long offset = 0;
-
-        // Set the offset of the first (empty) bytecode.
-        sect->bytecodes_front().setIndex(bc_index++);
-        sect->bytecodes_front().setOffset(0);
-
-        // Iterate through the remainder, if any.
-        for (Section::bc_iterator bc=sect->bytecodes_begin(),
-             bcend=sect->bytecodes_end(); bc != bcend; ++bc)
-        {
-            bc->setIndex(bc_index++);
-            bc->setOffset(offset);
-
-            if (bc->CalcLen(TR1::bind(&Optimizer::AddSpan, &opt,
-                                      _1, _2, _3, _4, _5),
-                            diags))
-            {
-                if (bc->getSpecial() == Bytecode::Contents::SPECIAL_OFFSET)
-                    opt.AddOffsetSetter(*bc);
-
-                offset = bc->getNextOffset();
-            }
-        }
-    }
+        opt.Step1a(*sect, &bc_index);
 
     if (diags.hasErrorOccurred())
         return;
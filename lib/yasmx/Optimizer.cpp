@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <limits>
 #include <list>
 #include <memory>
 #include <vector>
@@ -57,12 +58,17 @@ STATISTIC(num_spans, "Number of spans created");
 STATISTIC(num_step1d, "Number of spans after step 1b");
 STATISTIC(num_itree, "Number of span terms added to interval tree");
 STATISTIC(num_offset_setters, "Number of offset setters");
+STATISTIC(num_static_offset,
+          "Number of offset setters resolved without the optimizer");
 STATISTIC(num_recalc, "Number of span recalculations performed");
 STATISTIC(num_expansions, "Number of expansions performed");
 STATISTIC(num_initial_qb, "Number of spans on initial QB");
 
 using namespace yasm;
 
+// Span value that forces a bytecode to its longest form.
+static const int64_t SPAN_VAL_MAX = std::numeric_limits<int64_t>::max();
+
 //
 // Robertson (1977) optimizer
 // Based (somewhat loosely) on the algorithm given in:
@@ -172,9 +178,9 @@ public:
 #endif // WITH_XML
 
     Bytecode* m_bc;
-    unsigned long m_cur_val;
-    unsigned long m_new_val;
-    unsigned long m_thres;
+    uint64_t m_cur_val;
+    uint64_t m_new_val;
+    uint64_t m_thres;
 };
 } // anonymous namespace
 
@@ -214,7 +220,7 @@ public:
              Location loc,
              Location loc2,
              Span* span,
-             long new_val);
+             int64_t new_val);
         ~Term() {}
 #ifdef WITH_XML
         pugi::xml_node Write(pugi::xml_node out) const;
@@ -223,16 +229,16 @@ public:
         Location m_loc;
         Location m_loc2;
         Span* m_span;       // span this term is a member of
-        long m_cur_val;
-        long m_new_val;
+        int64_t m_cur_val;
+        int64_t m_new_val;
         unsigned int m_subst;
     };
 
     Span(Bytecode& bc,
          int id,
          const Value& value,
-         long neg_thres,
-         long pos_thres,
+         int64_t neg_thres,
+         int64_t pos_thres,
          size_t os_index);
     ~Span();
 
@@ -260,11 +266,11 @@ private:
     Terms m_span_terms;
     ExprTerms m_expr_terms;
 
-    long m_cur_val;
-    long m_new_val;
+    int64_t m_cur_val;
+    int64_t m_new_val;
 
-    long m_neg_thres;
-    long m_pos_thres;
+    int64_t m_neg_thres;
+    int64_t m_pos_thres;
 
     int m_id;
 
@@ -299,7 +305,7 @@ public:
     void ITreeAdd(Span& span, Span::Term& term);
     void CheckCycle(IntervalTreeNode<Span::Term*> * node,
                     Span& span);
-    void ExpandTerm(IntervalTreeNode<Span::Term*> * node, long len_diff);
+    void ExpandTerm(IntervalTreeNode<Span::Term*> * node, int64_t len_diff);
 
     Diagnostic& m_diags;
 
@@ -326,7 +332,7 @@ Span::Term::Term(unsigned int subst,
                  Location loc,
                  Location loc2,
                  Span* span,
-                 long new_val)
+                 int64_t new_val)
     : m_loc(loc),
       m_loc2(loc2),
       m_span(span),
@@ -354,8 +360,8 @@ Span::Term::Write(pugi::xml_node out) const
 Span::Span(Bytecode& bc,
            int id,
            /*@null@*/ const Value& value,
-           long neg_thres,
-           long pos_thres,
+           int64_t neg_thres,
+           int64_t pos_thres,
            size_t os_index)
     : m_bc(bc),
       m_depval(value),
@@ -374,8 +380,8 @@ void
 Optimizer::AddSpan(Bytecode& bc,
                    int id,
                    const Value& value,
-                   long neg_thres,
-                   long pos_thres)
+                   int64_t neg_thres,
+                   int64_t pos_thres)
 {
     m_impl->m_spans.push_back(new Span(bc, id, value, neg_thres, pos_thres,
                                        m_impl->m_offset_setters.size()-1));
@@ -391,7 +397,7 @@ Span::AddTerm(unsigned int subst, Location loc, Location loc2)
 
     if (subst >= m_span_terms.size())
         m_span_terms.resize(subst+1);
-    m_span_terms[subst] = Term(subst, loc, loc2, this, intn.getInt());
+    m_span_terms[subst] = Term(subst, loc, loc2, this, intn.getInt64());
 }
 
 bool
@@ -436,7 +442,7 @@ Span::RecalcNormal(Diagnostic& diags)
     m_new_val = 0;
 
     if (m_depval.isRelative())
-        m_new_val = LONG_MAX;       // too complex; force to longest form
+        m_new_val = SPAN_VAL_MAX;   // too complex; force to longest form
     else if (m_depval.hasAbs())
     {
         ExprTerm result;
@@ -448,12 +454,12 @@ Span::RecalcNormal(Diagnostic& diags)
         if (!Evaluate(*m_depval.getAbs(), diags, &result, &m_expr_terms[0],
                       m_expr_terms.size(), false, false)
             || !result.isType(ExprTerm::INT))
-            m_new_val = LONG_MAX;   // too complex; force to longest form
+            m_new_val = SPAN_VAL_MAX;   // too complex; force to longest form
         else
-            m_new_val = result.getIntNum()->getInt();
+            m_new_val = result.getIntNum()->getInt64();
     }
 
-    if (m_new_val == LONG_MAX)
+    if (m_new_val == SPAN_VAL_MAX)
         m_active = INACTIVE;
 
     DEBUG(llvm::errs() << "updated " << getName() << " newval to "
@@ -584,6 +590,12 @@ Optimizer::Impl::Write(pugi::xml_node out) const
 }
 #endif // WITH_XML
 
+unsigned long
+Optimizer::getNumSpans() const
+{
+    return static_cast<unsigned long>(m_impl->m_spans.size());
+}
+
 void
 Optimizer::AddOffsetSetter(Bytecode& bc)
 {
@@ -657,7 +669,8 @@ Optimizer::Impl::CheckCycle(IntervalTreeNode<Span::Term*> * node, Span& span)
 }
 
 void
-Optimizer::Impl::ExpandTerm(IntervalTreeNode<Span::Term*> * node, long len_diff)
+Optimizer::Impl::ExpandTerm(IntervalTreeNode<Span::Term*> * node,
+                            int64_t len_diff)
 {
     Span::Term* term = node->getData();
     Span* span = term->m_span;
@@ -862,7 +875,7 @@ Optimizer::Impl::Step2()
 
         ++num_expansions;
 
-        unsigned long orig_len = span->m_bc.getTotalLen();
+        uint64_t orig_len = span->m_bc.getTotalLen();
 
         bool still_depend = false;
         if (!span->m_bc.Expand(span->m_id, span->m_cur_val, span->m_new_val,
@@ -886,7 +899,8 @@ Optimizer::Impl::Step2()
         else
             span->m_active = Span::INACTIVE;    // we're done with this span
 
-        long len_diff = span->m_bc.getTotalLen() - orig_len;
+        int64_t len_diff =
+            static_cast<int64_t>(span->m_bc.getTotalLen() - orig_len);
         if (len_diff == 0)
             continue;   // didn't increase in size
 
@@ -905,32 +919,32 @@ Optimizer::Impl::Step2()
         //  - offset-setter didn't move its following offset
         std::vector<OffsetSetter>::iterator os =
             m_offset_setters.begin() + span->m_os_index;
-        long offset_diff = len_diff;
+        int64_t offset_diff = len_diff;
         while (os != m_offset_setters.end()
                && os->m_bc
                && os->m_bc->getContainer() == span->m_bc.getContainer()
                && offset_diff != 0)
         {
-            unsigned long old_next_offset =
+            uint64_t old_next_offset =
                 os->m_cur_val + os->m_bc->getTotalLen();
 
             assert((offset_diff >= 0 ||
-                    static_cast<unsigned long>(-offset_diff) <= os->m_new_val)
+                    static_cast<uint64_t>(-offset_diff) <= os->m_new_val)
                    && "org/align went to negative offset");
             os->m_new_val += offset_diff;
 
             orig_len = os->m_bc->getTailLen();
             bool still_depend_temp;
-            long neg_thres_temp, pos_thres_temp;
-            os->m_bc->Expand(1, static_cast<long>(os->m_cur_val),
-                             static_cast<long>(os->m_new_val),
+            int64_t neg_thres_temp, pos_thres_temp;
+            os->m_bc->Expand(1, static_cast<int64_t>(os->m_cur_val),
+                             static_cast<int64_t>(os->m_new_val),
                              &still_depend_temp, &neg_thres_temp,
                              &pos_thres_temp, m_diags);
-            os->m_thres = static_cast<long>(pos_thres_temp);
+            os->m_thres = static_cast<uint64_t>(pos_thres_temp);
 
-            offset_diff =
-                os->m_new_val + os->m_bc->getTotalLen() - old_next_offset;
-            len_diff = os->m_bc->getTailLen() - orig_len;
+            offset_diff = static_cast<int64_t>(
+                os->m_new_val + os->m_bc->getTotalLen() - old_next_offset);
+            len_diff = static_cast<int64_t>(os->m_bc->getTailLen() - orig_len);
             if (len_diff != 0)
             {
                 DEBUG(llvm::errs() << "BC@" << os->m_bc << " ("
@@ -957,6 +971,49 @@ Optimizer::~Optimizer()
 {
 }
 
+void
+Optimizer::Step1a(BytecodeContainer& container, unsigned long* bc_index)
+{
+    uint64_t offset = 0;
+    const Section* sect = container.getSection();
+
+    // Set the offset of the first (empty) bytecode.
+    container.bytecodes_front().setIndex((*bc_index)++);
+    container.bytecodes_front().setOffset(0);
+
+    bool static_offsets = true;
+
+    // Iterate through the remainder, if any.
+    for (BytecodeContainer::bc_iterator bc=container.bytecodes_begin(),
+         end=container.bytecodes_end(); bc != end; ++bc)
+    {
+        bc->setIndex((*bc_index)++);
+        bc->setOffset(offset);
+
+        unsigned long num_spans = getNumSpans();
+        if (!bc->CalcLen(TR1::bind(&Optimizer::AddSpan, this,
+                                   _1, _2, _3, _4, _5),
+                         m_impl->m_diags))
+            continue;
+
+        if (getNumSpans() != num_spans)
+            static_offsets = false;
+
+        if (bc->getSpecial() == Bytecode::Contents::SPECIAL_OFFSET)
+        {
+            if (!static_offsets)
+                AddOffsetSetter(*bc);
+            else if (sect && !sect->isBSS() &&
+                     !bc->ConvertTailToFixed(m_impl->m_diags))
+                AddOffsetSetter(*bc);   // padding not rendered; error reported
+            else
+                ++num_static_offset;
+        }
+
+        offset = bc->getNextOffset();
+    }
+}
+
 void
 Optimizer::Step1b()
 {
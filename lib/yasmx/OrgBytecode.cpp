@@ -48,20 +48,20 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
     /// Recalculates the bytecode's length based on an expanded span
     /// length.
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
 
     /// Convert a bytecode into its byte representation.
@@ -129,34 +129,34 @@ OrgBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 OrgBytecode::CalcLen(Bytecode& bc,
-                     /*@out@*/ unsigned long* len,
+                     /*@out@*/ uint64_t* len,
                      const Bytecode::AddSpanFunc& add_span,
                      Diagnostic& diags)
 {
     bool keep = false;
-    long neg_thres = 0;
-    long pos_thres = m_start.getIntNum().getUInt();
+    int64_t neg_thres = 0;
+    int64_t pos_thres = m_start.getIntNum().getInt64();
 
     *len = 0;
-    return Expand(bc, len, 0, 0, static_cast<long>(bc.getTailOffset()), &keep,
-                  &neg_thres, &pos_thres, diags);
+    return Expand(bc, len, 0, 0, static_cast<int64_t>(bc.getTailOffset()),
+                  &keep, &neg_thres, &pos_thres, diags);
 }
 
 bool
 OrgBytecode::Expand(Bytecode& bc,
-                    unsigned long* len,
+                    uint64_t* len,
                     int span,
-                    long old_val,
-                    long new_val,
+                    int64_t old_val,
+                    int64_t new_val,
                     bool* keep,
-                    /*@out@*/ long* neg_thres,
-                    /*@out@*/ long* pos_thres,
+                    /*@out@*/ int64_t* neg_thres,
+                    /*@out@*/ int64_t* pos_thres,
                     Diagnostic& diags)
 {
-    unsigned long start = m_start.getIntNum().getUInt();
+    uint64_t start = m_start.getIntNum().getUInt64();
 
     // Check for overrun
-    if (static_cast<unsigned long>(new_val) > start)
+    if (static_cast<uint64_t>(new_val) > start)
     {
         diags.Report(bc.getSource(), diag::err_org_overlap);
         return false;
@@ -171,7 +171,7 @@ OrgBytecode::Expand(Bytecode& bc,
 bool
 OrgBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
 {
-    unsigned long start = m_start.getIntNum().getUInt();
+    uint64_t start = m_start.getIntNum().getUInt64();
 
     // Sanity check for overrun
     if (bc.getTailOffset() > start)
@@ -180,7 +180,7 @@ OrgBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
         return false;
     }
 
-    unsigned long len = start - bc.getTailOffset();
+    uint64_t len = start - bc.getTailOffset();
     if (!bc_out.isBits())
     {
         bc_out.OutputGap(len, bc.getSource());
@@ -0,0 +1,378 @@
+//
+// Block character scanners for the lexers
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Parse/CharScan.h"
+
+#include "llvm/System/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YASM_CHARSCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 code is compiled with a per-function target attribute and only
+// called after a runtime processor check, so it needs GCC 4.9+ or clang.
+#if defined(YASM_CHARSCAN_SSE2) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || \
+                            (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define YASM_CHARSCAN_AVX2 1
+#include <immintrin.h>
+#define YASM_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+using namespace yasm;
+
+//
+// Scalar versions.  These are also used when the processor supports
+// neither SSE2 nor AVX2.
+//
+static const char*
+ScalarHorzSpace(const char* ptr)
+{
+    while (*ptr == ' ' || *ptr == '\t')
+        ++ptr;
+    return ptr;
+}
+
+static const char*
+ScalarLineComment(const char* ptr)
+{
+    char ch = *ptr;
+    while (ch != 0 && ch != '\\' && ch != '\n' && ch != '\r')
+        ch = *++ptr;
+    return ptr;
+}
+
+static inline bool
+isScanIdentifierChar(unsigned char ch)
+{
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+           (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static const char*
+ScalarIdentifier(const char* ptr)
+{
+    while (isScanIdentifierChar(*ptr))
+        ++ptr;
+    return ptr;
+}
+
+static const char*
+ScalarStringLiteral(const char* ptr, char endch)
+{
+    char ch = *ptr;
+    while (ch != endch && ch != 0 && ch != '\\' && ch != '\n' && ch != '\r')
+        ch = *++ptr;
+    return ptr;
+}
+
+#ifdef YASM_CHARSCAN_SSE2
+//
+// SSE2 versions.  Each stop class Mask() returns a bitmask with a bit set for
+// every byte in the block at which scanning should stop.
+//
+struct SSE2HorzSpaceStop
+{
+    static inline unsigned int
+    Mask(__m128i v, __m128i)
+    {
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+        return ~_mm_movemask_epi8(ws) & 0xffff;
+    }
+};
+
+struct SSE2LineCommentStop
+{
+    static inline unsigned int
+    Mask(__m128i v, __m128i)
+    {
+        __m128i stop = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        return _mm_movemask_epi8(stop);
+    }
+};
+
+static inline __m128i
+SSE2InRange(__m128i v, char lo, char hi)
+{
+    // Signed compares; bytes >= 0x80 are negative and thus never in range.
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo-1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi+1)));
+}
+
+struct SSE2IdentifierStop
+{
+    static inline unsigned int
+    Mask(__m128i v, __m128i)
+    {
+        // Folding to lowercase maps no non-letter into 'a'..'z'.
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i id = _mm_or_si128(
+            _mm_or_si128(SSE2InRange(lower, 'a', 'z'),
+                         SSE2InRange(v, '0', '9')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        return ~_mm_movemask_epi8(id) & 0xffff;
+    }
+};
+
+struct SSE2StringLiteralStop
+{
+    static inline unsigned int
+    Mask(__m128i v, __m128i endch)
+    {
+        return SSE2LineCommentStop::Mask(v, endch) |
+            _mm_movemask_epi8(_mm_cmpeq_epi8(v, endch));
+    }
+};
+
+template <typename Stop>
+static const char*
+SSE2Scan(const char* ptr, char endch = 0)
+{
+    __m128i endv = _mm_set1_epi8(endch);
+    unsigned int off =
+        static_cast<unsigned int>(reinterpret_cast<uintptr_t>(ptr) & 15);
+    const __m128i* blk = reinterpret_cast<const __m128i*>(ptr - off);
+    unsigned int mask = Stop::Mask(_mm_load_si128(blk), endv) & (~0U << off);
+    while (mask == 0)
+        mask = Stop::Mask(_mm_load_si128(++blk), endv);
+    return reinterpret_cast<const char*>(blk) +
+        llvm::CountTrailingZeros_32(mask);
+}
+
+static const char*
+SSE2HorzSpace(const char* ptr)
+{
+    return SSE2Scan<SSE2HorzSpaceStop>(ptr);
+}
+
+static const char*
+SSE2LineComment(const char* ptr)
+{
+    return SSE2Scan<SSE2LineCommentStop>(ptr);
+}
+
+static const char*
+SSE2Identifier(const char* ptr)
+{
+    return SSE2Scan<SSE2IdentifierStop>(ptr);
+}
+
+static const char*
+SSE2StringLiteral(const char* ptr, char endch)
+{
+    return SSE2Scan<SSE2StringLiteralStop>(ptr, endch);
+}
+#endif // YASM_CHARSCAN_SSE2
+
+#ifdef YASM_CHARSCAN_AVX2
+//
+// AVX2 versions; same as the SSE2 ones, but on 32 byte blocks.
+//
+struct AVX2HorzSpaceStop
+{
+    static inline YASM_AVX2 unsigned int
+    Mask(__m256i v, __m256i)
+    {
+        __m256i ws =
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        return ~static_cast<unsigned int>(_mm256_movemask_epi8(ws));
+    }
+};
+
+struct AVX2LineCommentStop
+{
+    static inline YASM_AVX2 unsigned int
+    Mask(__m256i v, __m256i)
+    {
+        __m256i stop = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        return static_cast<unsigned int>(_mm256_movemask_epi8(stop));
+    }
+};
+
+static inline YASM_AVX2 __m256i
+AVX2InRange(__m256i v, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo-1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi+1), v));
+}
+
+struct AVX2IdentifierStop
+{
+    static inline YASM_AVX2 unsigned int
+    Mask(__m256i v, __m256i)
+    {
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i id = _mm256_or_si256(
+            _mm256_or_si256(AVX2InRange(lower, 'a', 'z'),
+                            AVX2InRange(v, '0', '9')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        return ~static_cast<unsigned int>(_mm256_movemask_epi8(id));
+    }
+};
+
+struct AVX2StringLiteralStop
+{
+    static inline YASM_AVX2 unsigned int
+    Mask(__m256i v, __m256i endch)
+    {
+        return AVX2LineCommentStop::Mask(v, endch) |
+            static_cast<unsigned int>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, endch)));
+    }
+};
+
+template <typename Stop>
+static YASM_AVX2 const char*
+AVX2Scan(const char* ptr, char endch = 0)
+{
+    __m256i endv = _mm256_set1_epi8(endch);
+    unsigned int off =
+        static_cast<unsigned int>(reinterpret_cast<uintptr_t>(ptr) & 31);
+    const __m256i* blk = reinterpret_cast<const __m256i*>(ptr - off);
+    unsigned int mask =
+        Stop::Mask(_mm256_load_si256(blk), endv) & (~0U << off);
+    while (mask == 0)
+        mask = Stop::Mask(_mm256_load_si256(++blk), endv);
+    return reinterpret_cast<const char*>(blk) +
+        llvm::CountTrailingZeros_32(mask);
+}
+
+static YASM_AVX2 const char*
+AVX2HorzSpace(const char* ptr)
+{
+    return AVX2Scan<AVX2HorzSpaceStop>(ptr);
+}
+
+static YASM_AVX2 const char*
+AVX2LineComment(const char* ptr)
+{
+    return AVX2Scan<AVX2LineCommentStop>(ptr);
+}
+
+static YASM_AVX2 const char*
+AVX2Identifier(const char* ptr)
+{
+    return AVX2Scan<AVX2IdentifierStop>(ptr);
+}
+
+static YASM_AVX2 const char*
+AVX2StringLiteral(const char* ptr, char endch)
+{
+    return AVX2Scan<AVX2StringLiteralStop>(ptr, endch);
+}
+#endif // YASM_CHARSCAN_AVX2
+
+namespace {
+/// Scanner implementations selected for the running processor.
+struct CharScanners
+{
+    const char* (*horz_space)(const char* ptr);
+    const char* (*line_comment)(const char* ptr);
+    const char* (*identifier)(const char* ptr);
+    const char* (*string_literal)(const char* ptr, char endch);
+
+    CharScanners();
+};
+} // anonymous namespace
+
+CharScanners::CharScanners()
+    : horz_space(ScalarHorzSpace)
+    , line_comment(ScalarLineComment)
+    , identifier(ScalarIdentifier)
+    , string_literal(ScalarStringLiteral)
+{
+#ifdef YASM_CHARSCAN_SSE2
+    horz_space = SSE2HorzSpace;
+    line_comment = SSE2LineComment;
+    identifier = SSE2Identifier;
+    string_literal = SSE2StringLiteral;
+#endif
+#ifdef YASM_CHARSCAN_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        horz_space = AVX2HorzSpace;
+        line_comment = AVX2LineComment;
+        identifier = AVX2Identifier;
+        string_literal = AVX2StringLiteral;
+    }
+#endif
+}
+
+static const CharScanners&
+getScanners()
+{
+    static CharScanners scanners;
+    return scanners;
+}
+
+// Most runs of whitespace and identifiers are only a few characters long;
+// checking the first character inline avoids the indirect call for the
+// shortest (and most common) cases.
+
+const char*
+yasm::ScanHorzSpace(const char* ptr)
+{
+    if (*ptr != ' ' && *ptr != '\t')
+        return ptr;
+    return getScanners().horz_space(ptr+1);
+}
+
+const char*
+yasm::ScanLineComment(const char* ptr)
+{
+    return getScanners().line_comment(ptr);
+}
+
+const char*
+yasm::ScanIdentifier(const char* ptr)
+{
+    if (!isScanIdentifierChar(*ptr))
+        return ptr;
+    return getScanners().identifier(ptr+1);
+}
+
+const char*
+yasm::ScanStringLiteral(const char* ptr, char endch)
+{
+    return getScanners().string_literal(ptr, endch);
+}
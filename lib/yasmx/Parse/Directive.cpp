@@ -26,6 +26,9 @@
 ///
 #include "yasmx/Parse/Directive.h"
 
+#include <cctype>
+
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "yasmx/Basic/Diagnostic.h"
@@ -83,7 +86,14 @@ Directives::Add(llvm::StringRef name, Directive handler, Flags flags)
 bool
 Directives::get(Directive* dir, llvm::StringRef name) const
 {
-    Impl::DirMap::iterator p = m_impl->m_dirs.find(llvm::LowercaseString(name));
+    // Lowercase into a stack buffer; this is called for every directive
+    // line, so avoid a heap-allocated temporary string.
+    llvm::SmallString<32> lname;
+    for (llvm::StringRef::iterator i=name.begin(), end=name.end(); i != end;
+         ++i)
+        lname += static_cast<char>(std::tolower(*i));
+
+    Impl::DirMap::iterator p = m_impl->m_dirs.find(lname.str());
     if (p == m_impl->m_dirs.end())
         return false;
 
@@ -34,6 +34,7 @@
 
 #include "llvm/Support/MemoryBuffer.h"
 #include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Parse/CharScan.h"
 #include "yasmx/Parse/Preprocessor.h"
 
 #include <cctype>
@@ -296,8 +297,14 @@ Lexer::SkipWhitespace(Token* result, const char* cur_ptr)
     for (;;)
     {
         // Skip horizontal whitespace very aggressively.
-        while (isHorizontalWhitespace(ch))
-            ch = *++cur_ptr;
+        for (;;)
+        {
+            cur_ptr = ScanHorzSpace(cur_ptr);
+            ch = *cur_ptr;
+            if (!isHorizontalWhitespace(ch))
+                break;
+            ++cur_ptr;  // \f or \v
+        }
     
         // Otherwise if we have something other than whitespace, we're done.
         if (ch != '\n' && ch != '\r')
@@ -350,16 +357,11 @@ Lexer::SkipLineComment(Token* result, const char* cur_ptr)
     // loop.
     char ch;
     do {
+        // Skip over characters in the fast block scanner.  It stops at nul
+        // (potentially EOF), backslash (potentially escaped newline), and
+        // newline or DOS-style newline.
+        cur_ptr = ScanLineComment(cur_ptr);
         ch = *cur_ptr;
-        // FIXME: Speedup BCPL comment lexing.  Just scan for a \n or \r
-        // character.  If we find a \n character, scan backwards, checking
-        // to see if it's an escaped newline, like we do for block comments.
-
-        // Skip over characters in the fast loop.
-        while (ch != 0 &&                   // Potentially EOF.
-               ch != '\\' &&                // Potentially escaped newline.
-               ch != '\n' && ch != '\r')    // Newline or DOS-style newline.
-            ch = *++cur_ptr;
 
         // If this is a newline, we're done.
         if (ch == '\n' || ch == '\r')
@@ -30,6 +30,8 @@
 //
 #include "yasmx/Parse/NumericParser.h"
 
+#include <limits>
+
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/SmallVector.h"
 #include "yasmx/IntNum.h"
@@ -57,9 +59,45 @@ NumericParser::getIntegerValue(IntNum* val)
         val->Zero();
         return false;
     }
-    return val->setStr(llvm::StringRef(m_digits_begin,
-                                       m_digits_end-m_digits_begin),
-                       m_radix);
+
+    // Fast path: nearly all literals fit in a native integer, so accumulate
+    // directly and only fall back to the arbitrary-precision IntNum::setStr()
+    // if the value overflows.
+    typedef IntNumData::USmallValue USmallValue;
+    const unsigned int usv_bits = std::numeric_limits<USmallValue>::digits;
+    const USmallValue usv_max = std::numeric_limits<USmallValue>::max();
+    unsigned int shift =
+        (m_radix == 16 ? 4 : m_radix == 8 ? 3 : m_radix == 2 ? 1 : 0);
+
+    USmallValue v = 0;
+    const char* ch = m_digits_begin;
+    for (; ch != m_digits_end; ++ch)
+    {
+        if (*ch == '_')
+            continue;
+        unsigned int c = DigitValue(*ch);
+        if (shift != 0)
+        {
+            if ((v >> (usv_bits - shift)) != 0)
+                break;      // overflow
+            v = (v << shift) | c;
+        }
+        else
+        {
+            if (v > (usv_max - c) / m_radix)
+                break;      // overflow
+            v = v * m_radix + c;
+        }
+    }
+    if (ch == m_digits_end)
+    {
+        *val = v;
+        return false;
+    }
+
+    return !val->setStr(llvm::StringRef(m_digits_begin,
+                                        m_digits_end-m_digits_begin),
+                        m_radix);
 }
 
 llvm::APFloat
@@ -101,7 +101,8 @@ void
 Preprocessor::EnterTokenStream(const Token* toks,
                                unsigned int num_toks,
                                bool disable_macro_expansion,
-                               bool owns_tokens)
+                               bool owns_tokens,
+                               unsigned long repeat)
 {
     // Save our current state.
     PushIncludeMacroStack();
@@ -112,13 +113,38 @@ Preprocessor::EnterTokenStream(const Token* toks,
     {
         m_cur_token_lexer.reset(new TokenLexer(toks, num_toks,
                                                disable_macro_expansion,
-                                               owns_tokens, *this));
+                                               owns_tokens, *this, repeat));
     }
     else
     {
         m_cur_token_lexer.reset(m_token_lexer_cache[--m_num_cached_token_lexers]);
         m_cur_token_lexer->Init(toks, num_toks, disable_macro_expansion,
-                                owns_tokens);
+                                owns_tokens, repeat);
+    }
+}
+
+/// EnterTokenStream - Add a "macro" context to the top of the include
+/// stack that returns the passes of tokens from a pass source.
+void
+Preprocessor::EnterTokenStream(std::auto_ptr<TokenPassSource> source,
+                               unsigned long passes,
+                               bool disable_macro_expansion)
+{
+    // Save our current state.
+    PushIncludeMacroStack();
+    m_cur_dir_lookup = 0;
+
+    // Create a macro expander to expand from the pass source.
+    if (m_num_cached_token_lexers == 0)
+    {
+        m_cur_token_lexer.reset(new TokenLexer(source, passes,
+                                               disable_macro_expansion,
+                                               *this));
+    }
+    else
+    {
+        m_cur_token_lexer.reset(m_token_lexer_cache[--m_num_cached_token_lexers]);
+        m_cur_token_lexer->Init(source, passes, disable_macro_expansion);
     }
 }
 
@@ -38,6 +38,10 @@
 
 using namespace yasm;
 
+TokenPassSource::~TokenPassSource()
+{
+}
+
 #if 0
 /// Create a TokenLexer for the specified macro with the specified actual
 /// arguments.  Note that this ctor takes ownership of the ActualArgs pointer.
@@ -76,7 +80,8 @@ void TokenLexer::Init(Token &Tok, SourceLocation ILEnd, MacroArgs *Actuals) {
 /// take ownership of the specified token vector.
 void
 TokenLexer::Init(const Token *TokArray, unsigned NumToks,
-                 bool disableMacroExpansion, bool ownsTokens)
+                 bool disableMacroExpansion, bool ownsTokens,
+                 unsigned long repeat)
 {
     // If the client is reusing a TokenLexer, make sure to free any memory
     // associated with it.
@@ -91,6 +96,11 @@ TokenLexer::Init(const Token *TokArray, unsigned NumToks,
     m_disable_macro_expansion = disableMacroExpansion;
     m_num_tokens = NumToks;
     m_cur_token = 0;
+    m_repeat = 0;
+    if (repeat == 0)
+        m_num_tokens = 0;   // nothing to return
+    else if (NumToks != 0)
+        m_repeat = repeat-1;
     m_instantiate_loc_start = m_instantiate_loc_end = SourceLocation();
     m_at_start_of_line = false;
     m_has_leading_space = false;
@@ -105,9 +115,50 @@ TokenLexer::Init(const Token *TokArray, unsigned NumToks,
 }
 
 
+/// Create a TokenLexer for the specified pass source, taking ownership
+/// of it.
+void
+TokenLexer::Init(std::auto_ptr<TokenPassSource> source,
+                 unsigned long passes,
+                 bool disable_macro_expansion)
+{
+    destroy();
+
+    m_source = source.release();
+    m_pass = 0;
+    m_tokens = 0;
+    m_num_tokens = 0;
+    m_owns_tokens = false;
+    m_disable_macro_expansion = disable_macro_expansion;
+    m_cur_token = 0;
+    m_repeat = 0;
+    if (passes != 0)
+    {
+        m_source->getPass(0, &m_tokens, &m_num_tokens);
+        m_repeat = passes-1;
+    }
+    m_instantiate_loc_start = m_instantiate_loc_end = SourceLocation();
+    setFirstTokenFlags();
+}
+
+void
+TokenLexer::setFirstTokenFlags()
+{
+    m_at_start_of_line = false;
+    m_has_leading_space = false;
+    if (m_num_tokens != 0)
+    {
+        m_at_start_of_line = m_tokens[0].isAtStartOfLine();
+        m_has_leading_space = m_tokens[0].hasLeadingSpace();
+    }
+}
+
 void
 TokenLexer::destroy()
 {
+    delete m_source;
+    m_source = 0;
+
     // If this was a function-like macro that actually uses its arguments,
     // delete the expanded tokens.
     if (m_owns_tokens)
@@ -324,6 +375,17 @@ void TokenLexer::ExpandFunctionArguments() {
 /// Lex - Lex and return a token from this macro stream.
 ///
 void TokenLexer::Lex(Token* Tok) {
+  // Start the next pass of a repeated token stream.  Passes from a pass
+  // source may be empty, so skip ahead to one that has tokens.
+  while (m_cur_token == m_num_tokens && m_repeat != 0) {
+    --m_repeat;
+    m_cur_token = 0;
+    if (m_source) {
+      m_source->getPass(++m_pass, &m_tokens, &m_num_tokens);
+      setFirstTokenFlags();
+    }
+  }
+
   // Lexing off the end of the macro, pop this macro off the expansion stack.
   if (isAtEnd()) {
 #if 0
@@ -332,6 +394,14 @@ void TokenLexer::Lex(Token* Tok) {
     if (Macro) Macro->EnableMacro();
 #endif
 
+    // Free the pass source now rather than when the lexer is reused.
+    if (m_source) {
+      delete m_source;
+      m_source = 0;
+      m_tokens = 0;
+      m_num_tokens = 0;
+    }
+
     // Pop this context off the preprocessors lexer stack and get the next
     // token.  This will delete "this" so remember the PP instance var.
     Preprocessor &PPCache = m_pp;
@@ -519,6 +589,8 @@ unsigned TokenLexer::isNextTokenLParen() const {
   // Out of tokens?
   if (isAtEnd())
     return 2;
+  if (m_cur_token == m_num_tokens)
+    return m_tokens[0].is(Token::l_paren);
   return m_tokens[m_cur_token].is(Token::l_paren);
 }
 
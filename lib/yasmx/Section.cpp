@@ -62,6 +62,13 @@ Section::AddReloc(std::auto_ptr<Reloc> reloc)
     m_relocs.push_back(reloc.release());
 }
 
+void
+Section::ClearRelocs()
+{
+    while (!m_relocs.empty())
+        delete m_relocs.pop_back();
+}
+
 #ifdef WITH_XML
 pugi::xml_node
 Section::Write(pugi::xml_node out) const
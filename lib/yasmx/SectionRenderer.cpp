@@ -0,0 +1,571 @@
+///
+/// Concurrent section rendering
+///
+///  Copyright (C) 2010  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+/// 1. Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+/// 2. Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+
+#include "yasmx/SectionRenderer.h"
+
+#include <memory>
+#include <string>
+
+#include "llvm/Config/config.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Atomic.h"
+#include "llvm/System/Threading.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Support/ptr_vector.h"
+#include "yasmx/Bytecode.h"
+#include "yasmx/Object.h"
+#include "yasmx/Section.h"
+
+#if defined(ENABLE_THREADS) && ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H)
+#define RENDER_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+using namespace yasm;
+
+/// Objects with less section content than this are rendered serially;
+/// starting threads would cost more than it saves.
+static const unsigned long PARALLEL_MIN_SIZE = 64*1024;
+
+/// Maximum amount of rendered but unwritten section contents each output
+/// worker thread may hold.  Larger sections are rendered by the writer
+/// straight into the output stream.
+static const unsigned long WORKER_BUFFER_SIZE = 16*1024*1024;
+
+namespace {
+/// Diagnostic client that only notes that something was reported.
+class NoteDiagnosticClient : public DiagnosticClient
+{
+public:
+    NoteDiagnosticClient() : m_reported(false) {}
+    ~NoteDiagnosticClient();
+
+    void HandleDiagnostic(Diagnostic::Level level, const DiagnosticInfo& info);
+
+    bool m_reported;
+};
+} // anonymous namespace
+
+NoteDiagnosticClient::~NoteDiagnosticClient()
+{
+}
+
+void
+NoteDiagnosticClient::HandleDiagnostic(Diagnostic::Level level,
+                                       const DiagnosticInfo& info)
+{
+    m_reported = true;
+}
+
+/// A thread rendering sections with its own diagnostics.
+class SectionRenderer::Worker
+{
+public:
+    Worker(SectionRenderer& renderer);
+    virtual ~Worker();
+
+    /// Render section n.
+    /// @return False if the section reported a diagnostic.
+    bool Render(unsigned int n, llvm::raw_ostream& os);
+
+    /// Render sections until there are none left.
+    virtual void Run() = 0;
+
+#ifdef RENDER_THREADS
+    static void* Start(void* worker);
+
+    pthread_t m_thread;
+#endif
+
+protected:
+    SectionRenderer& m_renderer;
+
+private:
+    NoteDiagnosticClient m_client;
+    Diagnostic m_diags;
+};
+
+SectionRenderer::Worker::Worker(SectionRenderer& renderer)
+    : m_renderer(renderer)
+    , m_diags(&m_client)
+{
+    // Diagnostics need a source manager to resolve their locations.
+    m_diags.setSourceManager(renderer.m_diags.getSourceManager());
+
+    // Make every warning visible, so a diagnostic that would be shown with
+    // the real diagnostic settings is never missed.
+    for (unsigned int i=0; i<diag::DIAG_UPPER_LIMIT; ++i)
+    {
+        if (Diagnostic::isBuiltinWarningOrExtension(i) &&
+            !Diagnostic::isBuiltinNote(i))
+            m_diags.setDiagnosticMapping(i, diag::MAP_WARNING);
+    }
+}
+
+SectionRenderer::Worker::~Worker()
+{
+}
+
+bool
+SectionRenderer::Worker::Render(unsigned int n, llvm::raw_ostream& os)
+{
+    m_client.m_reported = false;
+    m_renderer.DoRender(n, os, m_diags);
+    if (!m_client.m_reported)
+        return true;
+    m_diags.Reset();
+    return false;
+}
+
+#ifdef RENDER_THREADS
+void*
+SectionRenderer::Worker::Start(void* worker)
+{
+    static_cast<Worker*>(worker)->Run();
+    return 0;
+}
+#endif
+
+/// Worker for Prepare().
+class SectionRenderer::PrepareWorker : public SectionRenderer::Worker
+{
+public:
+    PrepareWorker(SectionRenderer& renderer,
+                  unsigned int nsects,
+                  volatile llvm::sys::cas_flag* next,
+                  std::vector<char>& redo);
+    ~PrepareWorker();
+
+    void Run();
+
+private:
+    unsigned int m_nsects;
+    volatile llvm::sys::cas_flag* m_next;   ///< Next section to render
+    std::vector<char>& m_redo;              ///< Sections to render again
+};
+
+SectionRenderer::PrepareWorker::PrepareWorker(SectionRenderer& renderer,
+                             unsigned int nsects,
+                             volatile llvm::sys::cas_flag* next,
+                             std::vector<char>& redo)
+    : Worker(renderer)
+    , m_nsects(nsects)
+    , m_next(next)
+    , m_redo(redo)
+{
+}
+
+SectionRenderer::PrepareWorker::~PrepareWorker()
+{
+}
+
+void
+SectionRenderer::PrepareWorker::Run()
+{
+    // Unbuffered, so large data (e.g. incbin) is never copied.
+    llvm::raw_null_ostream os;
+    os.SetUnbuffered();
+
+    for (;;)
+    {
+        unsigned int n = llvm::sys::AtomicIncrement(m_next) - 1;
+        if (n >= m_nsects)
+            break;
+        if (!Render(n, os))
+            m_redo[n] = 1;
+    }
+}
+
+#ifdef RENDER_THREADS
+/// Worker threads rendering sections, in order, ahead of Output().
+class SectionRenderer::Pipeline
+{
+public:
+    Pipeline(SectionRenderer& renderer);
+
+    /// Destructor.  Stops all worker threads.
+    ~Pipeline();
+
+    /// Start worker threads.
+    /// @return False if no thread could be started.
+    bool Start(unsigned int nworkers);
+
+    void Output(unsigned int n, llvm::raw_ostream& os);
+
+private:
+    class Thread;
+    friend class Thread;
+
+    enum State
+    {
+        PENDING,        ///< Not rendered
+        RENDERING,      ///< Being rendered by a worker
+        READY,          ///< Rendered into m_data
+        DIRECT          ///< To be rendered by the writer
+    };
+
+    /// Wait until section n is not being rendered, and take its rendered
+    /// contents (if any).  Must be called with m_mutex held.
+    /// @return False if the section must be rendered by the writer.
+    bool Take(unsigned int n, std::string& data);
+
+    SectionRenderer& m_renderer;
+    std::vector<State> m_state;
+    std::vector<std::string> m_data;    ///< Rendered contents
+    std::vector<Thread*> m_owner;       ///< Thread that rendered m_data
+    unsigned int m_next;                ///< Next section for a worker
+    unsigned int m_written;             ///< Next section for the writer
+    bool m_stop;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_rendered;          ///< A section has been rendered
+    pthread_cond_t m_written_cond;      ///< Buffered contents were written
+
+    stdx::ptr_vector<Thread> m_threads;
+    stdx::ptr_vector_owner<Thread> m_threads_owner;
+};
+
+class SectionRenderer::Pipeline::Thread : public SectionRenderer::Worker
+{
+public:
+    Thread(Pipeline& pipeline);
+    ~Thread();
+
+    void Run();
+
+    unsigned long m_buffered;           ///< Size of unwritten contents
+
+private:
+    Pipeline& m_pipeline;
+};
+
+SectionRenderer::Pipeline::Thread::Thread(Pipeline& pipeline)
+    : Worker(pipeline.m_renderer)
+    , m_buffered(0)
+    , m_pipeline(pipeline)
+{
+}
+
+SectionRenderer::Pipeline::Thread::~Thread()
+{
+}
+
+void
+SectionRenderer::Pipeline::Thread::Run()
+{
+    Pipeline& p = m_pipeline;
+    unsigned int nsects = static_cast<unsigned int>(p.m_state.size());
+
+    pthread_mutex_lock(&p.m_mutex);
+    for (;;)
+    {
+        while (!p.m_stop && p.m_next < nsects &&
+               m_buffered >= WORKER_BUFFER_SIZE)
+            pthread_cond_wait(&p.m_written_cond, &p.m_mutex);
+        if (p.m_stop || p.m_next >= nsects)
+            break;
+
+        unsigned int n = p.m_next++;
+        const Section& sect = *m_renderer.m_sects[n];
+        if (!sect.isBSS() &&
+            sect.bytecodes_back().getNextOffset() > WORKER_BUFFER_SIZE)
+        {
+            p.m_state[n] = DIRECT;
+            continue;
+        }
+        p.m_state[n] = RENDERING;
+        pthread_mutex_unlock(&p.m_mutex);
+
+        std::string data;
+        bool ok;
+        {
+            llvm::raw_string_ostream os(data);
+            ok = Render(n, os);
+        }
+
+        pthread_mutex_lock(&p.m_mutex);
+        if (ok)
+        {
+            p.m_data[n].swap(data);
+            p.m_owner[n] = this;
+            m_buffered += p.m_data[n].size();
+            p.m_state[n] = READY;
+        }
+        else
+            p.m_state[n] = DIRECT;  // render again with real diagnostics
+        pthread_cond_broadcast(&p.m_rendered);
+    }
+    pthread_mutex_unlock(&p.m_mutex);
+}
+
+SectionRenderer::Pipeline::Pipeline(SectionRenderer& renderer)
+    : m_renderer(renderer)
+    , m_state(renderer.m_sects.size(), PENDING)
+    , m_data(renderer.m_sects.size())
+    , m_owner(renderer.m_sects.size(), 0)
+    , m_next(0)
+    , m_written(0)
+    , m_stop(false)
+    , m_threads_owner(m_threads)
+{
+    pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_rendered, 0);
+    pthread_cond_init(&m_written_cond, 0);
+}
+
+SectionRenderer::Pipeline::~Pipeline()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_stop = true;
+    pthread_cond_broadcast(&m_written_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (stdx::ptr_vector<Thread>::iterator i=m_threads.begin(),
+         end=m_threads.end(); i != end; ++i)
+        pthread_join(i->m_thread, 0);
+
+    pthread_cond_destroy(&m_written_cond);
+    pthread_cond_destroy(&m_rendered);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+bool
+SectionRenderer::Pipeline::Start(unsigned int nworkers)
+{
+    for (unsigned int i=0; i<nworkers; ++i)
+    {
+        std::auto_ptr<Thread> thread(new Thread(*this));
+        if (pthread_create(&thread->m_thread, 0, Worker::Start,
+                           thread.get()) != 0)
+            break;
+        m_threads.push_back(thread.release());
+    }
+    return !m_threads.empty();
+}
+
+bool
+SectionRenderer::Pipeline::Take(unsigned int n, std::string& data)
+{
+    while (m_state[n] == RENDERING)
+        pthread_cond_wait(&m_rendered, &m_mutex);
+    if (m_state[n] != READY)
+        return false;
+
+    data.swap(m_data[n]);
+    std::string().swap(m_data[n]);
+    m_owner[n]->m_buffered -= data.size();
+    pthread_cond_broadcast(&m_written_cond);
+    return true;
+}
+
+void
+SectionRenderer::Pipeline::Output(unsigned int n, llvm::raw_ostream& os)
+{
+    assert(n >= m_written && "sections output out of order");
+    std::string data;
+
+    pthread_mutex_lock(&m_mutex);
+
+    // Discard skipped sections.
+    for (; m_written < n; ++m_written)
+    {
+        Take(m_written, data);
+        std::string().swap(data);
+    }
+    ++m_written;
+
+    // If no worker has got to this section yet, render it here, and move
+    // the workers past it.
+    if (m_next <= n)
+    {
+        m_next = n+1;
+        m_state[n] = DIRECT;
+    }
+    bool ready = Take(n, data);
+
+    pthread_mutex_unlock(&m_mutex);
+
+    if (ready)
+        os << data;
+    else
+        m_renderer.DoOutput(n, os);
+}
+
+#else
+class SectionRenderer::Pipeline
+{
+};
+#endif
+
+SectionRenderer::SectionRenderer(Object& object, Diagnostic& diags)
+    : m_diags(diags)
+    , m_total(0)
+    , m_preparing(false)
+    , m_prepared(false)
+{
+    for (Object::section_iterator i=object.sections_begin(),
+         end=object.sections_end(); i != end; ++i)
+    {
+        m_sects.push_back(&*i);
+        if (!i->isBSS())
+            m_total += i->bytecodes_back().getNextOffset();
+    }
+}
+
+SectionRenderer::~SectionRenderer()
+{
+    Finish();
+}
+
+unsigned int
+SectionRenderer::getThreadCount(unsigned int nthreads) const
+{
+#ifdef RENDER_THREADS
+    if (nthreads == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpu > 0 ? static_cast<unsigned int>(ncpu) : 1;
+    }
+    if (nthreads > m_sects.size())
+        nthreads = static_cast<unsigned int>(m_sects.size());
+    if (m_total < PARALLEL_MIN_SIZE)
+        nthreads = 1;
+    if (nthreads > 1 &&
+        (llvm::llvm_is_multithreaded() || llvm::llvm_start_multithreaded()))
+        return nthreads;
+#endif
+    return 1;
+}
+
+void
+SectionRenderer::DoRender(unsigned int n,
+                          llvm::raw_ostream& os,
+                          Diagnostic& diags)
+{
+    Section& sect = *m_sects[n];
+    sect.ClearRelocs();
+    RenderSection(sect, os, diags);
+}
+
+void
+SectionRenderer::DoOutput(unsigned int n, llvm::raw_ostream& os)
+{
+    // Prepare() already reported any diagnostics.
+    bool suppress = m_diags.getSuppressAllDiagnostics();
+    if (m_prepared)
+        m_diags.setSuppressAllDiagnostics();
+    DoRender(n, os, m_diags);
+    m_diags.setSuppressAllDiagnostics(suppress);
+}
+
+void
+SectionRenderer::Prepare(unsigned int nthreads)
+{
+    unsigned int nsects = static_cast<unsigned int>(m_sects.size());
+    nthreads = getThreadCount(nthreads);
+    m_preparing = true;
+
+#ifdef RENDER_THREADS
+    if (nthreads > 1)
+    {
+        volatile llvm::sys::cas_flag next = 0;
+        std::vector<char> redo(nsects, 0);
+
+        stdx::ptr_vector<Worker> workers;
+        stdx::ptr_vector_owner<Worker> workers_owner(workers);
+        for (unsigned int i=0; i<nthreads; ++i)
+            workers.push_back(new PrepareWorker(*this, nsects, &next, redo));
+
+        // The calling thread is the first worker.
+        unsigned int nstarted = 1;
+        for (; nstarted<nthreads; ++nstarted)
+        {
+            if (pthread_create(&workers[nstarted].m_thread, 0, Worker::Start,
+                               &workers[nstarted]) != 0)
+                break;
+        }
+        workers[0].Run();
+        for (unsigned int i=1; i<nstarted; ++i)
+            pthread_join(workers[i].m_thread, 0);
+
+        // Render sections that reported diagnostics again, in order, so
+        // the diagnostics come out as if rendering had been serial.
+        llvm::raw_null_ostream os;
+        os.SetUnbuffered();
+        for (unsigned int i=0; i<nsects; ++i)
+        {
+            if (redo[i])
+                DoRender(i, os, m_diags);
+        }
+    }
+    else
+#endif
+    {
+        llvm::raw_null_ostream os;
+        os.SetUnbuffered();
+        for (unsigned int i=0; i<nsects; ++i)
+            DoRender(i, os, m_diags);
+    }
+
+    m_preparing = false;
+    m_prepared = true;
+}
+
+void
+SectionRenderer::Start(unsigned int nthreads)
+{
+#ifdef RENDER_THREADS
+    // The calling thread writes; the others render ahead of it.
+    nthreads = getThreadCount(nthreads);
+    if (nthreads > 1)
+    {
+        m_pipeline.reset(new Pipeline(*this));
+        if (!m_pipeline->Start(nthreads-1))
+            m_pipeline.reset();
+    }
+#endif
+}
+
+void
+SectionRenderer::Output(unsigned int n, llvm::raw_ostream& os)
+{
+#ifdef RENDER_THREADS
+    if (m_pipeline)
+    {
+        m_pipeline->Output(n, os);
+        return;
+    }
+#endif
+    DoOutput(n, os);
+}
+
+void
+SectionRenderer::Finish()
+{
+    m_pipeline.reset();
+}
@@ -26,13 +26,38 @@
 
 #include "yasmx/StringTable.h"
 
+#include <algorithm>
+
 #include "llvm/Support/raw_ostream.h"
 
 
 using namespace yasm;
 
-StringTable::StringTable(unsigned long first_index)
+/// Placeholder index for strings added but not yet finalized.
+static const unsigned long PENDING = ~0UL;
+
+namespace {
+/// Orders strings by their reversed characters, descending.  This places
+/// each string immediately after a string it is a tail of (if any).
+struct ReverseGreater
+{
+    bool operator() (llvm::StringRef lhs, llvm::StringRef rhs) const
+    {
+        size_t l = lhs.size(), r = rhs.size();
+        for (; l > 0 && r > 0; --l, --r)
+        {
+            unsigned char lc = lhs[l-1], rc = rhs[r-1];
+            if (lc != rc)
+                return lc > rc;
+        }
+        return l > 0;
+    }
+};
+} // anonymous namespace
+
+StringTable::StringTable(unsigned long first_index, bool merge)
     : m_first_index(first_index)
+    , m_merge(merge)
 {
     m_storage.push_back('\0');
 }
@@ -44,12 +69,71 @@ StringTable::~StringTable()
 unsigned long
 StringTable::getIndex(llvm::StringRef str)
 {
+    if (m_merge)
+    {
+        if (str.empty())
+            return m_first_index;
+        unsigned long& index = m_index.GetOrCreateValue(str, PENDING)
+            .getValue();
+        if (index == PENDING)
+        {
+            index = m_first_index+m_storage.size();
+            m_storage.insert(m_storage.end(), str.begin(), str.end());
+            m_storage.push_back('\0');
+        }
+        return index;
+    }
+
     unsigned long end = m_storage.size();
     m_storage.insert(m_storage.end(), str.begin(), str.end());
     m_storage.push_back('\0');
     return m_first_index+end;
 }
 
+void
+StringTable::Add(llvm::StringRef str)
+{
+    if (m_merge && !str.empty())
+        m_index.GetOrCreateValue(str, PENDING);
+}
+
+void
+StringTable::Finalize()
+{
+    if (!m_merge)
+        return;
+
+    std::vector<llvm::StringRef> strs;
+    for (llvm::StringMap<unsigned long>::iterator i=m_index.begin(),
+         end=m_index.end(); i != end; ++i)
+    {
+        if (i->getValue() == PENDING)
+            strs.push_back(i->getKey());
+    }
+    std::sort(strs.begin(), strs.end(), ReverseGreater());
+
+    // Lay out strings; a string that is a tail of the one preceding it in
+    // sorted order is pointed into that string rather than stored again.
+    llvm::StringRef prev;
+    unsigned long prev_index = 0;
+    for (std::vector<llvm::StringRef>::iterator i=strs.begin(),
+         end=strs.end(); i != end; ++i)
+    {
+        unsigned long index;
+        if (prev.endswith(*i))
+            index = prev_index + prev.size() - i->size();
+        else
+        {
+            index = m_first_index+m_storage.size();
+            m_storage.insert(m_storage.end(), i->begin(), i->end());
+            m_storage.push_back('\0');
+            prev = *i;
+            prev_index = index;
+        }
+        m_index[*i] = index;
+    }
+}
+
 llvm::StringRef
 StringTable::getString(unsigned long index) const
 {
@@ -66,5 +150,6 @@ void
 StringTable::Read(const unsigned char* buf, unsigned long size)
 {
     m_storage.clear();
+    m_index.clear();
     m_storage.insert(m_storage.end(), buf, buf+size);
 }
@@ -43,6 +43,8 @@
 #include "X86RegisterGroup.h"
 
 
+#define NELEMS(array)   (sizeof(array) / sizeof(array[0]))
+
 using namespace yasm;
 using namespace yasm::arch;
 
@@ -53,7 +55,9 @@ X86Arch::X86Arch(const ArchModule& module)
       m_mode_bits(0),
       m_force_strict(false),
       m_default_rel(false),
-      m_nop(NOP_BASIC)
+      m_nop(NOP_BASIC),
+      m_branch_boundary(0),
+      m_optimize_size(false)
 {
     // default to all instructions/features enabled
     m_active_cpu.set();
@@ -136,11 +140,62 @@ X86Arch::setVar(llvm::StringRef var, unsigned long val)
                "default_rel requires bits=64");
         m_default_rel = (val != 0);
     }
+    else if (var.equals_lower("branch_boundary"))
+    {
+        assert((val & (val-1)) == 0 &&
+               "branch_boundary must be 0 or a power of 2");
+        m_branch_boundary = val;
+    }
+    else if (var.equals_lower("optimize_size"))
+        m_optimize_size = (val != 0);
     else
         return false;
     return true;
 }
 
+bool
+X86Arch::setTune(llvm::StringRef tune)
+{
+    // Tuning only selects the alignment padding (NOP) patterns.
+    static const struct
+    {
+        const char* name;
+        NopFormat nop;
+    } tunings[] =
+    {
+        {"generic",     NOP_BASIC},
+        {"i386",        NOP_BASIC},
+        {"i486",        NOP_BASIC},
+        {"pentium",     NOP_BASIC},
+        {"i686",        NOP_INTEL},
+        {"core2",       NOP_INTEL},
+        {"nehalem",     NOP_INTEL},
+        {"westmere",    NOP_INTEL},
+        {"sandybridge", NOP_INTEL},
+        {"intel",       NOP_INTEL},
+        {"k8",          NOP_AMD},
+        {"amdfam10",    NOP_AMD},
+        {"bdver1",      NOP_AMD},
+        {"amd",         NOP_AMD},
+        // Atom decodes from 16-byte fetch blocks, so it gets the longest
+        // (prefixed) forms: padding within a block is a single NOP, and no
+        // block gets more than two.
+        {"atom",        NOP_INTEL},
+        {"bonnell",     NOP_INTEL},
+        {"silvermont",  NOP_INTEL},
+    };
+
+    for (size_t i=0; i<NELEMS(tunings); ++i)
+    {
+        if (tune.equals_lower(tunings[i].name))
+        {
+            m_nop = tunings[i].nop;
+            return true;
+        }
+    }
+    return false;
+}
+
 void
 X86Arch::DirCpu(DirectiveInfo& info, Diagnostic& diags)
 {
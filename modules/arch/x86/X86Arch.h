@@ -169,6 +169,7 @@ public:
     unsigned int getAddressSize() const;
 
     bool setVar(llvm::StringRef var, unsigned long val);
+    bool setTune(llvm::StringRef tune);
 
     InsnPrefix ParseCheckInsnPrefix(llvm::StringRef id,
                                     SourceLocation source,
@@ -190,6 +191,13 @@ public:
 
     unsigned int getModeBits() const { return m_mode_bits; }
 
+    /// Get the boundary that branches must not cross or end on.
+    /// @return Boundary, or 0 if branch alignment is disabled.
+    unsigned long getBranchBoundary() const { return m_branch_boundary; }
+
+    /// Determine if shortest equivalent encodings should be selected.
+    bool isOptimizeSize() const { return m_optimize_size; }
+
     static const char* getName()
     { return "x86 (IA-32 and derivatives), AMD64"; }
     static const char* getKeyword() { return "x86"; }
@@ -218,6 +226,8 @@ private:
     bool m_force_strict;
     bool m_default_rel;
     NopFormat m_nop;
+    unsigned long m_branch_boundary;
+    bool m_optimize_size;
 };
 
 }} // namespace yasm::arch
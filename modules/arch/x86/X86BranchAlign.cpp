@@ -0,0 +1,310 @@
+//
+// x86 branch alignment bytecode
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#define DEBUG_TYPE "x86"
+
+#include "X86BranchAlign.h"
+
+#include "llvm/ADT/Statistic.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/BytecodeContainer.h"
+#include "yasmx/BytecodeOutput.h"
+#include "yasmx/Bytecode.h"
+#include "yasmx/Bytes.h"
+
+
+STATISTIC(num_branch_align, "Number of branch alignment bytecodes created");
+STATISTIC(num_branch_align_fused,
+          "Number of branch alignments extended over fused pairs");
+
+using namespace yasm;
+using namespace yasm::arch;
+
+namespace {
+class X86BranchAlign : public Bytecode::Contents
+{
+public:
+    X86BranchAlign(unsigned long boundary,
+                   unsigned long len,
+                   const unsigned char** code_fill);
+    ~X86BranchAlign();
+
+    bool Finalize(Bytecode& bc, Diagnostic& diags);
+    bool CalcLen(Bytecode& bc,
+                 /*@out@*/ uint64_t* len,
+                 const Bytecode::AddSpanFunc& add_span,
+                 Diagnostic& diags);
+    bool Expand(Bytecode& bc,
+                uint64_t* len,
+                int span,
+                int64_t old_val,
+                int64_t new_val,
+                bool* keep,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
+                Diagnostic& diags);
+    bool Output(Bytecode& bc, BytecodeOutput& bc_out);
+
+    llvm::StringRef getType() const;
+
+    SpecialType getSpecial() const;
+
+    X86BranchAlign* clone() const;
+
+#ifdef WITH_XML
+    pugi::xml_node Write(pugi::xml_node out) const;
+#endif // WITH_XML
+
+    /// Get padding length for a given starting offset.
+    unsigned long getPadLen(uint64_t start) const;
+
+    unsigned long m_boundary;   ///< boundary not to cross or end on
+    unsigned long m_len;        ///< maximum length of protected instructions
+    const unsigned char** m_code_fill;  ///< code fill patterns
+
+    /// True if the protected instruction can be fused with a following
+    /// conditional jump.  Cleared once the padding has been extended.
+    bool m_fusible;
+    /// Fixed length of the bytecode holding the fusible instruction.
+    unsigned long m_fusible_fixed_len;
+    /// Whether the bytecode holding the fusible instruction has a tail.
+    bool m_fusible_tail;
+};
+} // anonymous namespace
+
+X86BranchAlign::X86BranchAlign(unsigned long boundary,
+                               unsigned long len,
+                               const unsigned char** code_fill)
+    : m_boundary(boundary),
+      m_len(len),
+      m_code_fill(code_fill),
+      m_fusible(false),
+      m_fusible_fixed_len(0),
+      m_fusible_tail(false)
+{
+}
+
+X86BranchAlign::~X86BranchAlign()
+{
+}
+
+bool
+X86BranchAlign::Finalize(Bytecode& bc, Diagnostic& diags)
+{
+    return true;
+}
+
+unsigned long
+X86BranchAlign::getPadLen(uint64_t start) const
+{
+    // If the instruction can't fit within a boundary at all, don't bother.
+    if (m_len >= m_boundary)
+        return 0;
+
+    // Instruction must both start and end strictly within one boundary;
+    // if it doesn't, pad to the next boundary.
+    unsigned long off = static_cast<unsigned long>(start & (m_boundary-1));
+    if (off + m_len < m_boundary)
+        return 0;
+    return m_boundary - off;
+}
+
+bool
+X86BranchAlign::CalcLen(Bytecode& bc,
+                        /*@out@*/ uint64_t* len,
+                        const Bytecode::AddSpanFunc& add_span,
+                        Diagnostic& diags)
+{
+    bool keep = false;
+    int64_t neg_thres = 0;
+    int64_t pos_thres = 0;
+
+    *len = 0;
+    return Expand(bc, len, 0, 0, static_cast<int64_t>(bc.getTailOffset()),
+                  &keep, &neg_thres, &pos_thres, diags);
+}
+
+bool
+X86BranchAlign::Expand(Bytecode& bc,
+                       uint64_t* len,
+                       int span,
+                       int64_t old_val,
+                       int64_t new_val,
+                       bool* keep,
+                       /*@out@*/ int64_t* neg_thres,
+                       /*@out@*/ int64_t* pos_thres,
+                       Diagnostic& diags)
+{
+    uint64_t start = static_cast<uint64_t>(new_val);
+    uint64_t mask = m_boundary-1;
+    *len = getPadLen(start);
+    *pos_thres = static_cast<int64_t>((start & ~mask) + m_boundary);
+    *keep = true;
+    return true;
+}
+
+bool
+X86BranchAlign::Output(Bytecode& bc, BytecodeOutput& bc_out)
+{
+    unsigned long len = getPadLen(bc.getTailOffset());
+    if (len == 0)
+        return true;
+
+    if (!bc_out.isBits())
+    {
+        // Output as a gap.
+        bc_out.OutputGap(len, bc.getSource());
+        return true;
+    }
+
+    unsigned long maxlen = 15;
+    while (!m_code_fill[maxlen] && maxlen>0)
+        maxlen--;
+    if (maxlen == 0)
+    {
+        bc_out.Diag(bc.getSource(), diag::err_align_code_not_found);
+        return false;
+    }
+
+    // Fill with maximum code fill as much as possible
+    Bytes& bytes = bc_out.getScratch();
+    while (len > maxlen)
+    {
+        bytes.insert(bytes.end(),
+                     &m_code_fill[maxlen][0],
+                     &m_code_fill[maxlen][maxlen]);
+        len -= maxlen;
+    }
+
+    if (!m_code_fill[len])
+    {
+        bc_out.Diag(bc.getSource(), diag::err_align_invalid_code_size)
+            << static_cast<unsigned int>(len);
+        return false;
+    }
+    // Handle rest of code fill
+    bytes.insert(bytes.end(),
+                 &m_code_fill[len][0],
+                 &m_code_fill[len][len]);
+    bc_out.OutputBytes(bytes, bc.getSource());
+    return true;
+}
+
+llvm::StringRef
+X86BranchAlign::getType() const
+{
+    return "yasm::arch::X86BranchAlign";
+}
+
+X86BranchAlign::SpecialType
+X86BranchAlign::getSpecial() const
+{
+    return SPECIAL_OFFSET;
+}
+
+X86BranchAlign*
+X86BranchAlign::clone() const
+{
+    return new X86BranchAlign(*this);
+}
+
+#ifdef WITH_XML
+pugi::xml_node
+X86BranchAlign::Write(pugi::xml_node out) const
+{
+    pugi::xml_node root = out.append_child("X86BranchAlign");
+    append_child(root, "Boundary", m_boundary);
+    append_child(root, "Len", m_len);
+    if (m_fusible)
+        root.append_attribute("fusible") = true;
+    return root;
+}
+#endif // WITH_XML
+
+/// Find the branch alignment padding immediately preceding the bytecode
+/// holding the last instruction in the container.
+static X86BranchAlign*
+FindPrevBranchAlign(BytecodeContainer& container)
+{
+    BytecodeContainer::bc_iterator last = container.bytecodes_end();
+    if (last == container.bytecodes_begin())
+        return 0;
+    --last;
+    if (last == container.bytecodes_begin())
+        return 0;
+    BytecodeContainer::bc_iterator prev = last;
+    --prev;
+    if (!prev->hasContents() ||
+        prev->getContents().getType() != "yasm::arch::X86BranchAlign")
+        return 0;
+    return static_cast<X86BranchAlign*>(&prev->getContents());
+}
+
+void
+arch::AppendBranchAlign(BytecodeContainer& container,
+                        unsigned long boundary,
+                        unsigned long len,
+                        const unsigned char** code_fill,
+                        SourceLocation source)
+{
+    assert((boundary & (boundary-1)) == 0 && "boundary not a power of 2");
+    Bytecode& bc = container.FreshBytecode();
+    bc.Transform(Bytecode::Contents::Ptr(
+        new X86BranchAlign(boundary, len, code_fill)));
+    bc.setSource(source);
+    ++num_branch_align;
+}
+
+void
+arch::SetBranchAlignFusible(BytecodeContainer& container)
+{
+    X86BranchAlign* align = FindPrevBranchAlign(container);
+    if (!align)
+        return;
+    const Bytecode& last = container.bytecodes_back();
+    align->m_fusible = true;
+    align->m_fusible_fixed_len = last.getFixedLen();
+    align->m_fusible_tail = last.hasContents();
+}
+
+bool
+arch::ExtendBranchAlign(BytecodeContainer& container, unsigned long len)
+{
+    X86BranchAlign* align = FindPrevBranchAlign(container);
+    if (!align || !align->m_fusible)
+        return false;
+
+    // Make sure nothing else was appended after the fusible instruction.
+    const Bytecode& last = container.bytecodes_back();
+    if (last.getFixedLen() != align->m_fusible_fixed_len ||
+        last.hasContents() != align->m_fusible_tail)
+        return false;
+
+    align->m_len += len;
+    align->m_fusible = false;
+    ++num_branch_align_fused;
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef YASM_X86BRANCHALIGN_H
+#define YASM_X86BRANCHALIGN_H
+//
+// x86 branch alignment bytecode header file
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Config/export.h"
+
+
+namespace yasm
+{
+
+class BytecodeContainer;
+class SourceLocation;
+
+namespace arch
+{
+
+/// Append padding that keeps the instruction appended next from crossing
+/// or ending on a boundary (the Intel JCC erratum mitigation).  The padding
+/// is an offset setter, so it is recomputed by the optimizer as offsets
+/// change.
+/// @param container    bytecode container
+/// @param boundary     boundary (power of 2)
+/// @param len          maximum length of the instruction to protect
+/// @param code_fill    code fill patterns
+/// @param source       source location
+YASM_STD_EXPORT
+void AppendBranchAlign(BytecodeContainer& container,
+                       unsigned long boundary,
+                       unsigned long len,
+                       const unsigned char** code_fill,
+                       SourceLocation source);
+
+/// Mark the instruction just appended after a branch alignment padding
+/// as macro-fusible with a following conditional jump.
+/// @param container    bytecode container
+YASM_STD_EXPORT
+void SetBranchAlignFusible(BytecodeContainer& container);
+
+/// If the last instruction in the container is a macro-fusible instruction
+/// protected by branch alignment padding, extend that padding to also
+/// cover an instruction about to be appended.
+/// @param container    bytecode container
+/// @param len          maximum length of the instruction about to be
+///                     appended
+/// @return True if the padding was extended, false if no suitable padding
+///         was found.
+YASM_STD_EXPORT
+bool ExtendBranchAlign(BytecodeContainer& container, unsigned long len);
+
+}} // namespace yasm::arch
+
+#endif
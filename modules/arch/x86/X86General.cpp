@@ -72,17 +72,17 @@ public:
 
     bool Finalize(Bytecode& bc, Diagnostic& diags);
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
     bool Output(Bytecode& bc, BytecodeOutput& bc_out);
 
@@ -265,7 +265,7 @@ VexOptimize(X86Opcode& opcode,
 
 bool
 X86General::CalcLen(Bytecode& bc,
-                    /*@out@*/ unsigned long* len,
+                    /*@out@*/ uint64_t* len,
                     const Bytecode::AddSpanFunc& add_span,
                     Diagnostic& diags)
 {
@@ -404,13 +404,13 @@ X86General::CalcLen(Bytecode& bc,
 
 bool
 X86General::Expand(Bytecode& bc,
-                   unsigned long* len,
+                   uint64_t* len,
                    int span,
-                   long old_val,
-                   long new_val,
+                   int64_t old_val,
+                   int64_t new_val,
                    bool* keep,
-                   /*@out@*/ long* neg_thres,
-                   /*@out@*/ long* pos_thres,
+                   /*@out@*/ int64_t* neg_thres,
+                   /*@out@*/ int64_t* pos_thres,
                    Diagnostic& diags)
 {
     if (m_ea != 0 && span == 1)
@@ -539,23 +539,25 @@ X86General::Output(Bytecode& bc, BytecodeOutput& bc_out)
     // Displacement (if required)
     if (m_ea != 0 && m_ea->m_need_disp)
     {
-        unsigned int disp_len = m_ea->m_disp.getSize()/8;
+        // Work on a copy, as the bytecode may be output more than once.
+        Value disp(m_ea->m_disp);
+        unsigned int disp_len = disp.getSize()/8;
 
-        m_ea->m_disp.setInsnStart(pos);
-        if (m_ea->m_disp.isIPRelative())
+        disp.setInsnStart(pos);
+        if (disp.isIPRelative())
         {
             // Adjust relative displacement to end of bytecode
-            m_ea->m_disp.AddAbs(-static_cast<long>(pos+disp_len+imm_len));
+            disp.AddAbs(-static_cast<long>(pos+disp_len+imm_len));
             // Distance to end of instruction is the immediate length
-            m_ea->m_disp.setNextInsn(imm_len);
+            disp.setNextInsn(imm_len);
         }
         Location loc = {&bc, bc.getFixedLen()+pos};
         pos += disp_len;
         bytes.resize(0);
         bytes.resize(disp_len);
         NumericOutput num_out(bytes);
-        m_ea->m_disp.ConfigureOutput(&num_out);
-        if (!bc_out.OutputValue(m_ea->m_disp, loc, num_out))
+        disp.ConfigureOutput(&num_out);
+        if (!bc_out.OutputValue(disp, loc, num_out))
             return false;
     }
 
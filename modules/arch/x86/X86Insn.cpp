@@ -45,6 +45,7 @@
 #include "yasmx/IntNum.h"
 
 #include "X86Arch.h"
+#include "X86BranchAlign.h"
 #include "X86Common.h"
 #include "X86EffAddr.h"
 #include "X86General.h"
@@ -61,6 +62,8 @@
 STATISTIC(num_groups_scanned, "Total number of instruction groups scanned");
 STATISTIC(num_jmp_groups_scanned, "Total number of jump groups scanned");
 STATISTIC(num_empty_insn, "Number of empty instructions created");
+STATISTIC(num_size_opt, "Number of instructions shortened for size");
+STATISTIC(num_size_opt_bytes, "Number of bytes saved by size optimization");
 
 using namespace yasm;
 using namespace yasm::arch;
@@ -566,6 +569,23 @@ X86Insn::DoAppendJmp(BytecodeContainer& container,
     common.ApplyPrefixes(jinfo.def_opersize_64, m_prefixes, diags);
     common.Finish();
 
+    if (unsigned long boundary = m_arch.getBranchBoundary())
+    {
+        // Protect the longest form the jump may end up taking.
+        unsigned long len = common.getLen();
+        if (op_sel == X86_JMP_SHORT)
+            len += shortop.getLen() + 1;
+        else
+            len += nearop.getLen() + ((common.m_opersize == 16) ? 2 : 4);
+
+        // A conditional jump extends the padding of a directly preceding
+        // cmp/test so the fused pair is kept together.
+        bool jcc = shortop.getLen() == 1 && (shortop.get(0) & 0xF0) == 0x70;
+        if (!jcc || !ExtendBranchAlign(container, len))
+            AppendBranchAlign(container, boundary, len, m_arch.getFill(),
+                              source);
+    }
+
     AppendJmp(container, common, shortop, nearop, imm, imm_source, source,
               op_sel);
     return true;
@@ -1131,13 +1151,32 @@ public:
                        Insn::Operands& operands);
     void CheckSegReg(const X86SegmentRegister* segreg, SourceLocation source);
     void ApplySegReg(const SegmentRegister* segreg, SourceLocation source);
+    void ApplySizeOpt();
     bool Finish(BytecodeContainer& container,
                 const Insn::Prefixes& prefixes,
+                const X86Arch& arch,
                 SourceLocation source);
 
 private:
     void ApplyOperand(const X86InfoOperand& info_op, Operand& op);
 
+    bool isRegEA() const
+    {
+        return m_x86_ea.get() != 0 && m_x86_ea->m_valid_modrm &&
+            (m_x86_ea->m_modrm & 0xC0) == 0xC0;
+    }
+    bool DropRexW();
+    unsigned long getRegImmLen() const;
+
+    enum BranchAlignType
+    {
+        BRANCH_ALIGN_NONE = 0,
+        BRANCH_ALIGN_BRANCH,    // near ret, indirect near jmp/call
+        BRANCH_ALIGN_FUSIBLE    // cmp/test that can fuse with a jcc
+    };
+    BranchAlignType getBranchAlignType();
+    unsigned long getMaxLen(const X86Common& common) const;
+
     const X86InsnInfo& m_info;
     unsigned int m_mode_bits;
     const unsigned int* m_size_lookup;
@@ -1622,9 +1661,185 @@ BuildGeneral::ApplySegReg(const SegmentRegister* segreg, SourceLocation source)
     CheckSegReg(static_cast<const X86SegmentRegister*>(segreg), source);
 }
 
+// Drop REX.W, and the REX prefix itself if nothing else needs it.
+// Returns true if the REX prefix was removed.
+bool
+BuildGeneral::DropRexW()
+{
+    m_rex &= ~0x08;
+    m_opersize = 32;
+    if (m_rex != 0x40)
+        return false;
+    m_rex = 0;
+    return true;
+}
+
+// Length of a register/immediate instruction (no memory operand).
+unsigned long
+BuildGeneral::getRegImmLen() const
+{
+    unsigned long len = m_opcode.getLen() + m_im_len/8;
+    if ((m_mode_bits != 64 && m_opersize != 0 && m_opersize != m_mode_bits) ||
+        (m_mode_bits == 64 && m_opersize == 16))
+        ++len;
+    if (m_rex != 0 && m_rex != 0xff)
+        ++len;
+    if (m_x86_ea.get() != 0)
+        ++len;
+    return len;
+}
+
+// Select shorter but equivalent encodings for a few common 64-bit
+// instructions with constant immediates:
+//  - mov r64, imm32 (zero-extendable) => mov r32, imm32
+//  - test r, imm7 => test r8, imm8
+//  - and/test r64, imm31 => and/test r32, imm32
+//  - xor/sub r64, r64 (same register) => xor/sub r32, r32
+void
+BuildGeneral::ApplySizeOpt()
+{
+    IntNum imm;
+    bool imm_known = m_imm.get() != 0 && m_imm->isIntNum();
+    if (imm_known)
+        imm = m_imm->getIntNum();
+    bool rexw = m_mode_bits == 64 && m_rex != 0xff && (m_rex & 0x08) != 0;
+    unsigned long saved = 0;
+    unsigned char op0 = m_opcode.get(0);
+    unsigned char newop[3] = {op0, 0, 0};
+
+    if (m_postop == X86_POSTOP_SIMM32_AVAIL)
+    {
+        if (!imm_known || !imm.isOkSize(32, 0, 0))
+            return;
+        // Before: REX + C7 + ModRM + imm32, or REX + B8 + imm64.
+        saved = imm.isOkSize(31, 0, 0) ? 7 : 10;
+        m_opcode = X86Opcode(1, newop);     // B8+r
+        m_postop = X86_POSTOP_NONE;
+        m_im_len = 32;
+        m_im_sign = 0;
+        saved -= 5 + (DropRexW() ? 0 : 1);
+    }
+    else if (m_opcode.getLen() == 1 && imm_known && imm.isOkSize(7, 0, 0) &&
+             (op0 == 0xA9 || (op0 == 0xF7 && m_spare == 0 && isRegEA())))
+    {
+        // test: flags are the same as long as bit 7 of the immediate is
+        // clear.
+        bool need_rex = false;
+        if (op0 == 0xF7 && (m_x86_ea->m_modrm & 7) >= 4 &&
+            (m_rex == 0 || (m_rex & 1) == 0))
+        {
+            // spl/bpl/sil/dil need a REX prefix; without one these
+            // are ah/ch/dh/bh.
+            if (m_mode_bits != 64)
+                return;
+            need_rex = true;
+        }
+        saved = getRegImmLen();
+        newop[0] = op0 - 1;                 // A8 or F6
+        m_opcode = X86Opcode(1, newop);
+        m_im_len = 8;
+        m_opersize = 0;
+        m_rex &= ~0x08;
+        if (m_rex == 0x40 && !need_rex)
+            m_rex = 0;
+        else if (m_rex == 0 && need_rex)
+            m_rex = 0x40;
+        saved -= getRegImmLen();
+    }
+    else if (!rexw)
+        return;
+    else if (imm_known && imm.isOkSize(31, 0, 0) &&
+             ((op0 == 0x83 && m_opcode.getLen() == 2 &&
+               m_opcode.get(1) == 0xE0) ||                  // and rax, imm
+              ((op0 == 0x83 || op0 == 0x81) && m_spare == 4 && isRegEA()) ||
+              (op0 == 0xA9 && m_opcode.getLen() == 1) ||    // test rax, imm
+              (op0 == 0xF7 && m_spare == 0 && isRegEA())))
+    {
+        // and/test: bits 31-63 of the result are zero either way.
+        if (DropRexW())
+            saved = 1;
+    }
+    else if (!m_imm.get() && m_opcode.getLen() == 1 && isRegEA() &&
+             (op0 == 0x31 || op0 == 0x33 || op0 == 0x29 || op0 == 0x2B) &&
+             (m_x86_ea->m_modrm & 7) == (m_spare & 7) &&
+             ((m_rex >> 2) & 1) == (m_rex & 1))
+    {
+        // xor/sub zeroing idiom: 32-bit form zero-extends.
+        if (DropRexW())
+            saved = 1;
+    }
+    else
+        return;
+
+    if (saved == 0)
+        return;
+    ++num_size_opt;
+    num_size_opt_bytes += saved;
+}
+
+BuildGeneral::BranchAlignType
+BuildGeneral::getBranchAlignType()
+{
+    if (m_opcode.getLen() != 1)
+        return BRANCH_ALIGN_NONE;
+
+    bool mem = m_x86_ea.get() != 0 &&
+        !(m_x86_ea->m_valid_modrm && (m_x86_ea->m_modrm & 0xC0) == 0xC0);
+
+    switch (m_opcode.get(0))
+    {
+        case 0xC2: case 0xC3:
+            return BRANCH_ALIGN_BRANCH;
+        case 0xFF:
+            if (m_spare == 2 || m_spare == 4)
+                return BRANCH_ALIGN_BRANCH;
+            break;
+        case 0x38: case 0x39: case 0x3A: case 0x3B: case 0x3C: case 0x3D:
+        case 0x84: case 0x85: case 0xA8: case 0xA9:
+            return BRANCH_ALIGN_FUSIBLE;
+        case 0x80: case 0x81: case 0x83:
+            // cmp with memory and immediate operands doesn't fuse
+            if (m_spare == 7 && !mem)
+                return BRANCH_ALIGN_FUSIBLE;
+            break;
+        case 0xF6: case 0xF7:
+            if (m_spare == 0 && !mem)
+                return BRANCH_ALIGN_FUSIBLE;
+            break;
+    }
+    return BRANCH_ALIGN_NONE;
+}
+
+unsigned long
+BuildGeneral::getMaxLen(const X86Common& common) const
+{
+    unsigned long len = common.getLen() + m_opcode.getLen();
+    if (m_special_prefix != 0)
+        ++len;
+    if (m_rex != 0 && m_rex != 0xff)
+        ++len;
+    if (X86EffAddr* x86_ea = m_x86_ea.get())
+    {
+        if (x86_ea->m_valid_modrm && (x86_ea->m_modrm & 0xC0) == 0xC0)
+            ++len;          // register: Mod/RM only
+        else
+        {
+            // Mod/RM, SIB, 32-bit displacement, segment and address size
+            // overrides, and a REX prefix the address may still require.
+            len += 1+1+4+1+1;
+            if (m_mode_bits == 64 && (m_rex == 0 || m_rex == 0xff))
+                ++len;
+        }
+    }
+    if (m_imm.get() != 0)
+        len += m_im_len/8;
+    return len;
+}
+
 bool
 BuildGeneral::Finish(BytecodeContainer& container,
                      const Insn::Prefixes& prefixes,
+                     const X86Arch& arch,
                      SourceLocation source)
 {
     std::auto_ptr<Value> imm_val(0);
@@ -1722,6 +1937,17 @@ BuildGeneral::Finish(BytecodeContainer& container,
         m_opcode = X86Opcode(3, opcode); // two prefix bytes and 1 opcode byte
     }
 
+    // Keep branches (and fusible pairs) from crossing or ending on the
+    // branch boundary.
+    BranchAlignType align_type = BRANCH_ALIGN_NONE;
+    if (unsigned long boundary = arch.getBranchBoundary())
+    {
+        align_type = getBranchAlignType();
+        if (align_type != BRANCH_ALIGN_NONE)
+            AppendBranchAlign(container, boundary, getMaxLen(common),
+                              arch.getFill(), source);
+    }
+
     AppendGeneral(container,
                   common,
                   m_opcode,
@@ -1732,6 +1958,8 @@ BuildGeneral::Finish(BytecodeContainer& container,
                   m_postop,
                   m_default_rel,
                   source);
+    if (align_type == BRANCH_ALIGN_FUSIBLE)
+        SetBranchAlignFusible(container);
     return true;
 }
 
@@ -1749,8 +1977,10 @@ X86Insn::DoAppendGeneral(BytecodeContainer& container,
     buildgen.UpdateRex();
     buildgen.ApplyOperands(static_cast<X86Arch::ParserSelect>(m_parser),
                            m_operands);
+    if (m_arch.isOptimizeSize())
+        buildgen.ApplySizeOpt();
     buildgen.ApplySegReg(m_segreg, m_segreg_source);
-    return buildgen.Finish(container, m_prefixes, source);
+    return buildgen.Finish(container, m_prefixes, m_arch, source);
 }
 
 namespace {
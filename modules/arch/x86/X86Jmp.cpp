@@ -63,17 +63,17 @@ public:
 
     bool Finalize(Bytecode& bc, Diagnostic& diags);
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
     bool Expand(Bytecode& bc,
-                unsigned long* len,
+                uint64_t* len,
                 int span,
-                long old_val,
-                long new_val,
+                int64_t old_val,
+                int64_t new_val,
                 bool* keep,
-                /*@out@*/ long* neg_thres,
-                /*@out@*/ long* pos_thres,
+                /*@out@*/ int64_t* neg_thres,
+                /*@out@*/ int64_t* pos_thres,
                 Diagnostic& diags);
     bool Output(Bytecode& bc, BytecodeOutput& bc_out);
 
@@ -162,7 +162,7 @@ X86Jmp::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 X86Jmp::CalcLen(Bytecode& bc,
-                /*@out@*/ unsigned long* len,
+                /*@out@*/ uint64_t* len,
                 const Bytecode::AddSpanFunc& add_span,
                 Diagnostic& diags)
 {
@@ -177,7 +177,8 @@ X86Jmp::CalcLen(Bytecode& bc,
     {
         // Short or maybe long; generate span
         ilen += m_shortop.getLen() + 1;
-        add_span(bc, 1, m_target, -128+ilen, 127+ilen);
+        add_span(bc, 1, m_target, -128+static_cast<int64_t>(ilen),
+                 127+static_cast<int64_t>(ilen));
     }
     *len = ilen;
     return true;
@@ -185,13 +186,13 @@ X86Jmp::CalcLen(Bytecode& bc,
 
 bool
 X86Jmp::Expand(Bytecode& bc,
-               unsigned long* len,
+               uint64_t* len,
                int span,
-               long old_val,
-               long new_val,
+               int64_t old_val,
+               int64_t new_val,
                bool* keep,
-               /*@out@*/ long* neg_thres,
-               /*@out@*/ long* pos_thres,
+               /*@out@*/ int64_t* neg_thres,
+               /*@out@*/ int64_t* pos_thres,
                Diagnostic& diags)
 {
     assert(span == 1 && "unrecognized span id");
@@ -237,21 +238,23 @@ X86Jmp::Output(Bytecode& bc, BytecodeOutput& bc_out)
     unsigned long pos = bytes.size();
     bc_out.OutputBytes(bytes, bc.getSource());
 
-    // Adjust relative displacement to end of instruction
-    m_target.AddAbs(-static_cast<long>(pos+size));
-    m_target.setSize(size*8);
+    // Adjust relative displacement to end of instruction.  Work on a copy,
+    // as the bytecode may be output more than once.
+    Value target(m_target);
+    target.AddAbs(-static_cast<long>(pos+size));
+    target.setSize(size*8);
 
     // Distance from displacement to end of instruction is always 0.
-    m_target.setInsnStart(pos);
-    m_target.setNextInsn(0);
+    target.setInsnStart(pos);
+    target.setNextInsn(0);
 
     // Output displacement
     Location loc = {&bc, bc.getFixedLen()+bytes.size()};
     bytes.resize(0);
     bytes.resize(size);
     NumericOutput num_out(bytes);
-    m_target.ConfigureOutput(&num_out);
-    if (!bc_out.OutputValue(m_target, loc, num_out))
+    target.ConfigureOutput(&num_out);
+    if (!bc_out.OutputValue(target, loc, num_out))
         return false;
     return true;
 }
@@ -26,6 +26,8 @@
 //
 #include "DwarfCfi.h"
 
+#include "llvm/ADT/DenseMap.h"
+
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Parse/Directive.h"
 #include "yasmx/Parse/DirHelpers.h"
@@ -76,6 +78,61 @@ enum DwarfCfiPersonality
     DW_EH_PE_indirect = 0x80
 };
 
+// Personality routines are compared by symbol or by constant value;
+// anything more complex never matches.
+static bool
+isSamePersonality(const Expr& lhs, const Expr& rhs)
+{
+    if (lhs.isSymbol() && rhs.isSymbol())
+        return lhs.getSymbol() == rhs.getSymbol();
+    if (lhs.isIntNum() && rhs.isIntNum())
+        return lhs.getIntNum() == rhs.getIntNum();
+    return false;
+}
+
+static inline unsigned int
+HashCombine(unsigned int hash, unsigned long val)
+{
+    return hash ^ (static_cast<unsigned int>(val) + 0x9e3779b9U +
+                   (hash << 6) + (hash >> 2));
+}
+
+// Hash of everything IsFdeMatch compares: the CIE-level attributes and
+// the initial instructions (up to the first one that can't be in a CIE).
+static unsigned int
+HashCie(const DwarfCfiFde& fde)
+{
+    unsigned int hash = fde.m_personality_encoding;
+    hash = HashCombine(hash, fde.m_lsda_encoding);
+    hash = HashCombine(hash, fde.m_return_column);
+    hash = HashCombine(hash, fde.m_signal_frame);
+    if (fde.m_personality_encoding != DW_EH_PE_omit)
+    {
+        if (fde.m_personality.isSymbol())
+        {
+            hash = HashCombine(hash, reinterpret_cast<unsigned long>(
+                static_cast<Symbol*>(fde.m_personality.getSymbol())));
+        }
+        else if (fde.m_personality.isIntNum())
+            hash = HashCombine(hash, fde.m_personality.getIntNum().getInt());
+    }
+
+    for (stdx::ptr_vector<DwarfCfiInsn>::const_iterator
+         i = fde.m_insns.begin(), end = fde.m_insns.end(); i != end; ++i)
+    {
+        DwarfCfiInsn::Op op = i->getOp();
+        if (op == DwarfCfiInsn::DW_CFA_advance_loc ||
+            op == DwarfCfiInsn::DW_CFA_remember_state ||
+            op == DwarfCfiInsn::CFI_escape ||
+            op == DwarfCfiInsn::CFI_val_encoded_addr)
+            break;
+        hash = HashCombine(hash, i->getHashValue());
+    }
+
+    // Keep clear of the DenseMap empty and tombstone keys.
+    return hash & 0x7fffffffU;
+}
+
 class IsFdeMatch
 {
 public:
@@ -96,10 +153,9 @@ IsFdeMatch::operator() (const DwarfCfiCie& cie)
         cie.m_fde->m_signal_frame != m_fde.m_signal_frame)
         return false;
 
-    if (cie.m_fde->m_personality_encoding != DW_EH_PE_omit)
-    {
-        // check for equal personality
-    }
+    if (cie.m_fde->m_personality_encoding != DW_EH_PE_omit &&
+        !isSamePersonality(cie.m_fde->m_personality, m_fde.m_personality))
+        return false;
 
     // check for commonality in instructions
     stdx::ptr_vector<DwarfCfiInsn>::const_iterator
@@ -204,6 +260,35 @@ DwarfCfiInsn::operator== (const DwarfCfiInsn& oth) const
     }
 }
 
+unsigned int
+DwarfCfiInsn::getHashValue() const
+{
+    unsigned int hash = static_cast<unsigned int>(m_op);
+    switch (m_op)
+    {
+        case DW_CFA_offset:
+        case DW_CFA_offset_extended:
+        case DW_CFA_offset_extended_sf:
+        case DW_CFA_def_cfa:
+        case DW_CFA_def_cfa_sf:
+            return HashCombine(HashCombine(hash, m_regs[0]), m_off.getInt());
+        case DW_CFA_restore:
+        case DW_CFA_restore_extended:
+        case DW_CFA_undefined:
+        case DW_CFA_same_value:
+        case DW_CFA_def_cfa_register:
+            return HashCombine(hash, m_regs[0]);
+        case DW_CFA_register:
+            return HashCombine(HashCombine(hash, m_regs[0]), m_regs[1]);
+        case DW_CFA_def_cfa_offset:
+        case DW_CFA_def_cfa_offset_sf:
+        case DW_CFA_GNU_args_size:
+            return HashCombine(hash, m_off.getInt());
+        default:
+            return hash;
+    }
+}
+
 DwarfCfiInsn*
 DwarfCfiInsn::MakeOffset(unsigned int reg, const IntNum& off)
 {
@@ -665,8 +750,8 @@ DwarfCfiFde::Output(DwarfCfiOutput& out, DwarfCfiCie& cie, unsigned int align)
                         out.object.getSymbol(container.getEndLoc())))),
                    4, arch, m_source, out.diags);
     else
-        AppendData(container, Expr::Ptr(new Expr(start)), 4, arch, m_source,
-                   out.diags);
+        AppendData(container, Expr::Ptr(new Expr(start)), sizeof_address,
+                   arch, m_source, out.diags);
 
     // Code length
     AppendData(container,
@@ -1353,6 +1438,12 @@ DwarfDebug::GenerateCfiSection(ObjectFormat& ofmt,
     DwarfCfiOutput out(*sect, diags, *this, m_object, eh_frame);
     std::vector<DwarfCfiCie> cies;
 
+    // CIEs are looked up by HashCie(); CIEs with the same hash are chained
+    // through cie_next.
+    static const size_t NO_CIE = ~static_cast<size_t>(0);
+    llvm::DenseMap<unsigned int, size_t> cie_index;
+    std::vector<size_t> cie_next;
+
     for (FDEs::iterator i=m_fdes.begin(), end=m_fdes.end(); i != end; ++i)
     {
         if (!eh_frame)
@@ -1365,13 +1456,23 @@ DwarfDebug::GenerateCfiSection(ObjectFormat& ofmt,
 
         // Try to find an existing CIE that matches this FDE
         IsFdeMatch matcher(*i);
-        std::vector<DwarfCfiCie>::iterator ciep =
-            std::find_if(cies.begin(), cies.end(), matcher);
-        DwarfCfiCie* cie;
-        if (ciep != cies.end())
-            cie = &(*ciep);
-        else
+        unsigned int hash = HashCie(*i);
+        llvm::DenseMap<unsigned int, size_t>::iterator head =
+            cie_index.find(hash);
+        size_t first = (head != cie_index.end()) ? head->second : NO_CIE;
+        DwarfCfiCie* cie = 0;
+        for (size_t n = first; n != NO_CIE; n = cie_next[n])
+        {
+            if (matcher(cies[n]))
+            {
+                cie = &cies[n];
+                break;
+            }
+        }
+        if (!cie)
         {
+            cie_index[hash] = cies.size();
+            cie_next.push_back(first);
             cies.push_back(DwarfCfiCie(&(*i)));
             cie = &cies.back();
             cie->Output(out, eh_frame ? 4 : align);
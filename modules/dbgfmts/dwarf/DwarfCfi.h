@@ -138,6 +138,9 @@ public:
     bool operator== (const DwarfCfiInsn& oth) const;
     bool operator!= (const DwarfCfiInsn& oth) const { return !(*this == oth); }
 
+    /// Get a hash value consistent with operator==.
+    unsigned int getHashValue() const;
+
 private:
     DwarfCfiInsn(Op op);
     DwarfCfiInsn(Op op, const IntNum& off);
@@ -42,18 +42,22 @@
 using namespace yasm;
 using namespace yasm::dbgfmt;
 
-DwarfDebug::DwarfDebug(const DebugFormatModule& module, Object& object)
+DwarfDebug::DwarfDebug(const DebugFormatModule& module,
+                       Object& object,
+                       Format format)
     : DebugFormat(module, object)
-    , m_format(FORMAT_32BIT)    // TODO: flexible?
+    , m_first_unassigned(0)
+    , m_format(format)
     , m_sizeof_address(object.getArch()->getAddressSize()/8)
     , m_min_insn_len(object.getArch()->getModule().getMinInsnLen())
     , m_fdes_owner(m_fdes)
     , m_cur_fde(0)
 {
+    // The 64-bit format was introduced in DWARF 3.
     switch (m_format)
     {
-        case FORMAT_32BIT: m_sizeof_offset = 4; break;
-        case FORMAT_64BIT: m_sizeof_offset = 8; break;
+        case FORMAT_32BIT: m_sizeof_offset = 4; m_version = 2; break;
+        case FORMAT_64BIT: m_sizeof_offset = 8; m_version = 3; break;
     }
     InitCfi(*object.getArch());
 }
@@ -108,6 +112,26 @@ DwarfPassDebug::~DwarfPassDebug()
 {
 }
 
+Dwarf64Debug::~Dwarf64Debug()
+{
+}
+
+bool
+Dwarf64Debug::isOkObject(Object& object)
+{
+    return object.getArch()->getAddressSize() == 64;
+}
+
+Dwarf64PassDebug::~Dwarf64PassDebug()
+{
+}
+
+bool
+Dwarf64PassDebug::isOkObject(Object& object)
+{
+    return object.getArch()->getAddressSize() == 64;
+}
+
 void
 DwarfPassDebug::Generate(ObjectFormat& objfmt,
                          SourceManager& smgr,
@@ -124,6 +148,7 @@ DwarfPassDebug::Generate(ObjectFormat& objfmt,
 
 Location
 DwarfDebug::AppendHead(Section& sect,
+                       unsigned int version,
                        /*@null@*/ Section* debug_ptr,
                        bool with_address,
                        bool with_segment)
@@ -142,7 +167,7 @@ DwarfDebug::AppendHead(Section& sect,
     AppendData(sect, 0, m_sizeof_offset, *m_object.getArch());
 
     // DWARF version
-    AppendData(sect, 2, 2, *m_object.getArch());
+    AppendData(sect, version, 2, *m_object.getArch());
 
     // Pointer to another debug section
     if (debug_ptr)
@@ -233,6 +258,10 @@ yasm_dbgfmt_dwarf_DoRegister()
                    DebugFormatModuleImpl<DwarfDebug> >("dwarf2");
     RegisterModule<DebugFormatModule,
                    DebugFormatModuleImpl<DwarfPassDebug> >("dwarf2pass");
+    RegisterModule<DebugFormatModule,
+                   DebugFormatModuleImpl<Dwarf64Debug> >("dwarf64");
+    RegisterModule<DebugFormatModule,
+                   DebugFormatModuleImpl<Dwarf64PassDebug> >("dwarf64pass");
     RegisterModule<DebugFormatModule,
                    DebugFormatModuleImpl<ElfCfiDebug> >("elfcfi");
 }
@@ -28,6 +28,8 @@
 //
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "yasmx/Basic/SourceLocation.h"
 #include "yasmx/Config/export.h"
 #include "yasmx/DebugFormat.h"
@@ -47,12 +49,19 @@ class Section;
 
 namespace dbgfmt {
 struct DwarfLoc;
-struct DwarfLineState;
 
 class YASM_STD_EXPORT DwarfDebug : public DebugFormat
 {
 public:
-    DwarfDebug(const DebugFormatModule& module, Object& object);
+    enum Format
+    {
+        FORMAT_32BIT,
+        FORMAT_64BIT
+    };
+
+    DwarfDebug(const DebugFormatModule& module,
+               Object& object,
+               Format format = FORMAT_32BIT);
     ~DwarfDebug();
 
     static llvm::StringRef getName() { return "DWARF debugging format"; }
@@ -96,17 +105,19 @@ private:
 
     typedef std::vector<std::string> Dirs;
     Dirs m_dirs;
+    llvm::StringMap<unsigned long> m_dir_index;     ///< dirname to m_dirs
 
     typedef std::vector<Filename> Filenames;
     Filenames m_filenames;
-
-    enum Format
-    {
-        FORMAT_32BIT,
-        FORMAT_64BIT
-    };
+    /// Lowest filename entry matching each filename/directory pair.
+    llvm::StringMap<size_t> m_filename_index;
+    /// Filename entries added for source manager files.
+    llvm::DenseMap<const FileEntry*, size_t> m_file_entries;
+    /// Lowest filename entry not yet assigned (m_filenames.size() if none).
+    size_t m_first_unassigned;
 
     Format m_format;
+    unsigned int m_version;     ///< .debug_info and .debug_line version
 
     unsigned int m_sizeof_address, m_sizeof_offset, m_min_insn_len;
 
@@ -182,16 +193,6 @@ private:
                            bool asm_source,
                            /*@out@*/ Section** main_code,
                            /*@out@*/ size_t* num_line_sections);
-    void AppendLineOp(BytecodeContainer& container,
-                      unsigned int opcode);
-    void AppendLineOp(BytecodeContainer& container,
-                      unsigned int opcode,
-                      const IntNum& operand);
-    void AppendLineExtOp(BytecodeContainer& container,
-                         DwarfLineNumberExtOp ext_opcode);
-    void AppendLineExtOp(BytecodeContainer& container,
-                         DwarfLineNumberExtOp ext_opcode,
-                         const IntNum& operand);
     void AppendLineExtOp(BytecodeContainer& container,
                          DwarfLineNumberExtOp ext_opcode,
                          unsigned long ext_operandsize,
@@ -202,16 +203,6 @@ private:
                              bool asm_source,
                              Section** last_code,
                              size_t* num_line_sections);
-    void GenerateLineOp(Section& debug_line,
-                        DwarfLineState* state,
-                        const DwarfLoc& loc,
-                        const DwarfLoc* nextloc);
-    void GenerateLineBC(Section& debug_line,
-                        SourceManager& smgr,
-                        DwarfLineState* state,
-                        Bytecode& bc,
-                        DwarfLoc* loc,
-                        unsigned long* lastfile);
     /// Append statement program prologue
     void AppendSPP(BytecodeContainer& container);
 
@@ -229,6 +220,7 @@ private:
     /// Append a debug header.
     /// @return The location of the aranges length field (used by setHeadLength).
     Location AppendHead(Section& sect,
+                        unsigned int version,
                         /*@null@*/ Section* debug_ptr,
                         bool with_address,
                         bool with_segment);
@@ -242,13 +234,17 @@ private:
     size_t AddFile(unsigned long filenum, llvm::StringRef pathname);
     size_t AddFile(const FileEntry* file);
     unsigned long AddDir(llvm::StringRef dirname);
+    void IndexFile(size_t filenum);
+    void UnindexFile(size_t filenum);
 };
 
 class YASM_STD_EXPORT DwarfPassDebug : public DwarfDebug
 {
 public:
-    DwarfPassDebug(const DebugFormatModule& module, Object& object)
-        : DwarfDebug(module, object)
+    DwarfPassDebug(const DebugFormatModule& module,
+                   Object& object,
+                   Format format = FORMAT_32BIT)
+        : DwarfDebug(module, object, format)
     {}
     ~DwarfPassDebug();
 
@@ -259,6 +255,33 @@ public:
     void Generate(ObjectFormat& objfmt, SourceManager& smgr, Diagnostic& diags);
 };
 
+class YASM_STD_EXPORT Dwarf64Debug : public DwarfDebug
+{
+public:
+    Dwarf64Debug(const DebugFormatModule& module, Object& object)
+        : DwarfDebug(module, object, FORMAT_64BIT)
+    {}
+    ~Dwarf64Debug();
+
+    static llvm::StringRef getName() { return "64-bit DWARF debugging format"; }
+    static llvm::StringRef getKeyword() { return "dwarf64"; }
+    static bool isOkObject(Object& object);
+};
+
+class YASM_STD_EXPORT Dwarf64PassDebug : public DwarfPassDebug
+{
+public:
+    Dwarf64PassDebug(const DebugFormatModule& module, Object& object)
+        : DwarfPassDebug(module, object, FORMAT_64BIT)
+    {}
+    ~Dwarf64PassDebug();
+
+    static llvm::StringRef getName()
+    { return "64-bit DWARF passthrough only"; }
+    static llvm::StringRef getKeyword() { return "dwarf64pass"; }
+    static bool isOkObject(Object& object);
+};
+
 class YASM_STD_EXPORT ElfCfiDebug : public DwarfDebug
 {
 public:
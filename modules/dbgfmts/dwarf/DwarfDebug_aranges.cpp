@@ -58,9 +58,9 @@ DwarfDebug::Generate_aranges(Section& debug_info)
         debug_aranges->setAlign(2*m_sizeof_address);
     }
 
-    // header
-    Location head = AppendHead(*debug_aranges, &debug_info, true, true);
-    AppendAlign(*debug_aranges, Expr(m_sizeof_address), Expr(), Expr(), 0,
+    // header (version 2 in both DWARF 2 and 3), padded to the range size
+    Location head = AppendHead(*debug_aranges, 2, &debug_info, true, true);
+    AppendAlign(*debug_aranges, Expr(2*m_sizeof_address), Expr(), Expr(), 0,
                 SourceLocation());
 
     for (Object::section_iterator i=m_object.sections_begin(),
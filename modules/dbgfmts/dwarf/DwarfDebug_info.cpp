@@ -82,7 +82,8 @@ DwarfDebug::Generate_info(Section& debug_line, Section* main_code)
     AppendAbbrevHeader(abbrev, 1, DW_TAG_compile_unit, false);
 
     // info header
-    Location head = AppendHead(debug_info, &debug_abbrev, true, false);
+    Location head = AppendHead(debug_info, m_version, &debug_abbrev, true,
+                               false);
 
     // Generate abbreviations at the same time as info (since they're linked
     // and we're only generating one piece of info).
@@ -91,7 +92,8 @@ DwarfDebug::Generate_info(Section& debug_line, Section* main_code)
     AppendLEB128(debug_info, 1, false, SourceLocation(), *m_diags);
 
     // statement list (line numbers)
-    AppendAbbrevAttr(abbrev, DW_AT_stmt_list, DW_FORM_data4);
+    AppendAbbrevAttr(abbrev, DW_AT_stmt_list,
+                     m_format == FORMAT_64BIT ? DW_FORM_data8 : DW_FORM_data4);
     AppendData(debug_info, Expr::Ptr(new Expr(debug_line.getSymbol())),
                m_sizeof_offset, *m_object.getArch(), SourceLocation(),
                *m_diags);
@@ -29,8 +29,7 @@
 //
 #include "DwarfDebug.h"
 
-#include <algorithm>
-
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/System/Path.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/FileManager.h"
@@ -39,6 +38,7 @@
 #include "yasmx/Parse/NameValue.h"
 #include "yasmx/Bytecode.h"
 #include "yasmx/BytecodeContainer.h"
+#include "yasmx/BytecodeOutput.h"
 #include "yasmx/Bytes_leb128.h"
 #include "yasmx/Bytes_util.h"
 #include "yasmx/Expr.h"
@@ -86,82 +86,347 @@ static const int DWARF_LINE_RANGE = 14;
 // Initial value of is_stmt register
 #define DWARF_LINE_DEFAULT_IS_STMT      1
 
-namespace yasm { namespace dbgfmt {
-// Line number state machine register state
-struct DwarfLineState
-{
-    // DWARF state machine registers
-    unsigned long address;
-    unsigned long file;
-    unsigned long line;
-    unsigned long column;
-    unsigned long isa;
-    bool is_stmt;
-
-    // other state information
-    Location prevloc;
-};
-}} // namespace yasm::dbgfmt
-
 namespace {
-class MatchFileDir
+/// Statement program for the rows of a single code section.  Code section
+/// layout is final by the time debug information is generated, so rather
+/// than appending each opcode separately, the whole sequence is encoded in
+/// one pass over the row offsets.
+class DwarfLineProgram : public Bytecode::Contents
 {
 public:
-    MatchFileDir(llvm::StringRef name, unsigned long dir)
-        : m_name(name), m_dir(dir)
+    DwarfLineProgram(const Section& sect,
+                     const DwarfSection::Locs* locs,
+                     unsigned int min_insn_len)
+        : m_sect(&sect)
+        , m_locs(locs)
+        , m_min_insn_len(min_insn_len)
     {}
 
-    bool operator() (const DwarfDebug::Filename& file)
-    {
-        if (file.filename.empty())
-            return true;
-        return (m_dir == file.dir && m_name == file.filename);
-    }
+    /// Finalizes the bytecode after parsing.
+    bool Finalize(Bytecode& bc, Diagnostic& diags) { return true; }
+
+    /// Calculates the minimum size of a bytecode.
+    bool CalcLen(Bytecode& bc,
+                 /*@out@*/ uint64_t* len,
+                 const Bytecode::AddSpanFunc& add_span,
+                 Diagnostic& diags);
+
+    /// Convert a bytecode into its byte representation.
+    bool Output(Bytecode& bc, BytecodeOutput& bc_out);
+
+    llvm::StringRef getType() const;
+
+    DwarfLineProgram* clone() const;
+
+#ifdef WITH_XML
+    /// Write an XML representation.  For debugging purposes.
+    pugi::xml_node Write(pugi::xml_node out) const;
+#endif // WITH_XML
 
 private:
-    llvm::StringRef m_name;
-    unsigned long m_dir;
+    void Encode(Bytes& bytes) const;
+
+    const Section* m_sect;              ///< Code section
+    const DwarfSection::Locs* m_locs;   ///< Rows (NULL if none)
+    unsigned int m_min_insn_len;        ///< Minimum instruction length
+    Bytes m_program;                    ///< Encoded statement program
 };
 } // anonymous namespace
 
+static inline void
+WriteLineOp(Bytes& bytes, unsigned int opcode, const IntNum& operand)
+{
+    Write8(bytes, opcode);
+    WriteLEB128(bytes, operand, opcode == DW_LNS_advance_line);
+}
+
+void
+DwarfLineProgram::Encode(Bytes& bytes) const
+{
+    // initialize state machine registers for the sequence
+    unsigned long file = 1;
+    unsigned long line = 1;
+    unsigned long column = 0;
+    bool is_stmt = DWARF_LINE_DEFAULT_IS_STMT;
+
+    // The first row is always emitted with a zero address delta, as the
+    // sequence address is set to the start of the section.
+    uint64_t prev = 0;
+    bool first = true;
+
+    if (m_locs)
+    {
+        for (DwarfSection::Locs::const_iterator i=m_locs->begin(),
+             end=m_locs->end(); i != end; ++i)
+        {
+            const DwarfLoc& loc = *i;
+
+            if (file != loc.file)
+            {
+                file = loc.file;
+                WriteLineOp(bytes, DW_LNS_set_file, file);
+            }
+            if (column != loc.column)
+            {
+                column = loc.column;
+                WriteLineOp(bytes, DW_LNS_set_column, column);
+            }
+            if (loc.discriminator != 0)
+            {
+                Write8(bytes, DW_LNS_extended_op);
+                WriteULEB128(bytes, 1 + SizeULEB128(loc.discriminator));
+                Write8(bytes, DW_LNE_set_discriminator);
+                WriteULEB128(bytes, loc.discriminator);
+            }
+#ifdef WITH_DWARF3
+            if (loc.isa_change)
+                WriteLineOp(bytes, DW_LNS_set_isa, loc.isa);
+#endif
+            if ((!is_stmt && loc.is_stmt == DwarfLoc::IS_STMT_SET) ||
+                (is_stmt && loc.is_stmt == DwarfLoc::IS_STMT_CLEAR))
+            {
+                is_stmt = !is_stmt;
+                Write8(bytes, DW_LNS_negate_stmt);
+            }
+            if (loc.basic_block)
+                Write8(bytes, DW_LNS_set_basic_block);
+#ifdef WITH_DWARF3
+            if (loc.prologue_end)
+                Write8(bytes, DW_LNS_set_prologue_end);
+            if (loc.epilogue_begin)
+                Write8(bytes, DW_LNS_set_epilogue_begin);
+#endif
+
+            uint64_t addr = loc.loc.getOffset();
+            uint64_t addr_delta = 0;
+            if (!first)
+            {
+                assert(addr >= prev && "dwarf2 address went backwards");
+                addr_delta = addr - prev;
+            }
+            first = false;
+            prev = addr;
+
+            // Generate appropriate opcode(s).  Address can only increment,
+            // whereas line number can go backwards.
+            int64_t line_delta = static_cast<int64_t>(loc.line) -
+                                 static_cast<int64_t>(line);
+            line = loc.line;
+
+            // First handle the line delta
+            if (line_delta < DWARF_LINE_BASE
+                || line_delta >= DWARF_LINE_BASE+DWARF_LINE_RANGE)
+            {
+                // Won't fit in special opcode, use (signed) line advance
+                WriteLineOp(bytes, DW_LNS_advance_line, line_delta);
+                line_delta = 0;
+            }
+
+            // Next handle the address delta
+            int64_t special =
+                DWARF_LINE_OPCODE_BASE + line_delta - DWARF_LINE_BASE;
+            if (line_delta == 0 && addr_delta == 0)
+            {
+                // Both line and addr deltas are 0: do DW_LNS_copy
+                Write8(bytes, DW_LNS_copy);
+            }
+            else if (addr_delta <= DWARF_MAX_SPECIAL_ADDR_DELTA &&
+                     special + DWARF_LINE_RANGE *
+                        static_cast<int64_t>(addr_delta/m_min_insn_len) <= 255)
+            {
+                // Addr delta in range of special opcode
+                Write8(bytes, special + DWARF_LINE_RANGE *
+                       static_cast<int64_t>(addr_delta/m_min_insn_len));
+            }
+            else if (addr_delta >= DWARF_MAX_SPECIAL_ADDR_DELTA &&
+                     addr_delta <= 2*DWARF_MAX_SPECIAL_ADDR_DELTA &&
+                     special + DWARF_LINE_RANGE * static_cast<int64_t>(
+                        (addr_delta-DWARF_MAX_SPECIAL_ADDR_DELTA) /
+                        m_min_insn_len) <= 255)
+            {
+                // Addr delta in range of const_add_pc + special
+                Write8(bytes, DW_LNS_const_add_pc);
+                Write8(bytes, special + DWARF_LINE_RANGE *
+                       static_cast<int64_t>(
+                           (addr_delta-DWARF_MAX_SPECIAL_ADDR_DELTA) /
+                           m_min_insn_len));
+            }
+            else
+            {
+                // Need advance_pc
+                WriteLineOp(bytes, DW_LNS_advance_pc, addr_delta);
+                // Take care of any remaining line_delta and add entry to
+                // matrix
+                if (line_delta == 0)
+                    Write8(bytes, DW_LNS_copy);
+                else
+                    Write8(bytes, special);
+            }
+        }
+    }
+
+    // End sequence: bring address to end of section, then output end
+    // sequence opcode.  Don't use a special opcode to do this as we don't
+    // want an extra entry in the line matrix.
+    uint64_t addr_delta = m_sect->bytecodes_back().getNextOffset() - prev;
+    if (addr_delta == DWARF_MAX_SPECIAL_ADDR_DELTA)
+        Write8(bytes, DW_LNS_const_add_pc);
+    else if (addr_delta > 0)
+        WriteLineOp(bytes, DW_LNS_advance_pc, addr_delta);
+    Write8(bytes, DW_LNS_extended_op);
+    WriteULEB128(bytes, 1);
+    Write8(bytes, DW_LNE_end_sequence);
+}
+
+bool
+DwarfLineProgram::CalcLen(Bytecode& bc,
+                          /*@out@*/ uint64_t* len,
+                          const Bytecode::AddSpanFunc& add_span,
+                          Diagnostic& diags)
+{
+    m_program.clear();
+    Encode(m_program);
+    *len = m_program.size();
+    return true;
+}
+
+bool
+DwarfLineProgram::Output(Bytecode& bc, BytecodeOutput& bc_out)
+{
+    bc_out.OutputBytes(m_program, bc.getSource());
+    return true;
+}
+
+llvm::StringRef
+DwarfLineProgram::getType() const
+{
+    return "yasm::dbgfmt::DwarfLineProgram";
+}
+
+DwarfLineProgram*
+DwarfLineProgram::clone() const
+{
+    return new DwarfLineProgram(*this);
+}
+
+#ifdef WITH_XML
+pugi::xml_node
+DwarfLineProgram::Write(pugi::xml_node out) const
+{
+    pugi::xml_node root = out.append_child("DwarfLineProgram");
+    root.append_attribute("rows") =
+        static_cast<unsigned int>(m_locs ? m_locs->size() : 0);
+    root.append_attribute("min_insn_len") = m_min_insn_len;
+    return root;
+}
+#endif // WITH_XML
+
+// Key for m_filename_index.
+static std::string
+FileKey(llvm::StringRef filename, unsigned long dir)
+{
+    std::string key = filename;
+    key += '\0';
+    key += llvm::utostr(dir);
+    return key;
+}
+
 unsigned long
 DwarfDebug::AddDir(llvm::StringRef dirname)
 {
     // Put the directory into the directory table (checking for duplicates)
-    Dirs::iterator d =
-        std::find(m_dirs.begin(), m_dirs.end(), dirname);
-    if (d != m_dirs.end())
-        return d-m_dirs.begin();
+    llvm::StringMapEntry<unsigned long>& entry =
+        m_dir_index.GetOrCreateValue(dirname, m_dirs.size());
+    if (entry.getValue() == m_dirs.size())
+        m_dirs.push_back(dirname);
+    return entry.getValue();
+}
+
+// Record a newly assigned filename entry in the filename index.
+void
+DwarfDebug::IndexFile(size_t filenum)
+{
+    const Filename& file = m_filenames[filenum];
+    if (file.filename.empty())
+    {
+        if (filenum < m_first_unassigned)
+            m_first_unassigned = filenum;
+        return;
+    }
+
+    llvm::StringMapEntry<size_t>& entry =
+        m_filename_index.GetOrCreateValue(FileKey(file.filename, file.dir),
+                                          filenum);
+    if (filenum < entry.getValue())
+        entry.setValue(filenum);
+
+    while (m_first_unassigned < m_filenames.size() &&
+           !m_filenames[m_first_unassigned].filename.empty())
+        ++m_first_unassigned;
+}
+
+// Remove a filename entry that is about to be overwritten from the filename
+// index.
+void
+DwarfDebug::UnindexFile(size_t filenum)
+{
+    const Filename& file = m_filenames[filenum];
+    if (file.filename.empty())
+        return;
+
+    llvm::StringMap<size_t>::iterator entry =
+        m_filename_index.find(FileKey(file.filename, file.dir));
+    if (entry == m_filename_index.end() || entry->getValue() != filenum)
+        return;
 
-    m_dirs.push_back(dirname);
-    return m_dirs.size()-1;
+    // Fall back to a later duplicate, if any.
+    for (size_t i=filenum+1, end=m_filenames.size(); i != end; ++i)
+    {
+        if (m_filenames[i].dir == file.dir &&
+            m_filenames[i].filename == file.filename)
+        {
+            entry->setValue(i);
+            return;
+        }
+    }
+    m_filename_index.erase(entry);
 }
 
 size_t
 DwarfDebug::AddFile(const FileEntry* file)
 {
-    unsigned long dir = AddDir(file->getDir()->getName());
+    llvm::DenseMap<const FileEntry*, size_t>::iterator known =
+        m_file_entries.find(file);
+    if (known != m_file_entries.end())
+    {
+        // Check the entry hasn't been reassigned since.
+        const Filename& f = m_filenames[known->second];
+        if (f.filename == file->getName() &&
+            m_dirs[f.dir] == file->getDir()->getName())
+            return known->second;
+    }
 
-    // Put the filename into the filename table (checking for duplicates)
-    Filenames::iterator f = std::find_if(m_filenames.begin(), m_filenames.end(),
-                                         MatchFileDir(file->getName(), dir));
+    unsigned long dir = AddDir(file->getDir()->getName());
 
-    size_t filenum;
-    if (f != m_filenames.end())
+    // Put the filename into the filename table (checking for duplicates);
+    // the first unassigned entry is used if it comes before any duplicate.
+    size_t filenum = m_first_unassigned;
+    llvm::StringMap<size_t>::const_iterator f =
+        m_filename_index.find(FileKey(file->getName(), dir));
+    if (f != m_filename_index.end() && f->getValue() < filenum)
     {
-        filenum = f-m_filenames.begin();
-        if (!f->filename.empty())
-            return filenum;
+        m_file_entries[file] = f->getValue();
+        return f->getValue();
     }
-    else
-    {
-        filenum = m_filenames.size();
+
+    if (filenum == m_filenames.size())
         m_filenames.push_back(Filename());
-    }
     m_filenames[filenum].filename = file->getName();
     m_filenames[filenum].dir = dir;
     m_filenames[filenum].time = file->getModificationTime();
     m_filenames[filenum].length = file->getSize();
+    IndexFile(filenum);
+    m_file_entries[file] = filenum;
     return filenum;
 }
 
@@ -179,6 +444,8 @@ DwarfDebug::AddFile(unsigned long filenum, llvm::StringRef pathname)
     // Ensure table is sufficient size
     if (filenum >= m_filenames.size())
         m_filenames.resize(filenum+1);
+    else
+        UnindexFile(filenum);
 
     // Save in table
     m_filenames[filenum].pathname = pathname;
@@ -186,50 +453,12 @@ DwarfDebug::AddFile(unsigned long filenum, llvm::StringRef pathname)
     m_filenames[filenum].dir = dir;
     m_filenames[filenum].time = 0;
     m_filenames[filenum].length = 0;
+    IndexFile(filenum);
 
     return filenum;
 }
 
-// Create and add a new line opcode to a section.
-void
-DwarfDebug::AppendLineOp(BytecodeContainer& container,
-                          unsigned int opcode)
-{
-    AppendByte(container, opcode);
-}
-
-void
-DwarfDebug::AppendLineOp(BytecodeContainer& container,
-                          unsigned int opcode,
-                          const IntNum& operand)
-{
-    AppendByte(container, opcode);
-    AppendLEB128(container, operand, opcode == DW_LNS_advance_line,
-                 SourceLocation(), *m_diags);
-}
-
 // Create and add a new extended line opcode to a section.
-void
-DwarfDebug::AppendLineExtOp(BytecodeContainer& container,
-                            DwarfLineNumberExtOp ext_opcode)
-{
-    AppendByte(container, DW_LNS_extended_op);
-    AppendLEB128(container, 1, false, SourceLocation(), *m_diags);
-    AppendByte(container, ext_opcode);
-}
-
-void
-DwarfDebug::AppendLineExtOp(BytecodeContainer& container,
-                            DwarfLineNumberExtOp ext_opcode,
-                            const IntNum& operand)
-{
-    AppendByte(container, DW_LNS_extended_op);
-    AppendLEB128(container, 1 + SizeLEB128(operand, false), false,
-                 SourceLocation(), *m_diags);
-    AppendByte(container, ext_opcode);
-    AppendLEB128(container, operand, false, SourceLocation(), *m_diags);
-}
-
 void
 DwarfDebug::AppendLineExtOp(BytecodeContainer& container,
                             DwarfLineNumberExtOp ext_opcode,
@@ -244,165 +473,6 @@ DwarfDebug::AppendLineExtOp(BytecodeContainer& container,
                *m_object.getArch(), SourceLocation(), *m_diags);
 }
 
-void
-DwarfDebug::GenerateLineOp(Section& debug_line,
-                           DwarfLineState* state,
-                           const DwarfLoc& loc,
-                           const DwarfLoc* nextloc)
-{
-    if (state->file != loc.file)
-    {
-        state->file = loc.file;
-        AppendLineOp(debug_line, DW_LNS_set_file, state->file);
-    }
-    if (state->column != loc.column)
-    {
-        state->column = loc.column;
-        AppendLineOp(debug_line, DW_LNS_set_column, state->column);
-    }
-    if (loc.discriminator != 0)
-    {
-        AppendLineExtOp(debug_line, DW_LNE_set_discriminator,
-                        loc.discriminator);
-    }
-#ifdef WITH_DWARF3
-    if (loc.isa_change)
-    {
-        state->isa = loc.isa;
-        AppendLineOp(debug_line, DW_LNS_set_isa, state->isa);
-    }
-#endif
-    if (!state->is_stmt && loc.is_stmt == DwarfLoc::IS_STMT_SET)
-    {
-        state->is_stmt = true;
-        AppendLineOp(debug_line, DW_LNS_negate_stmt);
-    }
-    else if (state->is_stmt && loc.is_stmt == DwarfLoc::IS_STMT_CLEAR)
-    {
-        state->is_stmt = false;
-        AppendLineOp(debug_line, DW_LNS_negate_stmt);
-    }
-    if (loc.basic_block)
-    {
-        AppendLineOp(debug_line, DW_LNS_set_basic_block);
-    }
-#ifdef WITH_DWARF3
-    if (loc.prologue_end)
-    {
-        AppendLineOp(debug_line, DW_LNS_set_prologue_end);
-    }
-    if (loc.epilogue_begin)
-    {
-        AppendLineOp(debug_line, DW_LNS_set_epilogue_begin);
-    }
-#endif
-
-    IntNum addr_delta;
-    if (!state->prevloc.bc)
-    {
-        addr_delta.Zero();
-    }
-    else
-    {
-        CalcDist(state->prevloc, loc.loc, &addr_delta);
-        assert(addr_delta.getSign() >= 0 && "dwarf2 address went backwards");
-    }
-
-    // Generate appropriate opcode(s).  Address can only increment,
-    // whereas line number can go backwards.
-    IntNum line_delta = loc.line;
-    line_delta -= state->line;
-    state->line = loc.line;
-
-    // First handle the line delta
-    if (line_delta < DWARF_LINE_BASE
-        || line_delta >= DWARF_LINE_BASE+DWARF_LINE_RANGE)
-    {
-        // Won't fit in special opcode, use (signed) line advance
-        AppendLineOp(debug_line, DW_LNS_advance_line, line_delta);
-        line_delta.Zero();
-    }
-
-    // Next handle the address delta
-    int opcode1, opcode2;
-    opcode1 = opcode2 =
-        DWARF_LINE_OPCODE_BASE + line_delta.getInt() - DWARF_LINE_BASE;
-    opcode1 += DWARF_LINE_RANGE * (addr_delta.getUInt() / m_min_insn_len);
-    opcode2 += DWARF_LINE_RANGE *
-        ((addr_delta.getUInt() - DWARF_MAX_SPECIAL_ADDR_DELTA) / m_min_insn_len);
-    if (line_delta.isZero() && addr_delta.isZero())
-    {
-        // Both line and addr deltas are 0: do DW_LNS_copy
-        AppendLineOp(debug_line, DW_LNS_copy);
-    }
-    else if (addr_delta.getUInt() <= DWARF_MAX_SPECIAL_ADDR_DELTA &&
-             opcode1 <= 255)
-    {
-        // Addr delta in range of special opcode
-        AppendLineOp(debug_line, opcode1);
-    }
-    else if (addr_delta.getUInt() <= 2*DWARF_MAX_SPECIAL_ADDR_DELTA &&
-             opcode2 <= 255)
-    {
-        // Addr delta in range of const_add_pc + special
-        AppendLineOp(debug_line, DW_LNS_const_add_pc);
-        AppendLineOp(debug_line, opcode2);
-    }
-    else
-    {
-        // Need advance_pc
-        AppendLineOp(debug_line, DW_LNS_advance_pc, addr_delta);
-        // Take care of any remaining line_delta and add entry to matrix
-        if (line_delta.isZero())
-            AppendLineOp(debug_line, DW_LNS_copy);
-        else
-        {
-            AppendLineOp(debug_line, DWARF_LINE_OPCODE_BASE +
-                                     line_delta.getInt() - DWARF_LINE_BASE);
-        }
-    }
-    state->prevloc = loc.loc;
-}
-#if 0
-void
-DwarfDebug::GenerateLineBC(Section& debug_line,
-                           SourceManager& smgr,
-                           DwarfLineState* state,
-                           Bytecode& bc,
-                           DwarfLoc* loc,
-                           unsigned long* lastfile)
-{
-    unsigned long i;
-    const char *filename;
-    /*@null@*/ yasm_bytecode *nextbc = yasm_bc__next(bc);
-
-    if (nextbc && bc->offset == nextbc->offset)
-        return 0;
-
-    info->loc.vline = bc->line;
-    info->loc.bc = bc;
-
-    yasm_linemap_lookup(info->linemap, bc->line, &filename, &info->loc.line);
-    // Find file index; just linear search it unless it was the last used
-    if (*lastfile > 0 && filename == m_filenames[*lastfile-1].pathname)
-        loc->file = *lastfile;
-    else
-    {
-        for (i=0; i<dbgfmt_dwarf2->filenames_size; i++)
-        {
-            if (strcmp(filename, dbgfmt_dwarf2->filenames[i].pathname) == 0)
-                break;
-        }
-        if (i >= dbgfmt_dwarf2->filenames_size)
-            yasm_internal_error(N_("could not find filename in table"));
-        info->loc.file = i+1;
-        info->lastfile = i+1;
-    }
-    if (GenerateLineOp(debug_line, state, loc, NULL))
-        return 1;
-    return 0;
-}
-#endif
 void
 DwarfDebug::GenerateLineSection(Section& sect,
                                 Section& debug_line,
@@ -424,55 +494,15 @@ DwarfDebug::GenerateLineSection(Section& sect,
     ++(*num_line_sections);
     *last_code = &sect;
 
-    // initialize state machine registers for each sequence
-    DwarfLineState state;
-    state.address = 0;
-    state.file = 1;
-    state.line = 1;
-    state.column = 0;
-    state.isa = 0;
-    state.is_stmt = DWARF_LINE_DEFAULT_IS_STMT;
-    state.prevloc.bc = NULL;
-
     // Set the starting address for the section
     AppendLineExtOp(debug_line, DW_LNE_set_address, m_sizeof_address,
                     sect.getSymbol());
 
-    if (asm_source)
-    {
-#if 0
-        unsigned long lastfile = 0;
-        DwarfLoc loc;
-
-        for (Section::bc_iterator i=sect.bytecodes_begin(),
-             end=sect.bytecodes_end(); i != end; ++i)
-        {
-            GenerateLineBC(debug_line, smgr, &state, *i, &loc, &lastfile);
-        }
-#endif
-    }
-    else
-    {
-        for (DwarfSection::Locs::const_iterator i=dwarf2sect->locs.begin(),
-             end=dwarf2sect->locs.end(); i != end; ++i)
-        {
-            DwarfSection::Locs::const_iterator next = i+1;
-            GenerateLineOp(debug_line, &state, *i, next != end ? &*next : 0);
-        }
-    }
-
-    // End sequence: bring address to end of section, then output end
-    // sequence opcode.  Don't use a special opcode to do this as we don't
-    // want an extra entry in the line matrix.
-    if (!state.prevloc.bc)
-        state.prevloc = sect.getBeginLoc();
-    IntNum addr_delta;
-    CalcDist(state.prevloc, sect.getEndLoc(), &addr_delta);
-    if (addr_delta == DWARF_MAX_SPECIAL_ADDR_DELTA)
-        AppendLineOp(debug_line, DW_LNS_const_add_pc);
-    else if (addr_delta > 0)
-        AppendLineOp(debug_line, DW_LNS_advance_pc, addr_delta);
-    AppendLineExtOp(debug_line, DW_LNE_end_sequence);
+    // The rest of the sequence is encoded once section offsets are final.
+    // For asm source there are no rows; just end the sequence.
+    Bytecode& bc = debug_line.FreshBytecode();
+    bc.Transform(Bytecode::Contents::Ptr(new DwarfLineProgram(
+        sect, asm_source ? 0 : &dwarf2sect->locs, m_min_insn_len)));
 }
 
 Section&
@@ -500,7 +530,7 @@ DwarfDebug::Generate_line(SourceManager& smgr,
     }
 
     // header
-    Location head = AppendHead(*debug_line, NULL, false, false);
+    Location head = AppendHead(*debug_line, m_version, NULL, false, false);
 
     // statement program prologue
     AppendSPP(*debug_line);
@@ -515,9 +545,11 @@ DwarfDebug::Generate_line(SourceManager& smgr,
                             num_line_sections);
     }
 
-    // mark end of line information
-    debug_line->UpdateOffsets(*m_diags);
-    setHeadEnd(head, debug_line->getEndLoc());
+    // mark end of line information; optimizing also encodes the line
+    // programs
+    Location end = debug_line->getEndLoc();
+    debug_line->Optimize(*m_diags);
+    setHeadEnd(head, end);
 
     if (*num_line_sections == 1)
         *main_code = last_code;
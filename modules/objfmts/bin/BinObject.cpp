@@ -26,6 +26,8 @@
 //
 #include "BinObject.h"
 
+#include <vector>
+
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
 #include "yasmx/Basic/Diagnostic.h"
@@ -44,6 +46,7 @@
 #include "yasmx/IntNum.h"
 #include "yasmx/Object.h"
 #include "yasmx/Section.h"
+#include "yasmx/SectionRenderer.h"
 #include "yasmx/Symbol.h"
 #include "yasmx/Value.h"
 
@@ -106,10 +109,10 @@ namespace {
 class BinOutput : public BytecodeStreamOutput
 {
 public:
-    BinOutput(llvm::raw_fd_ostream& os, Object& object, Diagnostic& diags);
+    BinOutput(llvm::raw_ostream& os, Object& object, Diagnostic& diags);
     ~BinOutput();
 
-    void OutputSection(Section& sect, const IntNum& origin);
+    void OutputSection(Section& sect);
 
     // OutputBytecode overrides
     bool ConvertValueToBytes(Value& value,
@@ -118,17 +121,28 @@ public:
 
 private:
     Object& m_object;
-    llvm::raw_fd_ostream& m_fd_os;
     BytecodeNoOutput m_no_output;
 };
+
+class BinRenderer : public SectionRenderer
+{
+public:
+    BinRenderer(Object& object, Diagnostic& diags);
+    ~BinRenderer();
+
+protected:
+    void RenderSection(Section& sect,
+                       llvm::raw_ostream& os,
+                       Diagnostic& diags);
+
+private:
+    Object& m_object;
+};
 } // anonymous namespace
 
-BinOutput::BinOutput(llvm::raw_fd_ostream& os,
-                     Object& object,
-                     Diagnostic& diags)
+BinOutput::BinOutput(llvm::raw_ostream& os, Object& object, Diagnostic& diags)
     : BytecodeStreamOutput(os, diags),
       m_object(object),
-      m_fd_os(os),
       m_no_output(diags)
 {
 }
@@ -138,39 +152,12 @@ BinOutput::~BinOutput()
 }
 
 void
-BinOutput::OutputSection(Section& sect, const IntNum& origin)
+BinOutput::OutputSection(Section& sect)
 {
-    BytecodeOutput* outputter;
+    BytecodeOutput* outputter = this;
 
     if (sect.isBSS())
-    {
         outputter = &m_no_output;
-    }
-    else
-    {
-        IntNum file_start = sect.getLMA();
-        file_start -= origin;
-        if (file_start.getSign() < 0)
-        {
-            Diag(SourceLocation(), diag::err_section_before_origin)
-                << sect.getName();
-            return;
-        }
-        if (!file_start.isOkSize(sizeof(unsigned long)*8, 0, 0))
-        {
-            Diag(SourceLocation(), diag::err_start_too_large)
-                << sect.getName();
-            return;
-        }
-        m_fd_os.seek(file_start.getUInt());
-        if (m_os.has_error())
-        {
-            Diag(SourceLocation(), diag::err_file_output_seek);
-            return;
-        }
-
-        outputter = this;
-    }
 
     for (Section::bc_iterator i=sect.bytecodes_begin(),
          end=sect.bytecodes_end(); i != end; ++i)
@@ -179,6 +166,25 @@ BinOutput::OutputSection(Section& sect, const IntNum& origin)
     }
 }
 
+BinRenderer::BinRenderer(Object& object, Diagnostic& diags)
+    : SectionRenderer(object, diags),
+      m_object(object)
+{
+}
+
+BinRenderer::~BinRenderer()
+{
+}
+
+void
+BinRenderer::RenderSection(Section& sect,
+                           llvm::raw_ostream& os,
+                           Diagnostic& diags)
+{
+    BinOutput out(os, m_object, diags);
+    out.OutputSection(sect);
+}
+
 bool
 BinOutput::ConvertValueToBytes(Value& value,
                                Location loc,
@@ -297,13 +303,52 @@ BinObject::Output(llvm::raw_fd_ostream& os,
     if (!link.CheckLMAOverlap())
         return;
 
-    // Output sections
-    BinOutput out(os, m_object, diags);
-    for (Object::section_iterator i=m_object.sections_begin(),
+    // Determine file position of each section.
+    std::vector<unsigned long> file_starts;
+    file_starts.reserve(m_object.getNumSections());
+    for (Object::const_section_iterator i=m_object.sections_begin(),
          end=m_object.sections_end(); i != end; ++i)
     {
-        out.OutputSection(*i, origin);
+        IntNum file_start = i->getLMA();
+        file_start -= origin;
+        if (i->isBSS())
+            file_start = 0;
+        else if (file_start.getSign() < 0)
+        {
+            diags.Report(SourceLocation(), diag::err_section_before_origin)
+                << i->getName();
+        }
+        else if (!file_start.isOkSize(sizeof(unsigned long)*8, 0, 0))
+        {
+            diags.Report(SourceLocation(), diag::err_start_too_large)
+                << i->getName();
+        }
+        file_starts.push_back(file_start.getUInt());
+    }
+
+    if (diags.hasErrorOccurred())
+        return;
+
+    // Output sections
+    BinRenderer renderer(m_object, diags);
+    renderer.Start(m_object.getConfig().OutputThreads);
+    unsigned int sectnum = 0;
+    for (Object::const_section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i, ++sectnum)
+    {
+        // BSS sections are rendered for their diagnostics only.
+        if (!i->isBSS())
+        {
+            os.seek(file_starts[sectnum]);
+            if (os.has_error())
+            {
+                diags.Report(SourceLocation(), diag::err_file_output_seek);
+                return;
+            }
+        }
+        renderer.Output(sectnum, os);
     }
+    renderer.Finish();
 }
 
 Section*
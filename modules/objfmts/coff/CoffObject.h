@@ -124,6 +124,8 @@ private:
         F_AR32WR = 0x0100      ///< 32-bit little endian file
     };
 
+    enum { BIGOBJ_HEADER_SIZE = 56 };   ///< size of big object file header
+
     Machine m_machine;              // COFF machine to use
 
     CoffSymbol* m_file_coffsym;     // Data for .file symbol
@@ -43,6 +43,7 @@
 #include "yasmx/Object.h"
 #include "yasmx/Reloc.h"
 #include "yasmx/Section.h"
+#include "yasmx/SectionRenderer.h"
 #include "yasmx/StringTable.h"
 #include "yasmx/Symbol.h"
 #include "yasmx/Symbol_util.h"
@@ -63,10 +64,13 @@ public:
                CoffObject& objfmt,
                Object& object,
                bool all_syms,
+               bool bigobj,
                Diagnostic& diags);
     ~CoffOutput();
 
-    bool OutputSection(Section& sect);
+    void OutputSection(Section& sect);
+    unsigned long LayoutSection(Section& sect, unsigned long pos);
+    void OutputSectionRelocs(const Section& sect);
     void OutputSectionHeader(const Section& sect);
     unsigned long CountSymbols();
     void OutputSymbolTable();
@@ -82,21 +86,46 @@ private:
     CoffSection* m_coffsect;
     Object& m_object;
     bool m_all_syms;
+    bool m_bigobj;
     StringTable m_strtab;
     BytecodeNoOutput m_no_output;
 };
+
+class CoffRenderer : public SectionRenderer
+{
+public:
+    CoffRenderer(CoffObject& objfmt,
+                 Object& object,
+                 bool all_syms,
+                 bool bigobj,
+                 Diagnostic& diags);
+    ~CoffRenderer();
+
+protected:
+    void RenderSection(Section& sect,
+                       llvm::raw_ostream& os,
+                       Diagnostic& diags);
+
+private:
+    CoffObject& m_objfmt;
+    Object& m_object;
+    bool m_all_syms;
+    bool m_bigobj;
+};
 } // anonymous namespace
 
 CoffOutput::CoffOutput(llvm::raw_ostream& os,
                        CoffObject& objfmt,
                        Object& object,
                        bool all_syms,
+                       bool bigobj,
                        Diagnostic& diags)
     : BytecodeStreamOutput(os, diags)
     , m_objfmt(objfmt)
     , m_object(object)
     , m_all_syms(all_syms)
-    , m_strtab(4)   // first 4 bytes in string table are length
+    , m_bigobj(bigobj)
+    , m_strtab(4, true) // first 4 bytes in string table are length
     , m_no_output(diags)
 {
 }
@@ -330,7 +359,7 @@ CoffOutput::ConvertValueToBytes(Value& value,
     return true;
 }
 
-bool
+void
 CoffOutput::OutputSection(Section& sect)
 {
     BytecodeOutput* outputter = this;
@@ -339,34 +368,13 @@ CoffOutput::OutputSection(Section& sect)
     assert(coffsect != 0);
     m_coffsect = coffsect;
 
-    // Add to strtab if in win32 format and name > 8 chars
-    if (m_objfmt.isWin32())
-    {
-        size_t namelen = sect.getName().size();
-        if (namelen > 8)
-            coffsect->m_strtab_name = m_strtab.getIndex(sect.getName());
-    }
-
-    long pos;
     if (sect.isBSS())
     {
         // Don't output BSS sections.
         outputter = &m_no_output;
-        pos = 0;    // position = 0 because it's not in the file
     }
-    else
-    {
-        if (sect.bytecodes_back().getNextOffset() == 0)
-            return true;
-
-        pos = m_os.tell();
-        if (pos < 0)
-        {
-            Diag(SourceLocation(), diag::err_file_output_position);
-            return false;
-        }
-    }
-    sect.setFilePos(static_cast<unsigned long>(pos));
+    else if (sect.bytecodes_back().getNextOffset() == 0)
+        return;
     coffsect->m_size = 0;
 
     // Output bytecodes
@@ -377,43 +385,71 @@ CoffOutput::OutputSection(Section& sect)
             coffsect->m_size += i->getTotalLen();
     }
 
+    if (getDiagnostics().hasErrorOccurred())
+        return;
+
     // Sanity check final section size
     assert(coffsect->m_size == sect.bytecodes_back().getNextOffset());
+}
 
-    // No relocations to output?  Go on to next section
-    if (sect.getRelocs().size() == 0)
-        return true;
+unsigned long
+CoffOutput::LayoutSection(Section& sect, unsigned long pos)
+{
+    CoffSection* coffsect = sect.getAssocData<CoffSection>();
+    assert(coffsect != 0);
+
+    // Add to strtab if in win32 format and name > 8 chars
+    if (m_objfmt.isWin32())
+    {
+        size_t namelen = sect.getName().size();
+        if (namelen > 8)
+            coffsect->m_strtab_name = m_strtab.getIndex(sect.getName());
+    }
 
-    pos = m_os.tell();
-    if (pos < 0)
+    if (sect.isBSS())
+        sect.setFilePos(0);     // position = 0 because it's not in the file
+    else if (coffsect->m_size == 0)
+        return pos;
+    else
     {
-        Diag(SourceLocation(), diag::err_file_output_position);
-        return false;
+        sect.setFilePos(pos);
+        pos += coffsect->m_size;
     }
-    coffsect->m_relptr = static_cast<unsigned long>(pos);
 
-    // If >=64K relocs (for Win32/64), we set a flag in the section header
-    // (NRELOC_OVFL) and the first relocation contains the number of relocs.
-    if (sect.getRelocs().size() >= 64*1024)
+    // No relocations to output?  Go on to next section
+    if (sect.getRelocs().size() == 0)
+        return pos;
+
+    coffsect->m_relptr = pos;
+
+    // If >=64K-1 relocs (for Win32/64), we set a flag in the section header
+    // (NRELOC_OVFL) and the first relocation contains the number of relocs
+    // (including itself).
+    if (sect.getRelocs().size() >= 0xFFFF)
     {
-#if 0
         if (m_objfmt.isWin32())
         {
             coffsect->m_flags |= CoffSection::NRELOC_OVFL;
-            Bytes& bytes = getScratch();
-            bytes << little_endian;
-            Write32(bytes, sect.getRelocs().size()+1);  // address (# relocs)
-            Write32(bytes, 0);                          // relocated symbol
-            Write16(bytes, 0);                          // type of relocation
-            m_os << bytes;
+            pos += 10;
         }
         else
-#endif
         {
             Diag(SourceLocation(), diag::err_too_many_relocs)
                 << sect.getName();
         }
     }
+    return pos + 10*sect.getRelocs().size();
+}
+
+void
+CoffOutput::OutputSectionRelocs(const Section& sect)
+{
+    // Relocation count overflow marker (see LayoutSection()).
+    const CoffSection* coffsect = sect.getAssocData<CoffSection>();
+    assert(coffsect != 0);
+    Bytes& bytes = getScratch();
+    coffsect->WriteRelocOverflow(bytes, sect);
+    m_os << bytes;
 
     for (Section::const_reloc_iterator i=sect.relocs_begin(),
          end=sect.relocs_end(); i != end; ++i)
@@ -424,7 +460,6 @@ CoffOutput::OutputSection(Section& sect)
         assert(scratch.size() == 10);
         m_os << scratch;
     }
-    return true;
 }
 
 unsigned long
@@ -480,7 +515,7 @@ CoffOutput::OutputSymbolTable()
 
         Bytes& bytes = getScratch();
         assert(coffsym != 0);
-        coffsym->Write(bytes, *i, getDiagnostics(), m_strtab);
+        coffsym->Write(bytes, *i, getDiagnostics(), m_strtab, m_bigobj);
         m_os << bytes;
     }
 }
@@ -504,6 +539,32 @@ CoffOutput::OutputSectionHeader(const Section& sect)
     m_os << bytes;
 }
 
+CoffRenderer::CoffRenderer(CoffObject& objfmt,
+                           Object& object,
+                           bool all_syms,
+                           bool bigobj,
+                           Diagnostic& diags)
+    : SectionRenderer(object, diags)
+    , m_objfmt(objfmt)
+    , m_object(object)
+    , m_all_syms(all_syms)
+    , m_bigobj(bigobj)
+{
+}
+
+CoffRenderer::~CoffRenderer()
+{
+}
+
+void
+CoffRenderer::RenderSection(Section& sect,
+                            llvm::raw_ostream& os,
+                            Diagnostic& diags)
+{
+    CoffOutput out(os, m_objfmt, m_object, m_all_syms, m_bigobj, diags);
+    out.OutputSection(sect);
+}
+
 void
 CoffObject::Output(llvm::raw_fd_ostream& os,
                    bool all_syms,
@@ -543,72 +604,95 @@ CoffObject::Output(llvm::raw_fd_ostream& os,
         }
     }
 
-    // Allocate space for headers by seeking forward.
-    os.seek(20+40*(scnum-1));
-    if (os.has_error())
+    // The big object format (win32/win64 only) has a larger header and
+    // 32-bit section numbers; the standard format is limited to 16 bits
+    // (less reserved values).
+    bool bigobj = m_object.getConfig().BigObj && m_win32;
+    if (!bigobj && scnum-1 > 0xFEFF)
     {
-        diags.Report(SourceLocation(), diag::err_file_output_seek);
+        diags.Report(SourceLocation(), diag::err_coff_too_many_sections)
+            << (scnum-1) << 0xFEFF;
         return;
     }
 
-    CoffOutput out(os, *this, m_object, all_syms, diags);
+    CoffOutput out(os, *this, m_object, all_syms, bigobj, diags);
 
     // Finalize symbol table (assign index to each symbol).
     unsigned long symtab_count = out.CountSymbols();
 
-    // Section data/relocs
+    // Render section contents without keeping them.  Relocations are only
+    // known once the contents have been generated, and they determine the
+    // file layout.  The contents are rendered again, straight into the
+    // file, once the layout is done.
+    CoffRenderer renderer(*this, m_object, all_syms, bigobj, diags);
+    renderer.Prepare(m_object.getConfig().OutputThreads);
+
+    if (diags.hasErrorOccurred())
+        return;
+
+    // Lay out the file: section data/relocs follow the headers, then the
+    // symbol table, so the file can be written in a single sequential pass.
+    unsigned long pos = (bigobj ? BIGOBJ_HEADER_SIZE : 20)+40*(scnum-1);
     for (Object::section_iterator i=m_object.sections_begin(),
          end=m_object.sections_end(); i != end; ++i)
     {
-        if (!out.OutputSection(*i))
-            return;
-    }
-
-    // Symbol table
-    long pos = os.tell();
-    if (pos < 0)
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_position);
-        return;
+        pos = out.LayoutSection(*i, pos);
     }
-    unsigned long symtab_pos = static_cast<unsigned long>(pos);
-    out.OutputSymbolTable();
-
-    // String table
-    out.OutputStringTable();
+    unsigned long symtab_pos = pos;
 
-    // Write headers
-    os.seek(0);
-    if (os.has_error())
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_seek);
+    if (diags.hasErrorOccurred())
         return;
-    }
 
     // Write file header
     Bytes& bytes = out.getScratch();
     bytes.setLittleEndian();
-    Write16(bytes, m_machine);          // magic number
-    Write16(bytes, scnum-1);            // number of sects
     unsigned long ts;
     if (std::getenv("YASM_TEST_SUITE"))
         ts = 0;
     else
         ts = static_cast<unsigned long>(std::time(NULL));
-    Write32(bytes, ts);                 // time/date stamp
-    Write32(bytes, symtab_pos);         // file ptr to symtab
-    Write32(bytes, symtab_count);       // number of symtabs
-    Write16(bytes, 0);                  // size of optional header (none)
-
-    // flags
-    unsigned int flags = 0;
-    if (dbgfmt.getModule().getKeyword().equals_lower("null"))
-        flags |= F_LNNO;
-    if (!all_syms)
-        flags |= F_LSYMS;
-    if (m_machine != MACHINE_AMD64)
-        flags |= F_AR32WR;
-    Write16(bytes, flags);
+    if (bigobj)
+    {
+        // {D1BAA1C7-BAEE-4ba9-AF20-FAF66AA4DCB8}
+        static const unsigned char bigobj_classid[16] =
+        {
+            0xC7, 0xA1, 0xBA, 0xD1, 0xEE, 0xBA, 0xA9, 0x4B,
+            0xAF, 0x20, 0xFA, 0xF6, 0x6A, 0xA4, 0xDC, 0xB8
+        };
+        Write16(bytes, MACHINE_UNKNOWN);    // signature 1
+        Write16(bytes, 0xFFFF);             // signature 2
+        Write16(bytes, 2);                  // header version
+        Write16(bytes, m_machine);          // machine
+        Write32(bytes, ts);                 // time/date stamp
+        bytes.Write(bigobj_classid, 16);    // class id
+        Write32(bytes, 0);                  // size of data
+        Write32(bytes, 0);                  // flags
+        Write32(bytes, 0);                  // size of metadata
+        Write32(bytes, 0);                  // file ptr to metadata
+        Write32(bytes, scnum-1);            // number of sects
+        Write32(bytes, symtab_pos);         // file ptr to symtab
+        Write32(bytes, symtab_count);       // number of symtabs
+        assert(bytes.size() == BIGOBJ_HEADER_SIZE);
+    }
+    else
+    {
+        Write16(bytes, m_machine);          // magic number
+        Write16(bytes, scnum-1);            // number of sects
+        Write32(bytes, ts);                 // time/date stamp
+        Write32(bytes, symtab_pos);         // file ptr to symtab
+        Write32(bytes, symtab_count);       // number of symtabs
+        Write16(bytes, 0);                  // size of optional header (none)
+
+        // flags
+        unsigned int flags = 0;
+        if (dbgfmt.getModule().getKeyword().equals_lower("null"))
+            flags |= F_LNNO;
+        if (!all_syms)
+            flags |= F_LSYMS;
+        if (m_machine != MACHINE_AMD64)
+            flags |= F_AR32WR;
+        Write16(bytes, flags);
+    }
     os << bytes;
 
     // Section headers
@@ -617,4 +701,21 @@ CoffObject::Output(llvm::raw_fd_ostream& os,
     {
         out.OutputSectionHeader(*i);
     }
+
+    // Section data/relocs
+    renderer.Start(m_object.getConfig().OutputThreads);
+    unsigned int sectnum = 0;
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i, ++sectnum)
+    {
+        renderer.Output(sectnum, os);
+        out.OutputSectionRelocs(*i);
+    }
+    renderer.Finish();
+
+    // Symbol table
+    out.OutputSymbolTable();
+
+    // String table
+    out.OutputStringTable();
 }
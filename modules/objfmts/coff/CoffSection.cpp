@@ -130,12 +130,26 @@ CoffSection::Write(Bytes& bytes, const Section& sect) const
     // section name
     llvm::StringRef fullname = sect.getName();
     char name[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-    if (fullname.size() > 8)
+    if (fullname.size() > 8 && m_strtab_name <= 9999999)
     {
         llvm::SmallString<20> namenum;
         llvm::raw_svector_ostream os(namenum);
         os << '/' << m_strtab_name;
-        std::strncpy(name, os.str().data(), 8);
+        // at most 8 characters; namenum is not nul-terminated
+        llvm::StringRef namestr = os.str();
+        std::memcpy(name, namestr.data(), namestr.size());
+    }
+    else if (fullname.size() > 8)
+    {
+        // String table offsets too large for 7 decimal digits are written
+        // as "//" followed by 6 base-64 digits.
+        static const char base64[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        unsigned long offset = m_strtab_name;
+        name[0] = '/';
+        name[1] = '/';
+        for (int i=7; i>=2; --i, offset >>= 6)
+            name[i] = base64[offset & 0x3f];
     }
     else
         std::memcpy(name, fullname.data(), fullname.size());
@@ -154,10 +168,23 @@ CoffSection::Write(Bytes& bytes, const Section& sect) const
     Write32(bytes, sect.getFilePos());      // file ptr to data
     Write32(bytes, m_relptr);               // file ptr to relocs
     Write32(bytes, 0);                      // file ptr to line nums
-    if (sect.getRelocs().size() >= 64*1024)
-        Write16(bytes, 0xFFFF);             // max out
+    if (sect.getRelocs().size() >= 0xFFFF)
+        Write16(bytes, 0xFFFF);             // max out (see NRELOC_OVFL)
     else
         Write16(bytes, sect.getRelocs().size()); // num of relocation entries
     Write16(bytes, 0);                      // num of line number entries
     Write32(bytes, flags);                  // flags
 }
+
+void
+CoffSection::WriteRelocOverflow(Bytes& bytes, const Section& sect) const
+{
+    if ((m_flags & NRELOC_OVFL) == 0)
+        return;
+
+    // The address field holds the number of relocations, including this one.
+    bytes.setLittleEndian();
+    Write32(bytes, sect.getRelocs().size()+1);  // address (# relocs)
+    Write32(bytes, 0);                          // relocated symbol
+    Write16(bytes, 0);                          // type of relocation
+}
@@ -51,6 +51,10 @@ struct YASM_STD_EXPORT CoffSection : public AssocData
 #endif // WITH_XML
     void Write(Bytes& bytes, const Section& sect) const;
 
+    /// Write the relocation count entry that precedes the relocations of a
+    /// section with NRELOC_OVFL set.  Nothing is written otherwise.
+    void WriteRelocOverflow(Bytes& bytes, const Section& sect) const;
+
     static const unsigned long TEXT;
     static const unsigned long DATA;
     static const unsigned long BSS;
@@ -89,12 +89,13 @@ void
 CoffSymbol::Write(Bytes& bytes,
                   const Symbol& sym,
                   Diagnostic& diags,
-                  StringTable& strtab) const
+                  StringTable& strtab,
+                  bool bigobj) const
 {
     int vis = sym.getVisibility();
 
     IntNum value = 0;
-    unsigned int scnum = 0xfffe;    // -2 = debugging symbol
+    long scnum = -2;            // -2 = debugging symbol
     unsigned long scnlen = 0;   // for sect auxent
     unsigned long nreloc = 0;   // for sect auxent
 
@@ -133,7 +134,7 @@ CoffSymbol::Write(Bytes& bytes,
         // trivial case: simple integer
         if (equ_expr.isIntNum())
         {
-            scnum = 0xffff;     // -1 = absolute symbol
+            scnum = -1;         // -1 = absolute symbol
             value = equ_expr.getIntNum();
         }
         else
@@ -173,7 +174,7 @@ CoffSymbol::Write(Bytes& bytes,
             }
             else
             {
-                scnum = 0xffff;     // -1 = absolute symbol
+                scnum = -1;         // -1 = absolute symbol
                 value = 0;
             }
 
@@ -210,6 +211,10 @@ CoffSymbol::Write(Bytes& bytes,
 
     bytes.setLittleEndian();
 
+    // Big object format entries are 20 bytes rather than 18, due to the
+    // larger section number; aux entries are padded to match.
+    const unsigned int entsize = bigobj ? 20 : 18;
+
     std::string name;
     size_t len;
 
@@ -231,12 +236,20 @@ CoffSymbol::Write(Bytes& bytes,
         bytes.Write(8-len, 0);
     }
     Write32(bytes, value);          // value
-    Write16(bytes, scnum);          // section number
+    if (bigobj)
+        Write32(bytes, static_cast<unsigned long>(scnum) & 0xFFFFFFFFUL);
+    else
+        Write16(bytes, static_cast<unsigned long>(scnum) & 0xFFFF);
     Write16(bytes, m_type);         // type
     Write8(bytes, m_sclass);        // storage class
     Write8(bytes, m_aux.size());    // number of aux entries
 
-    assert(bytes.size() == 18);
+    assert(bytes.size() == entsize);
+
+    // The section aux entry relocation count saturates; the section header
+    // has the real count.
+    if (nreloc > 0xFFFF)
+        nreloc = 0xFFFF;
 
     for (std::vector<AuxEntry>::const_iterator i=m_aux.begin(), end=m_aux.end();
          i != end; ++i)
@@ -244,26 +257,26 @@ CoffSymbol::Write(Bytes& bytes,
         switch (m_auxtype)
         {
             case AUX_NONE:
-                bytes.Write(18, 0);
+                bytes.Write(entsize, 0);
                 break;
             case AUX_SECT:
                 Write32(bytes, scnlen);     // section length
                 Write16(bytes, nreloc);     // number relocs
-                bytes.Write(12, 0);         // number line nums, 0 fill
+                bytes.Write(entsize-6, 0);  // number line nums, 0 fill
                 break;
             case AUX_FILE:
                 len = i->fname.length();
-                if (len > 18)
+                if (len > entsize)
                 {
                     Write32(bytes, 0);
                     Write32(bytes, strtab.getIndex(i->fname));
-                    bytes.Write(18-8, 0);
+                    bytes.Write(entsize-8, 0);
                 }
                 else
                 {
                     bytes.Write(reinterpret_cast<const unsigned char*>
                                 (i->fname.data()), len);
-                    bytes.Write(18-len, 0);
+                    bytes.Write(entsize-len, 0);
                 }
                 break;
             default:
@@ -271,5 +284,5 @@ CoffSymbol::Write(Bytes& bytes,
         }
     }
 
-    assert(bytes.size() == 18+18*m_aux.size());
+    assert(bytes.size() == entsize*(1+m_aux.size()));
 }
@@ -98,10 +98,14 @@ struct YASM_STD_EXPORT CoffSymbol : public AssocData
 #ifdef WITH_XML
     pugi::xml_node Write(pugi::xml_node out) const;
 #endif // WITH_XML
+    /// Write symbol table entry (including aux entries).
+    /// @param bigobj   write big object format entries (20 bytes each,
+    ///                 32-bit section number) instead of standard ones
     void Write(Bytes& bytes,
                const Symbol& sym,
                Diagnostic& diags,
-               StringTable& strtab) const;
+               StringTable& strtab,
+               bool bigobj = false) const;
 
     bool m_forcevis;                ///< force visibility in symbol table
     unsigned long m_index;          ///< assigned COFF symbol table index
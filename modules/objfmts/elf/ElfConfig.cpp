@@ -88,7 +88,8 @@ unsigned long
 ElfConfig::WriteSymbolTable(llvm::raw_ostream& os,
                             Object& object,
                             Diagnostic& diags,
-                            Bytes& scratch) const
+                            Bytes& scratch,
+                            llvm::raw_ostream* shndx) const
 {
     unsigned long size = 0;
 
@@ -98,6 +99,12 @@ ElfConfig::WriteSymbolTable(llvm::raw_ostream& os,
     undef.Write(scratch, *this, diags);
     os << scratch;
     size += scratch.size();
+    if (shndx)
+    {
+        scratch.resize(0);
+        Write32(scratch, 0);
+        *shndx << scratch;
+    }
 
     // write other symbols
     for (Object::symbol_iterator sym=object.symbols_begin(),
@@ -111,6 +118,13 @@ ElfConfig::WriteSymbolTable(llvm::raw_ostream& os,
         elfsym->Write(scratch, *this, diags);
         os << scratch;
         size += scratch.size();
+
+        if (shndx)
+        {
+            scratch.resize(0);
+            Write32(scratch, elfsym->getExtendedIndex());
+            *shndx << scratch;
+        }
     }
     return size;
 }
@@ -118,6 +132,7 @@ ElfConfig::WriteSymbolTable(llvm::raw_ostream& os,
 bool
 ElfConfig::ReadSymbolTable(const llvm::MemoryBuffer&    in,
                            const ElfSection&            symtab_sect,
+                           const ElfSection*            shndx_sect,
                            ElfSymtab&                   symtab,
                            Object&                      object,
                            const StringTable&           strtab,
@@ -140,7 +155,8 @@ ElfConfig::ReadSymbolTable(const llvm::MemoryBuffer&    in,
     for (unsigned long pos=symsize; pos<size; pos += symsize, ++index)
     {
         std::auto_ptr<ElfSymbol> elfsym(
-            new ElfSymbol(*this, in, symtab_sect, index, sections, diags));
+            new ElfSymbol(*this, in, symtab_sect, shndx_sect, index, sections,
+                          diags));
         if (diags.hasErrorOccurred())
             return false;
 
@@ -219,8 +235,8 @@ ElfConfig::ReadProgramHeader(const llvm::MemoryBuffer& in)
     else if (cls == ELFCLASS64)
     {
         start = ReadU64(inbuf);
-        proghead_pos = ReadU64(inbuf).getUInt();
-        secthead_pos = ReadU64(inbuf).getUInt();
+        proghead_pos = ReadU64(inbuf).getUInt64();
+        secthead_pos = ReadU64(inbuf).getUInt64();
     }
 
     machine_flags = ReadU32(inbuf);
@@ -231,6 +247,39 @@ ElfConfig::ReadProgramHeader(const llvm::MemoryBuffer& in)
     secthead_count = ReadU16(inbuf);
     shstrtab_index = ReadU16(inbuf);
 
+    // With extended section numbering, the actual section count and
+    // section string table index are in the size and link fields of the
+    // first section header.
+    if ((secthead_count == 0 || shstrtab_index == SHN_XINDEX) &&
+        secthead_pos != 0)
+    {
+        inbuf.setPosition(secthead_pos);
+        unsigned long shdr_size = (cls == ELFCLASS32) ? SHDR32_SIZE
+                                                      : SHDR64_SIZE;
+        if (inbuf.getReadableSize() < shdr_size)
+            return false;
+
+        ReadU32(inbuf);                 // sh_name
+        ReadU32(inbuf);                 // sh_type
+        unsigned long size;
+        if (cls == ELFCLASS32)
+        {
+            inbuf.setPosition(inbuf.getPosition() + 12);  // flags/addr/off
+            size = ReadU32(inbuf);
+        }
+        else
+        {
+            inbuf.setPosition(inbuf.getPosition() + 24);  // flags/addr/off
+            size = ReadU64(inbuf).getUInt();
+        }
+        unsigned long link = ReadU32(inbuf);
+
+        if (secthead_count == 0)
+            secthead_count = size;
+        if (shstrtab_index == SHN_XINDEX)
+            shstrtab_index = link;
+    }
+
     return true;
 }
 
@@ -262,8 +311,8 @@ ElfConfig::WriteProgramHeader(llvm::raw_ostream& os, Bytes& scratch)
     if (cls == ELFCLASS32)
     {
         Write32(scratch, start);            // e_entry execution startaddr
-        Write32(scratch, proghead_pos);     // e_phoff program header off
-        Write32(scratch, secthead_pos);     // e_shoff section header off
+        Write32(scratch, static_cast<unsigned long>(proghead_pos)); // e_phoff
+        Write32(scratch, static_cast<unsigned long>(secthead_pos)); // e_shoff
         ehdr_size = EHDR32_SIZE;
         secthead_size = SHDR32_SIZE;
     }
@@ -281,14 +330,31 @@ ElfConfig::WriteProgramHeader(llvm::raw_ostream& os, Bytes& scratch)
     Write16(scratch, proghead_size);    // e_phentsize
     Write16(scratch, proghead_count);   // e_phnum
     Write16(scratch, secthead_size);    // e_shentsize
-    Write16(scratch, secthead_count);   // e_shnum
-    Write16(scratch, shstrtab_index);   // e_shstrndx
+    // With too many sections, the section count and section string table
+    // index escape to the first section header (see ElfObject::Output).
+    if (secthead_count >= SHN_LORESERVE)
+        Write16(scratch, 0);                // e_shnum
+    else
+        Write16(scratch, secthead_count);   // e_shnum
+    if (shstrtab_index >= SHN_LORESERVE)
+        Write16(scratch, SHN_XINDEX);       // e_shstrndx
+    else
+        Write16(scratch, shstrtab_index);   // e_shstrndx
 
     assert(scratch.size() == getProgramHeaderSize());
 
     os << scratch;
 }
 
+void
+ElfConfig::setExtendedNumbering(ElfSection& null_sect) const
+{
+    if (secthead_count >= SHN_LORESERVE)
+        null_sect.setSize(static_cast<unsigned long>(secthead_count));
+    if (shstrtab_index >= SHN_LORESERVE)
+        null_sect.setLink(shstrtab_index);
+}
+
 std::string
 ElfConfig::getRelocSectionName(const std::string& basesect) const
 {
@@ -63,11 +63,11 @@ struct YASM_STD_EXPORT ElfConfig : public DebugDumper<ElfConfig>
     bool            rela;           // relocations have explicit addends?
 
     // other program header fields; may not always be valid
-    unsigned long   proghead_pos;   // file offset of program header (0=none)
+    ElfOffset       proghead_pos;   // file offset of program header (0=none)
     unsigned int    proghead_count; // number of program header entries (0=none)
     unsigned int    proghead_size;  // program header entry size (0=none)
 
-    unsigned long   secthead_pos;   // file offset of section header (0=none)
+    ElfOffset       secthead_pos;   // file offset of section header (0=none)
     unsigned int    secthead_count; // number of section header entries (0=none)
     unsigned int    secthead_size;  // section header entry size (0=none)
 
@@ -81,15 +81,25 @@ struct YASM_STD_EXPORT ElfConfig : public DebugDumper<ElfConfig>
     bool ReadProgramHeader(const llvm::MemoryBuffer& in);
     void WriteProgramHeader(llvm::raw_ostream& os, Bytes& scratch);
 
+    /// Store the section count and the section string table index in the
+    /// null section header if they don't fit in the ELF header.
+    /// @param null_sect    null (first) section header
+    void setExtendedNumbering(ElfSection& null_sect) const;
+
     ElfSymbolIndex AssignSymbolIndices(Object& object, ElfSymbolIndex* nlocal)
         const;
 
+    /// Write the symbol table.
+    /// @param shndx    if not NULL, the extended section index table
+    ///                 (.symtab_shndx) is written here
     unsigned long WriteSymbolTable(llvm::raw_ostream& os,
                                    Object& object,
                                    Diagnostic& diags,
-                                   Bytes& scratch) const;
+                                   Bytes& scratch,
+                                   llvm::raw_ostream* shndx = 0) const;
     bool ReadSymbolTable(const llvm::MemoryBuffer&  in,
                          const ElfSection&          symtab_sect,
+                         const ElfSection*          shndx_sect,
                          ElfSymtab&                 symtab,
                          Object&                    object,
                          const StringTable&         strtab,
@@ -43,6 +43,7 @@
 #include "ElfObject.h"
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "yasmx/Basic/Diagnostic.h"
@@ -64,6 +65,7 @@
 #include "yasmx/Object.h"
 #include "yasmx/Object_util.h"
 #include "yasmx/Section.h"
+#include "yasmx/SectionRenderer.h"
 #include "yasmx/StringTable.h"
 #include "yasmx/Symbol_util.h"
 
@@ -73,6 +75,11 @@
 #include "ElfSymbol.h"
 #include "ElfTypes.h"
 
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define ELF_COMPRESS_DEBUG
+#endif
+
 
 using namespace yasm;
 using namespace yasm::objfmt;
@@ -268,6 +275,7 @@ ElfObject::Read(SourceManager& sm, Diagnostic& diags)
     // special sections
     ElfSection* strtab_sect = 0;
     ElfSection* symtab_sect = 0;
+    ElfSection* shndx_sect = 0;
 
     // read section headers
     for (unsigned int i=0; i<m_config.secthead_count; ++i)
@@ -294,16 +302,20 @@ ElfObject::Read(SourceManager& sm, Diagnostic& diags)
             secttype == SHT_SYMTAB ||
             secttype == SHT_STRTAB ||
             secttype == SHT_RELA ||
-            secttype == SHT_REL)
+            secttype == SHT_REL ||
+            secttype == SHT_SYMTAB_SHNDX)
         {
+            ElfSection* misc_sect = elfsect.get();
             misc_sections.push_back(elfsect.release());
             sections[i] = 0;
 
             // try to pick these up by section type if not set
             if (secttype == SHT_SYMTAB && symtab_sect == 0)
-                symtab_sect = elfsect.get();
+                symtab_sect = misc_sect;
             else if (secttype == SHT_STRTAB && strtab_sect == 0)
-                strtab_sect = elfsect.get();
+                strtab_sect = misc_sect;
+            else if (secttype == SHT_SYMTAB_SHNDX)
+                shndx_sect = misc_sect;
 
             // if any section is RELA, set config to RELA
             if (secttype == SHT_RELA)
@@ -347,9 +359,15 @@ ElfObject::Read(SourceManager& sm, Diagnostic& diags)
         if (!LoadStringTable(&strtab, in, *strtab_sect, diags))
             return false;
 
+        // extended section index table must be linked to the symbol table
+        if (shndx_sect != 0 &&
+            (shndx_sect->getLink() >= m_config.secthead_count ||
+             elfsects[shndx_sect->getLink()] != symtab_sect))
+            shndx_sect = 0;
+
         // load symbol table
-        if (!m_config.ReadSymbolTable(in, *symtab_sect, symtab, m_object,
-                                      strtab, &sections[0], diags))
+        if (!m_config.ReadSymbolTable(in, *symtab_sect, shndx_sect, symtab,
+                                      m_object, strtab, &sections[0], diags))
             return false;
     }
 
@@ -736,14 +754,14 @@ namespace {
 class ElfOutput : public BytecodeStreamOutput
 {
 public:
-    ElfOutput(llvm::raw_fd_ostream& os,
+    ElfOutput(llvm::raw_ostream& os,
               ElfObject& objfmt,
               Object& object,
+              SymbolRef GOT_sym,
               Diagnostic& diags);
     ~ElfOutput();
 
-    void OutputGroup(ElfGroup& group);
-    void OutputSection(Section& sect, StringTable& shstrtab);
+    void OutputSection(Section& sect);
 
     // OutputBytecode overrides
     bool ConvertValueToBytes(Value& value,
@@ -756,22 +774,76 @@ public:
 private:
     ElfObject& m_objfmt;
     Object& m_object;
-    llvm::raw_fd_ostream& m_fd_os;
     BytecodeNoOutput m_no_output;
     SymbolRef m_GOT_sym;
 };
+
+class ElfRenderer : public SectionRenderer
+{
+public:
+    ElfRenderer(ElfObject& objfmt,
+                Object& object,
+                bool compress_debug,
+                Diagnostic& diags);
+    ~ElfRenderer();
+
+protected:
+    void RenderSection(Section& sect,
+                       llvm::raw_ostream& os,
+                       Diagnostic& diags);
+
+private:
+#ifdef ELF_COMPRESS_DEBUG
+    void CompressSection(Section& sect,
+                         ElfSection& elfsect,
+                         Diagnostic& diags);
+#endif
+
+    ElfObject& m_objfmt;
+    Object& m_object;
+    SymbolRef m_GOT_sym;
+    bool m_compress_debug;
+};
+
+#ifdef ELF_COMPRESS_DEBUG
+/// Output stream that compresses everything written to it with zlib,
+/// appending the compressed data to a string.
+class ZlibOutputStream : public llvm::raw_ostream
+{
+public:
+    ZlibOutputStream(std::string& out);
+    ~ZlibOutputStream();
+
+    /// Finish the compressed data.
+    /// @return False if compression failed.
+    bool Finish();
+
+private:
+    void write_impl(const char* ptr, size_t size);
+    uint64_t current_pos() const;
+
+    /// Compress data, flushing as given.
+    void Deflate(const char* ptr, uInt size, int flush);
+
+    std::string& m_out;
+    z_stream m_zstream;
+    uint64_t m_pos;         ///< Number of bytes written (uncompressed)
+    bool m_ok;
+    bool m_finished;
+};
+#endif
 } // anonymous namespace
 
-ElfOutput::ElfOutput(llvm::raw_fd_ostream& os,
+ElfOutput::ElfOutput(llvm::raw_ostream& os,
                      ElfObject& objfmt,
                      Object& object,
+                     SymbolRef GOT_sym,
                      Diagnostic& diags)
     : BytecodeStreamOutput(os, diags)
     , m_objfmt(objfmt)
     , m_object(object)
-    , m_fd_os(os)
     , m_no_output(diags)
-    , m_GOT_sym(object.FindSymbol("_GLOBAL_OFFSET_TABLE_"))
+    , m_GOT_sym(GOT_sym)
 {
 }
 
@@ -898,132 +970,273 @@ ElfOutput::ConvertValueToBytes(Value& value,
 }
 
 void
-ElfOutput::OutputGroup(ElfGroup& group)
+ElfOutput::OutputSection(Section& sect)
 {
-    uint64_t pos = m_os.tell();
-    if (m_os.has_error())
+    BytecodeOutput* outputter = this;
+
+    ElfSection* elfsect = sect.getAssocData<ElfSection>();
+    assert(elfsect != 0);
+    elfsect->setSize(0);
+
+    // Don't output BSS sections.
+    if (sect.isBSS())
+        outputter = &m_no_output;
+
+    // Output bytecodes
+    for (Section::bc_iterator i=sect.bytecodes_begin(),
+         end=sect.bytecodes_end(); i != end; ++i)
     {
-        Diag(SourceLocation(), diag::err_file_output_position);
-        return;
+        if (i->Output(*outputter))
+            elfsect->AddSize(i->getTotalLen());
     }
 
-    m_fd_os.seek(group.elfsect->setFileOffset(pos));
-    if (m_os.has_error())
-    {
-        Diag(SourceLocation(), diag::err_file_output_seek);
+    if (getDiagnostics().hasErrorOccurred())
         return;
-    }
 
-    Bytes& scratch = getScratch();
-    m_objfmt.m_config.setEndian(scratch);
+    // Sanity check final section size
+    assert(elfsect->getSize() == sect.bytecodes_back().getNextOffset());
+}
 
-    // sort and uniquify sections before output
-    std::sort(group.sects.begin(), group.sects.end());
-    std::vector<Section*>::iterator it =
-        std::unique(group.sects.begin(), group.sects.end());
-    group.sects.resize(it - group.sects.begin());
+ElfRenderer::ElfRenderer(ElfObject& objfmt,
+                         Object& object,
+                         bool compress_debug,
+                         Diagnostic& diags)
+    : SectionRenderer(object, diags)
+    , m_objfmt(objfmt)
+    , m_object(object)
+    , m_GOT_sym(object.FindSymbol("_GLOBAL_OFFSET_TABLE_"))
+    , m_compress_debug(compress_debug)
+{
+}
 
-    Write32(scratch, group.flags);
-    for (std::vector<Section*>::const_iterator i=group.sects.begin(),
-         end=group.sects.end(); i != end; ++i)
+ElfRenderer::~ElfRenderer()
+{
+}
+
+#ifdef ELF_COMPRESS_DEBUG
+ZlibOutputStream::ZlibOutputStream(std::string& out)
+    : m_out(out)
+    , m_pos(0)
+    , m_finished(false)
+{
+    m_zstream.zalloc = Z_NULL;
+    m_zstream.zfree = Z_NULL;
+    m_zstream.opaque = Z_NULL;
+    m_ok = deflateInit(&m_zstream, Z_DEFAULT_COMPRESSION) == Z_OK;
+}
+
+ZlibOutputStream::~ZlibOutputStream()
+{
+    if (!m_finished)
+        flush();
+    if (m_ok)
+        deflateEnd(&m_zstream);
+}
+
+void
+ZlibOutputStream::write_impl(const char* ptr, size_t size)
+{
+    m_pos += size;
+    // zlib lengths are (at least) 32 bits.
+    while (size > 0x40000000)
     {
-        ElfSection* elfsect = (*i)->getAssocData<ElfSection>();
-        assert(elfsect != 0);
-        Write32(scratch, elfsect->getIndex());
+        Deflate(ptr, 0x40000000, Z_NO_FLUSH);
+        ptr += 0x40000000;
+        size -= 0x40000000;
     }
+    Deflate(ptr, static_cast<uInt>(size), Z_NO_FLUSH);
+}
 
-    group.elfsect->setSize(scratch.size());
-    OutputBytes(scratch, SourceLocation());
+uint64_t
+ZlibOutputStream::current_pos() const
+{
+    return m_pos;
 }
 
 void
-ElfOutput::OutputSection(Section& sect, StringTable& shstrtab)
+ZlibOutputStream::Deflate(const char* ptr, uInt size, int flush)
 {
-    BytecodeOutput* outputter = this;
+    static const uInt CHUNK = 64*1024;
 
-    ElfSection* elfsect = sect.getAssocData<ElfSection>();
-    assert(elfsect != 0);
+    if (!m_ok)
+        return;
+    m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(ptr));
+    m_zstream.avail_in = size;
+    for (;;)
+    {
+        std::string::size_type len = m_out.size();
+        m_out.resize(len + CHUNK);
+        m_zstream.next_out = reinterpret_cast<Bytef*>(&m_out[len]);
+        m_zstream.avail_out = CHUNK;
+        int ret = deflate(&m_zstream, flush);
+        m_out.resize(len + CHUNK - m_zstream.avail_out);
+
+        if (ret == Z_STREAM_END)
+            return;
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            m_ok = false;
+            return;
+        }
+        // All input consumed and all output produced?
+        if (flush == Z_NO_FLUSH && m_zstream.avail_in == 0 &&
+            m_zstream.avail_out != 0)
+            return;
+    }
+}
 
-    if (elfsect->getAlign() == 0)
-        elfsect->setAlign(sect.getAlign());
+bool
+ZlibOutputStream::Finish()
+{
+    flush();
+    Deflate(0, 0, Z_FINISH);
+    m_finished = true;
+    return m_ok;
+}
 
-    elfsect->setName(shstrtab.getIndex(sect.getName()));
+// Render a section into the compression header (Elf32_Chdr/Elf64_Chdr)
+// followed by the zlib-compressed contents, keeping only the compressed
+// form until the section is written, and mark the section SHF_COMPRESSED.
+// Sections that don't get smaller are left to be written uncompressed.
+// Relocations still apply to the uncompressed contents, so they are
+// unaffected.
+void
+ElfRenderer::CompressSection(Section& sect,
+                             ElfSection& elfsect,
+                             Diagnostic& diags)
+{
+    // Start over if the section was rendered before.
+    if (elfsect.getFlags() & SHF_COMPRESSED)
+    {
+        elfsect.setTypeFlags(elfsect.getType(),
+                             elfsect.getFlags() & ~SHF_COMPRESSED);
+        elfsect.setAlign(0);
+    }
+    std::string& zdata = elfsect.getCompressedData();
+    zdata.clear();
 
-    uint64_t pos;
-    if (sect.isBSS())
+    const ElfConfig& config = m_objfmt.m_config;
+    uint64_t size = sect.bytecodes_back().getNextOffset();
+    Bytes chdr;
+    config.setEndian(chdr);
+    Write32(chdr, ELFCOMPRESS_ZLIB);
+    unsigned long chdr_align;
+    if (config.cls == ELFCLASS32)
     {
-        // Don't output BSS sections.
-        outputter = &m_no_output;
-        pos = 0;    // position = 0 because it's not in the file
+        Write32(chdr, static_cast<unsigned long>(size));
+        Write32(chdr, sect.getAlign() != 0 ? sect.getAlign() : 1);
+        chdr_align = 4;
     }
     else
     {
-        pos = m_os.tell();
-        if (m_os.has_error())
+        Write32(chdr, 0);               // ch_reserved
+        Write64(chdr, size);
+        Write64(chdr, sect.getAlign() != 0 ? sect.getAlign() : 1);
+        chdr_align = 8;
+    }
+    zdata.append(reinterpret_cast<const char*>(&chdr[0]), chdr.size());
+
+    bool ok;
+    {
+        ZlibOutputStream zos(zdata);
+        ElfOutput out(zos, m_objfmt, m_object, m_GOT_sym, diags);
+        out.OutputSection(sect);
+        ok = zos.Finish();
+    }
+
+    if (!ok || zdata.size() >= size)
+    {
+        std::string().swap(zdata);
+        return;
+    }
+
+    elfsect.setTypeFlags(elfsect.getType(),
+                         elfsect.getFlags() | SHF_COMPRESSED);
+    elfsect.setSize(zdata.size());
+    elfsect.setAlign(chdr_align);
+}
+#endif
+
+void
+ElfRenderer::RenderSection(Section& sect,
+                           llvm::raw_ostream& os,
+                           Diagnostic& diags)
+{
+#ifdef ELF_COMPRESS_DEBUG
+    // Debugging sections are compressed while preparing, so the
+    // compression runs on the same worker thread as the rendering, and
+    // the compressed size is known for the file layout.
+    if (m_compress_debug && !sect.isBSS() &&
+        sect.getName().startswith(".debug_"))
+    {
+        ElfSection* elfsect = sect.getAssocData<ElfSection>();
+        if (isPreparing())
         {
-            Diag(SourceLocation(), diag::err_file_output_position);
+            CompressSection(sect, *elfsect, diags);
             return;
         }
-
-        m_fd_os.seek(elfsect->setFileOffset(pos));
-        if (m_os.has_error())
+        if (elfsect->getFlags() & SHF_COMPRESSED)
         {
-            Diag(SourceLocation(), diag::err_file_output_seek);
+            // Render only to regenerate the relocations.
+            llvm::raw_null_ostream null_os;
+            null_os.SetUnbuffered();
+            ElfOutput out(null_os, m_objfmt, m_object, m_GOT_sym, diags);
+            out.OutputSection(sect);
+
+            const std::string& zdata = elfsect->getCompressedData();
+            elfsect->setSize(zdata.size());
+            os << zdata;
             return;
         }
     }
+#endif
+    ElfOutput out(os, m_objfmt, m_object, m_GOT_sym, diags);
+    out.OutputSection(sect);
+}
 
-    // Output bytecodes
-    for (Section::bc_iterator i=sect.bytecodes_begin(),
-         end=sect.bytecodes_end(); i != end; ++i)
-    {
-        if (i->Output(*outputter))
-            elfsect->AddSize(i->getTotalLen());
-    }
-
-    if (getDiagnostics().hasErrorOccurred())
-        return;
-
-    // Sanity check final section size
-    assert(elfsect->getSize() == sect.bytecodes_back().getNextOffset());
+static void
+ElfBuildGroup(ElfGroup& group, const ElfConfig& config, Bytes& bytes)
+{
+    config.setEndian(bytes);
 
-    // Empty?  Go on to next section
-    if (elfsect->isEmpty())
-        return;
+    // sort and uniquify sections before output
+    std::sort(group.sects.begin(), group.sects.end());
+    std::vector<Section*>::iterator it =
+        std::unique(group.sects.begin(), group.sects.end());
+    group.sects.resize(it - group.sects.begin());
 
-    // No relocations?  Go on to next section
-    if (sect.getRelocs().size() == 0)
-        return;
+    Write32(bytes, group.flags);
+    for (std::vector<Section*>::const_iterator i=group.sects.begin(),
+         end=group.sects.end(); i != end; ++i)
+    {
+        ElfSection* elfsect = (*i)->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+        Write32(bytes, elfsect->getIndex());
+    }
 
-    // name the relocation section .rel[a].foo
-    std::string relname = m_objfmt.m_config.getRelocSectionName(sect.getName());
-    elfsect->setRelName(shstrtab.getIndex(relname));
+    group.elfsect->setSize(bytes.size());
 }
 
-static unsigned long
-ElfAlignOutput(llvm::raw_fd_ostream& os, unsigned int align, Diagnostic& diags)
+static inline ElfOffset
+ElfAlignPos(ElfOffset pos, unsigned int align)
 {
     assert(isExp2(align) && "requested alignment not a power of two");
+    return (pos + align - 1) & ~static_cast<ElfOffset>(align - 1);
+}
 
-    uint64_t pos = os.tell();
-    if (os.has_error())
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_position);
-        return 0;
-    }
-
-    unsigned long delta = align - (pos & (align-1));
-    if (delta != align)
+// Zero-fill the output from pos up to the file offset of the next item.
+static void
+ElfPadOutput(llvm::raw_ostream& os, ElfOffset* pos, ElfOffset offset)
+{
+    static const char zeros[16] = {0};
+    assert(offset >= *pos && "file layout out of order");
+    while (*pos < offset)
     {
-        pos += delta;
-        os.seek(pos);
-        if (os.has_error())
-        {
-            diags.Report(SourceLocation(), diag::err_file_output_seek);
-            return 0;
-        }
+        ElfOffset n = std::min(offset - *pos,
+                               static_cast<ElfOffset>(sizeof(zeros)));
+        os.write(zeros, static_cast<size_t>(n));
+        *pos += n;
     }
-    return static_cast<unsigned long>(pos);
 }
 
 void
@@ -1032,7 +1245,10 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
                   DebugFormat& dbgfmt,
                   Diagnostic& diags)
 {
-    StringTable shstrtab, strtab;
+    // Symbol names are given provisional indexes in names_strtab while the
+    // symbol table is being determined; the final (merged) layout is done
+    // once all named symbols are known.
+    StringTable shstrtab(0, true), strtab(0, true), names_strtab;
     unsigned int align = (m_config.cls == ELFCLASS32) ? 4 : 8;
 
     // XXX: ugly workaround to prevent all_syms from kicking in
@@ -1042,7 +1258,8 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     // Add filename to strtab and set as .file symbol name
     if (m_file_elfsym)
     {
-        m_file_elfsym->setName(strtab.getIndex(m_object.getSourceFilename()));
+        m_file_elfsym->setName(
+            names_strtab.getIndex(m_object.getSourceFilename()));
     }
 
     // Create .note.GNU-stack if we need to advise linker about executable
@@ -1069,14 +1286,6 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         }
     }
 
-    // Allocate space for Ehdr by seeking forward
-    os.seek(m_config.getProgramHeaderSize());
-    if (os.has_error())
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_seek);
-        return;
-    }
-
     // Generate version symbols.
     for (SymVers::const_iterator i=m_symvers.begin(), end=m_symvers.end();
          i != end; ++i)
@@ -1140,10 +1349,10 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     ElfSection null_sect(m_config, SHT_NULL, 0);
     null_sect.setIndex(m_config.secthead_count++);
 
-    ElfOutput out(os, *this, m_object, diags);
-
-    // Group sections.
-    ElfStringIndex groupname_index = 0;
+    // Group sections.  Groups named after an existing symbol are named
+    // ".group"; the others get a section symbol of the group's name.
+    std::vector<llvm::StringRef> groupnames;
+    groupnames.reserve(m_groups.size());
     for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end; ++i)
     {
         ElfGroup& group = *i;
@@ -1153,9 +1362,7 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         ElfSymbol* elfsym = 0;
         if (i->sym)
         {
-            if (groupname_index == 0)
-                groupname_index = shstrtab.getIndex(".group");
-            group.elfsect->setName(groupname_index);
+            groupnames.push_back(".group");
             elfsym = i->sym->getAssocData<ElfSymbol>();
             if (!elfsym)
                 elfsym = &BuildSymbol(*i->sym);
@@ -1163,10 +1370,10 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         else
         {
             i->sym = m_object.getSymbol(i->name);
-            group.elfsect->setName(shstrtab.getIndex(i->name));
+            groupnames.push_back(i->name);
             elfsym = &BuildSymbol(*i->sym);
             elfsym->setType(STT_SECTION);
-            elfsym->setSectionIndex(m_config.secthead_count);
+            elfsym->setElfSection(group.elfsect.get());
         }
 
         group.elfsect->setIndex(m_config.secthead_count++);
@@ -1180,7 +1387,7 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     for (Object::symbol_iterator i=m_object.symbols_begin(),
          end=m_object.symbols_end(); i != end; ++i)
     {
-        FinalizeSymbol(*i, strtab, all_syms, diags);
+        FinalizeSymbol(*i, names_strtab, all_syms, diags);
     }
 
     // Number user sections (numbering required for group sections).
@@ -1192,18 +1399,84 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         elfsect->setIndex(m_config.secthead_count++);
     }
 
-    // Output group sections.
-    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end; ++i)
+    // Every section has a section symbol, so if any section index doesn't
+    // fit in a symbol table entry, an extended section index table
+    // (.symtab_shndx) is needed.
+    bool need_shndx = m_config.secthead_count > SHN_LORESERVE;
+
+    // Build group section contents.
+    std::vector<Bytes> group_data(m_groups.size());
+    std::vector<Bytes>::iterator gdata = group_data.begin();
+    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end;
+         ++i, ++gdata)
     {
-        out.OutputGroup(*i);
+        ElfBuildGroup(*i, m_config, *gdata);
     }
 
-    // Output user sections.
-    // Assign indices and names as we go (including relocation section names).
+    // Render user sections without keeping their contents.  Relocations
+    // (and thus the relocation section names and referenced symbols) and
+    // final section sizes are only known once the contents have been
+    // generated, and they determine the file layout.  The contents are
+    // rendered again, straight into the file, once the layout is done.
+#ifndef ELF_COMPRESS_DEBUG
+    if (oconfig.CompressDebug)
+        diags.Report(SourceLocation(), diag::warn_elf_no_compress);
+#endif
+    ElfRenderer renderer(*this, m_object, oconfig.CompressDebug, diags);
+    renderer.Prepare(oconfig.OutputThreads);
+
+    if (diags.hasErrorOccurred())
+        return;
+
+    // Lay out the section header string table.  All section names
+    // (including relocation section names, named .rel[a].foo) are known now,
+    // so add them all before assigning any so tails can be merged.
+    std::vector<std::string> relnames;
+    relnames.reserve(m_object.getNumSections());
     for (Object::section_iterator i=m_object.sections_begin(),
          end=m_object.sections_end(); i != end; ++i)
     {
-        out.OutputSection(*i, shstrtab);
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+
+        shstrtab.Add(i->getName());
+        if (!elfsect->isEmpty() && i->getRelocs().size() != 0)
+        {
+            relnames.push_back(m_config.getRelocSectionName(i->getName()));
+            shstrtab.Add(relnames.back());
+        }
+        else
+            relnames.push_back(std::string());
+    }
+    for (std::vector<llvm::StringRef>::const_iterator
+         i=groupnames.begin(), end=groupnames.end(); i != end; ++i)
+        shstrtab.Add(*i);
+    shstrtab.Add(".shstrtab");
+    shstrtab.Add(".strtab");
+    shstrtab.Add(".symtab");
+    if (need_shndx)
+        shstrtab.Add(".symtab_shndx");
+    shstrtab.Finalize();
+
+    // Assign section names.
+    std::vector<llvm::StringRef>::const_iterator groupname =
+        groupnames.begin();
+    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end;
+         ++i, ++groupname)
+        i->elfsect->setName(shstrtab.getIndex(*groupname));
+
+    std::vector<std::string>::const_iterator relname = relnames.begin();
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i, ++relname)
+    {
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+
+        if (elfsect->getAlign() == 0)
+            elfsect->setAlign(i->getAlign());
+
+        elfsect->setName(shstrtab.getIndex(i->getName()));
+        if (!relname->empty())
+            elfsect->setRelName(shstrtab.getIndex(*relname));
     }
 
     // Go through relocations and force referenced symbols into symbol table,
@@ -1218,7 +1491,7 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
             if (!all_syms || !sym->getAssocData<ElfSymbol>())
             {
                 ElfSymbol& elfsym = BuildSymbol(*sym);
-                elfsym.setName(strtab.getIndex(sym->getName()));
+                elfsym.setName(names_strtab.getIndex(sym->getName()));
                 setSymbolSectionValue(*sym, elfsym);
                 elfsym.setInTable(true);
                 elfsym.Finalize(*sym, diags);
@@ -1250,47 +1523,107 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     // Sort the symbols by symbol index.
     stdx::sort(m_object.symbols_begin(), m_object.symbols_end(), byIndex);
 
-    unsigned long offset, size;
+    // Lay out the symbol string table now that the named symbols are known,
+    // and give those symbols their final name indexes.
+    for (Object::symbol_iterator i=m_object.symbols_begin(),
+         end=m_object.symbols_end(); i != end; ++i)
+    {
+        ElfSymbol* elfsym = i->getAssocData<ElfSymbol>();
+        if (elfsym && elfsym->hasName())
+            strtab.Add(names_strtab.getString(elfsym->getName()));
+    }
+    strtab.Finalize();
+    for (Object::symbol_iterator i=m_object.symbols_begin(),
+         end=m_object.symbols_end(); i != end; ++i)
+    {
+        ElfSymbol* elfsym = i->getAssocData<ElfSymbol>();
+        if (elfsym && elfsym->hasName())
+            elfsym->setName(
+                strtab.getIndex(names_strtab.getString(elfsym->getName())));
+    }
+
     ElfStringIndex shstrtab_name = shstrtab.getIndex(".shstrtab");
     ElfStringIndex strtab_name = shstrtab.getIndex(".strtab");
     ElfStringIndex symtab_name = shstrtab.getIndex(".symtab");
 
-    // section header string table (.shstrtab)
-    offset = ElfAlignOutput(os, align, diags);
-    size = shstrtab.getSize();
-    shstrtab.Write(os);
+    // Render the symbol table (and extended section index table).
+    Bytes scratch;
+    std::string symtab_data, shndx_data;
+    {
+        llvm::raw_string_ostream sos(symtab_data);
+        llvm::raw_string_ostream shndx_os(shndx_data);
+        m_config.WriteSymbolTable(sos, m_object, diags, scratch,
+                                  need_shndx ? &shndx_os : 0);
+    }
 
+    // Lay out the file: everything after the ELF header is placed in the
+    // order it is written, so the file can be written in a single
+    // sequential pass (without seeking) once the layout is known.
+    ElfOffset pos = m_config.getProgramHeaderSize();
+
+    // group sections
+    gdata = group_data.begin();
+    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end;
+         ++i, ++gdata)
+    {
+        pos = i->elfsect->setFileOffset(pos) + gdata->size();
+    }
+
+    // user sections
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i)
+    {
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+        if (i->isBSS())
+            elfsect->setFileOffset(0);  // not in the file
+        else
+            pos = elfsect->setFileOffset(pos) +
+                elfsect->getSize().getUInt64();
+    }
+
+    // section header string table (.shstrtab)
     ElfSection shstrtab_sect(m_config, SHT_STRTAB, 0);
     m_config.shstrtab_index = m_config.secthead_count;
     shstrtab_sect.setName(shstrtab_name);
     shstrtab_sect.setIndex(m_config.secthead_count++);
-    shstrtab_sect.setFileOffset(offset);
-    shstrtab_sect.setSize(size);
+    pos = shstrtab_sect.setFileOffset(ElfAlignPos(pos, align));
+    shstrtab_sect.setSize(shstrtab.getSize());
+    pos += shstrtab.getSize();
 
     // string table (.strtab)
-    offset = ElfAlignOutput(os, align, diags);
-    size = strtab.getSize();
-    strtab.Write(os);
-
     ElfSection strtab_sect(m_config, SHT_STRTAB, 0);
     strtab_sect.setName(strtab_name);
     strtab_sect.setIndex(m_config.secthead_count++);
-    strtab_sect.setFileOffset(offset);
-    strtab_sect.setSize(size);
+    pos = strtab_sect.setFileOffset(ElfAlignPos(pos, align));
+    strtab_sect.setSize(strtab.getSize());
+    pos += strtab.getSize();
 
     // symbol table (.symtab)
-    offset = ElfAlignOutput(os, align, diags);
-    size = m_config.WriteSymbolTable(os, m_object, diags, out.getScratch());
-
     ElfSection symtab_sect(m_config, SHT_SYMTAB, 0, true);
     symtab_sect.setName(symtab_name);
     symtab_sect.setIndex(m_config.secthead_count++);
-    symtab_sect.setFileOffset(offset);
-    symtab_sect.setSize(size);
+    pos = symtab_sect.setFileOffset(ElfAlignPos(pos, align));
+    symtab_sect.setSize(symtab_data.size());
     symtab_sect.setInfo(symtab_nlocal);
     symtab_sect.setLink(strtab_sect.getIndex());    // link to .strtab
+    pos += symtab_data.size();
 
-    // output relocations
+    // extended section index table (.symtab_shndx)
+    ElfSection shndx_sect(m_config, SHT_SYMTAB_SHNDX, 0);
+    if (need_shndx)
+    {
+        shndx_sect.setName(shstrtab.getIndex(".symtab_shndx"));
+        shndx_sect.setIndex(m_config.secthead_count++);
+        shndx_sect.setEntSize(4);
+        shndx_sect.setAlign(4);
+        pos = shndx_sect.setFileOffset(ElfAlignPos(pos, 4));
+        shndx_sect.setSize(shndx_data.size());
+        shndx_sect.setLink(symtab_sect.getIndex());  // link to .symtab
+        pos += shndx_data.size();
+    }
+
+    // relocations
     for (Object::section_iterator i=m_object.sections_begin(),
          end=m_object.sections_end(); i != end; ++i)
     {
@@ -1303,11 +1636,17 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
 
         // need relocation section; set it up
         elfsect->setRelIndex(m_config.secthead_count++);
-        elfsect->WriteRelocs(os, *i, out.getScratch(), *m_machine, diags);
+        pos = ElfAlignPos(pos, 4);
+        elfsect->setRelFileOffset(pos);
+        pos += elfsect->getRelocsSize(*i);
     }
 
-    // output section header table
-    m_config.secthead_pos = ElfAlignOutput(os, 16, diags);
+    // section header table
+    m_config.secthead_pos = ElfAlignPos(pos, 16);
+
+    // If the section count or the section string table index don't fit in
+    // the ELF header, they are stored in the null section header instead.
+    m_config.setExtendedNumbering(null_sect);
 
 #if 0
     // stabs debugging support
@@ -1325,8 +1664,71 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     }
 #endif
 
+    // Write the file in layout order.
+    m_config.WriteProgramHeader(os, scratch);
+    pos = m_config.getProgramHeaderSize();
+
+    // group sections
+    gdata = group_data.begin();
+    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end;
+         ++i, ++gdata)
+    {
+        ElfPadOutput(os, &pos, i->elfsect->getFileOffset());
+        os << *gdata;
+        pos += gdata->size();
+    }
+    group_data.clear();
+
+    // user sections
+    renderer.Start(oconfig.OutputThreads);
+    unsigned int sectnum = 0;
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i, ++sectnum)
+    {
+        if (i->isBSS())
+            continue;
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        ElfPadOutput(os, &pos, elfsect->getFileOffset());
+        renderer.Output(sectnum, os);
+        pos += elfsect->getSize().getUInt64();
+        // release memory as we go
+        std::string().swap(elfsect->getCompressedData());
+    }
+    renderer.Finish();
+
+    ElfPadOutput(os, &pos, shstrtab_sect.getFileOffset());
+    shstrtab.Write(os);
+    pos += shstrtab.getSize();
+
+    ElfPadOutput(os, &pos, strtab_sect.getFileOffset());
+    strtab.Write(os);
+    pos += strtab.getSize();
+
+    ElfPadOutput(os, &pos, symtab_sect.getFileOffset());
+    os << symtab_data;
+    pos += symtab_data.size();
+
+    if (need_shndx)
+    {
+        ElfPadOutput(os, &pos, shndx_sect.getFileOffset());
+        os << shndx_data;
+        pos += shndx_data.size();
+    }
+
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i)
+    {
+        if (i->getRelocs().size() == 0)
+            continue;
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        ElfPadOutput(os, &pos, elfsect->getRelFileOffset());
+        pos += elfsect->WriteRelocs(os, *i, scratch, *m_machine, diags);
+    }
+
+    ElfPadOutput(os, &pos, m_config.secthead_pos);
+
     // null section header
-    null_sect.Write(os, out.getScratch());
+    null_sect.Write(os, scratch);
 
     // group section headers
     for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end; ++i)
@@ -1337,7 +1739,7 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         ElfSymbol* elfsym = i->sym->getAssocData<ElfSymbol>();
         group.elfsect->setInfo(elfsym->getSymbolIndex());
 
-        group.elfsect->Write(os, out.getScratch());
+        group.elfsect->Write(os, scratch);
     }
 
     // user section headers
@@ -1347,13 +1749,15 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         ElfSection* elfsect = i->getAssocData<ElfSection>();
         assert(elfsect != 0);
 
-        elfsect->Write(os, out.getScratch());
+        elfsect->Write(os, scratch);
     }
 
     // standard section headers
-    shstrtab_sect.Write(os, out.getScratch());
-    strtab_sect.Write(os, out.getScratch());
-    symtab_sect.Write(os, out.getScratch());
+    shstrtab_sect.Write(os, scratch);
+    strtab_sect.Write(os, scratch);
+    symtab_sect.Write(os, scratch);
+    if (need_shndx)
+        shndx_sect.Write(os, scratch);
 
     // relocation section headers
     for (Object::section_iterator i=m_object.sections_begin(),
@@ -1363,18 +1767,8 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         assert(elfsect != 0);
 
         // relocation entries for .foo are stored in section .rel[a].foo
-        elfsect->WriteRel(os, symtab_sect.getIndex(), *i, out.getScratch());
+        elfsect->WriteRel(os, symtab_sect.getIndex(), *i, scratch);
     }
-
-    // output Ehdr
-    os.seek(0);
-    if (os.has_error())
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_seek);
-        return;
-    }
-
-    m_config.WriteProgramHeader(os, out.getScratch());
 }
 
 Section*
@@ -2015,7 +2409,9 @@ ElfObject::getDebugFormatKeywords()
         "dwarf",
         "dwarfpass",
         "dwarf2",
-        "dwarf2pass"
+        "dwarf2pass",
+        "dwarf64",
+        "dwarf64pass"
     };
     size_t keywords_size = sizeof(keywords)/sizeof(keywords[0]);
     return std::vector<llvm::StringRef>(keywords, keywords+keywords_size);
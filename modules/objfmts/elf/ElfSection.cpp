@@ -81,7 +81,7 @@ ElfSection::ElfSection(const ElfConfig&             config,
         m_flags = static_cast<ElfSectionFlags>(ReadU32(inbuf));
         m_addr = ReadU32(inbuf);
 
-        m_offset = static_cast<ElfAddress>(ReadU32(inbuf));
+        m_offset = ReadU32(inbuf);
         m_size = ReadU32(inbuf);
         m_link = static_cast<ElfSectionIndex>(ReadU32(inbuf));
         m_info = static_cast<ElfSectionInfo>(ReadU32(inbuf));
@@ -100,7 +100,7 @@ ElfSection::ElfSection(const ElfConfig&             config,
         m_flags = static_cast<ElfSectionFlags>(ReadU64(inbuf).getUInt());
         m_addr = ReadU64(inbuf);
 
-        m_offset = static_cast<ElfAddress>(ReadU64(inbuf).getUInt());
+        m_offset = ReadU64(inbuf).getUInt64();
         m_size = ReadU64(inbuf);
         m_link = static_cast<ElfSectionIndex>(ReadU32(inbuf));
         m_info = static_cast<ElfSectionInfo>(ReadU32(inbuf));
@@ -211,7 +211,7 @@ ElfSection::Write(llvm::raw_ostream& os, Bytes& scratch) const
         Write32(scratch, m_flags);
         Write32(scratch, m_addr);
 
-        Write32(scratch, m_offset);
+        Write32(scratch, static_cast<unsigned long>(m_offset));
         Write32(scratch, m_size);
         Write32(scratch, m_link);
         Write32(scratch, m_info);
@@ -289,6 +289,17 @@ ElfSection::LoadSectionData(Section& sect,
     return true;
 }
 
+unsigned long
+ElfSection::getRelocsSize(const Section& sect) const
+{
+    unsigned long size = 0;
+    if (m_config.cls == ELFCLASS32)
+        size = m_config.rela ? RELOC32A_SIZE : RELOC32_SIZE;
+    else if (m_config.cls == ELFCLASS64)
+        size = m_config.rela ? RELOC64A_SIZE : RELOC64_SIZE;
+    return size * sect.getRelocs().size();
+}
+
 unsigned long
 ElfSection::WriteRel(llvm::raw_ostream& os,
                      ElfSectionIndex symtab_idx,
@@ -310,7 +321,7 @@ ElfSection::WriteRel(llvm::raw_ostream& os,
         size = m_config.rela ? RELOC32A_SIZE : RELOC32_SIZE;
         Write32(scratch, 0);                    // flags=0
         Write32(scratch, 0);                    // vmem address=0
-        Write32(scratch, m_rel_offset);
+        Write32(scratch, static_cast<unsigned long>(m_rel_offset));
         Write32(scratch, size * sect.getRelocs().size());// size
         Write32(scratch, symtab_idx);           // link: symtab index
         Write32(scratch, m_index);              // info: relocated's index
@@ -348,18 +359,7 @@ ElfSection::WriteRelocs(llvm::raw_ostream& os,
     if (sect.getRelocs().size() == 0)
         return 0;
 
-    // first align section to multiple of 4
-    uint64_t pos = os.tell();
-    if (os.has_error())
-    {
-        diags.Report(SourceLocation(), diag::err_file_output_position);
-        pos = 0;
-    }
-    uint64_t apos = (pos + 3) & ~3;
-    for (; pos < apos; ++pos)
-        os << '\0';
-    m_rel_offset = static_cast<unsigned long>(pos);
-
+    // caller has already positioned the output at m_rel_offset
     unsigned long size = 0;
     for (Section::reloc_iterator i=sect.relocs_begin(), end=sect.relocs_end();
          i != end; ++i)
@@ -381,7 +381,8 @@ ElfSection::ReadRelocs(const llvm::MemoryBuffer&    in,
                        const ElfSymtab&             symtab,
                        bool                         rela) const
 {
-    unsigned long start = reloc_sect.getFileOffset();
+    unsigned long start =
+        static_cast<unsigned long>(reloc_sect.getFileOffset());
     unsigned long end = start + reloc_sect.getSize().getUInt();
     for (unsigned long pos = start; pos < end; )
     {
@@ -390,10 +391,10 @@ ElfSection::ReadRelocs(const llvm::MemoryBuffer&    in,
     }
 }
 
-unsigned long
-ElfSection::setFileOffset(unsigned long pos)
+ElfOffset
+ElfSection::setFileOffset(ElfOffset pos)
 {
-    const unsigned long align = m_align;
+    const ElfOffset align = m_align;
 
     if (align == 0 || align == 1)
     {
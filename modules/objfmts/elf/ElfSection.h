@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 #include <iosfwd>
+#include <string>
 #include <vector>
 
 #include "yasmx/Config/export.h"
@@ -97,7 +98,7 @@ public:
     unsigned long getAlign() const { return m_align; }
     void setAlign(unsigned long align) { m_align = align; }
 
-    ElfSectionIndex getIndex() { return m_index; }
+    ElfSectionIndex getIndex() const { return m_index; }
 
     void setInfo(ElfSectionInfo info) { m_info = info; }
     ElfSectionInfo getInfo() const { return m_info; }
@@ -117,6 +118,11 @@ public:
     void setSize(const IntNum& size) { m_size = size; }
     IntNum getSize() const { return m_size; }
 
+    /// Get the size of the relocation table for a section.
+    unsigned long getRelocsSize(const Section& sect) const;
+    void setRelFileOffset(ElfOffset pos) { m_rel_offset = pos; }
+    ElfOffset getRelFileOffset() const { return m_rel_offset; }
+
     unsigned long WriteRel(llvm::raw_ostream& os,
                            ElfSectionIndex symtab,
                            Section& sect,
@@ -133,8 +139,12 @@ public:
                     const ElfSymtab& symtab,
                     bool rela) const;
 
-    unsigned long setFileOffset(unsigned long pos);
-    unsigned long getFileOffset() const { return m_offset; }
+    ElfOffset setFileOffset(ElfOffset pos);
+    ElfOffset getFileOffset() const { return m_offset; }
+
+    /// Get the contents (compression header and compressed data) of a
+    /// section compressed during output (SHF_COMPRESSED).
+    std::string& getCompressedData() { return m_compressed; }
 
 private:
     const ElfConfig&    m_config;
@@ -142,7 +152,7 @@ private:
     ElfSectionType      m_type;
     ElfSectionFlags     m_flags;
     IntNum              m_addr;
-    ElfAddress          m_offset;
+    ElfOffset           m_offset;
     IntNum              m_size;
     ElfSectionIndex     m_link;
     ElfSectionInfo      m_info;         // see note ESD1
@@ -154,7 +164,9 @@ private:
 
     ElfStringIndex      m_rel_name_index;
     ElfSectionIndex     m_rel_index;
-    ElfAddress          m_rel_offset;
+    ElfOffset           m_rel_offset;
+
+    std::string         m_compressed;   // only used during output
 };
 
 // Note ESD1:
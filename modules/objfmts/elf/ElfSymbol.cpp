@@ -49,10 +49,12 @@ const char* ElfSymbol::key = "objfmt::elf::ElfSymbol";
 ElfSymbol::ElfSymbol(const ElfConfig&           config,
                      const llvm::MemoryBuffer&  in,
                      const ElfSection&          symtab_sect,
+                     const ElfSection*          shndx_sect,
                      ElfSymbolIndex             index,
                      Section*                   sections[],
                      Diagnostic&                diags)
     : m_sect(0)
+    , m_elfsect(0)
     , m_name_index(0)
     , m_value(0)
     , m_symindex(index)
@@ -86,18 +88,35 @@ ElfSymbol::ElfSymbol(const ElfConfig&           config,
     m_vis = ELF_ST_VISIBILITY(ReadU8(inbuf));
 
     m_index = static_cast<ElfSectionIndex>(ReadU16(inbuf));
-    if (m_index != SHN_UNDEF && m_index < config.secthead_count)
-        m_sect = sections[m_index];
 
     if (config.cls == ELFCLASS64)
     {
         m_value = ReadU64(inbuf);
         m_size = Expr(ReadU64(inbuf));
     }
+
+    // Section index too large to fit; look it up in the extended section
+    // index table.
+    bool real_index = m_index < SHN_LORESERVE;
+    if (m_index == SHN_XINDEX && shndx_sect)
+    {
+        inbuf.setPosition(shndx_sect->getFileOffset() + index * 4);
+        if (inbuf.getReadableSize() < 4)
+        {
+            diags.Report(SourceLocation(), diag::err_symbol_unreadable);
+            return;
+        }
+        m_index = static_cast<ElfSectionIndex>(ReadU32(inbuf));
+        real_index = true;
+    }
+
+    if (real_index && m_index != SHN_UNDEF && m_index < config.secthead_count)
+        m_sect = sections[m_index];
 }
 
 ElfSymbol::ElfSymbol()
     : m_sect(0)
+    , m_elfsect(0)
     , m_name_index(0)
     , m_value(0)
     , m_index(SHN_UNDEF)
@@ -135,7 +154,12 @@ ElfSymbol::CreateSymbol(Object& object, const StringTable& strtab) const
         sym = object.AppendSymbol(name);
     }
 
-    if (m_index == SHN_ABS)
+    if (m_sect != 0)
+    {
+        Location loc = {&m_sect->bytecodes_front(), m_value.getUInt()};
+        sym->DefineLabel(loc);
+    }
+    else if (m_index == SHN_ABS)
     {
         if (hasSize())
             sym->DefineEqu(m_size);
@@ -146,11 +170,6 @@ ElfSymbol::CreateSymbol(Object& object, const StringTable& strtab) const
     {
         sym->Declare(Symbol::COMMON);
     }
-    else if (m_sect != 0)
-    {
-        Location loc = {&m_sect->bytecodes_front(), m_value.getUInt()};
-        sym->DefineLabel(loc);
-    }
 
     return sym;
 }
@@ -348,6 +367,26 @@ ElfSymbol::Finalize(Symbol& sym, Diagnostic& diags)
     }
 }
 
+ElfSectionIndex
+ElfSymbol::getExtendedIndex() const
+{
+    ElfSectionIndex index;
+    if (m_sect)
+    {
+        ElfSection* elfsect = m_sect->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+        index = elfsect->getIndex();
+    }
+    else if (m_elfsect)
+        index = m_elfsect->getIndex();
+    else
+        return 0;   // special index (e.g. SHN_ABS)
+
+    if (index < SHN_LORESERVE)
+        return 0;
+    return index;
+}
+
 void
 ElfSymbol::Write(Bytes& bytes, const ElfConfig& config, Diagnostic& diags)
 {
@@ -385,12 +424,16 @@ ElfSymbol::Write(Bytes& bytes, const ElfConfig& config, Diagnostic& diags)
     Write8(bytes, ELF_ST_INFO(m_bind, m_type));
     Write8(bytes, ELF_ST_OTHER(m_vis));
 
-    if (m_sect)
+    if (getExtendedIndex() != 0)
+        Write16(bytes, SHN_XINDEX);
+    else if (m_sect)
     {
         ElfSection* elfsect = m_sect->getAssocData<ElfSection>();
         assert(elfsect != 0);
         Write16(bytes, elfsect->getIndex());
     }
+    else if (m_elfsect)
+        Write16(bytes, m_elfsect->getIndex());
     else
     {
         Write16(bytes, m_index);
@@ -65,6 +65,7 @@ public:
     ElfSymbol(const ElfConfig&          config,
               const llvm::MemoryBuffer& in,
               const ElfSection&         symtab_sect,
+              const ElfSection*         shndx_sect,
               ElfSymbolIndex            index,
               Section*                  sections[],
               Diagnostic&               diags);
@@ -83,9 +84,20 @@ public:
 
     void setSection(Section* sect) { m_sect = sect; }
     void setName(ElfStringIndex index) { m_name_index = index; }
+    ElfStringIndex getName() const { return m_name_index; }
     bool hasName() const { return m_name_index != 0; }
     void setSectionIndex(ElfSectionIndex index) { m_index = index; }
 
+    /// Set the section for a section that has no corresponding Section
+    /// (e.g. a group section).
+    void setElfSection(const ElfSection* elfsect) { m_elfsect = elfsect; }
+
+    /// Get the section index to be stored in the extended section index
+    /// table (.symtab_shndx).
+    /// @return Section index, or 0 if the section index fits in the
+    ///         symbol table entry itself.
+    ElfSectionIndex getExtendedIndex() const;
+
     ElfSymbolVis getVisibility() const { return m_vis; }
     void setVisibility(ElfSymbolVis vis)
     {
@@ -127,6 +139,7 @@ public:
 
 private:
     Section*                m_sect;
+    const ElfSection*       m_elfsect;
     ElfStringIndex          m_name_index;
     IntNum                  m_value;
     SymbolRef               m_value_rel;
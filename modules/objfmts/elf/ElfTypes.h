@@ -28,6 +28,7 @@
 
 #include <vector>
 
+#include "llvm/System/DataTypes.h"
 #include "yasmx/SymbolRef.h"
 
 
@@ -43,7 +44,7 @@ class ElfSection;
 class ElfSymbol;
 
 typedef unsigned long ElfAddress;
-typedef unsigned long ElfOffset;
+typedef uint64_t ElfOffset;
 typedef unsigned long ElfSize;
 typedef unsigned long ElfSectionInfo;
 typedef unsigned long ElfStringIndex;
@@ -177,11 +178,18 @@ enum ElfSectionFlagValues
     SHF_STRINGS = 0x20,         // contains 0-terminated strings
     SHF_GROUP = 0x200,          // member of a section group
     SHF_TLS = 0x400,            // thread local storage
+    SHF_COMPRESSED = 0x800,     // contains compressed data
     SHF_MASKOS = 0x0f000000/*,  // environment specific use
     SHF_MASKPROC = 0xf0000000*/ // bits reserved for processor specific needs
 };
 typedef unsigned long ElfSectionFlags;
 
+// elf compressed section header (Chdr) compression types
+enum ElfCompressionType
+{
+    ELFCOMPRESS_ZLIB = 1        // ZLIB/DEFLATE algorithm
+};
+
 // elf section index - just the special ones
 enum ElfSectionIndexValues
 {
@@ -193,6 +201,7 @@ enum ElfSectionIndexValues
     SHN_HIOS = 0xff3f,
     SHN_ABS = 0xfff1,           // associated symbols don't change on reloc
     SHN_COMMON = 0xfff2,        // associated symbols refer to unallocated
+    SHN_XINDEX = 0xffff,        // actual index is in extended index table
     SHN_HIRESERVE = 0xffff
 };
 typedef unsigned int ElfSectionIndex;
@@ -47,6 +47,7 @@
 #include "yasmx/Object_util.h"
 #include "yasmx/Reloc.h"
 #include "yasmx/Section.h"
+#include "yasmx/SectionRenderer.h"
 #include "yasmx/Symbol.h"
 #include "yasmx/Symbol_util.h"
 #include "yasmx/Value.h"
@@ -84,44 +85,52 @@ RdfObject::getDebugFormatKeywords()
 }
 
 namespace {
-class RdfOutput : public BytecodeOutput
+class RdfOutput : public BytecodeStreamOutput
 {
 public:
     RdfOutput(llvm::raw_ostream& os, Object& object, Diagnostic& diags);
     ~RdfOutput();
 
-    void OutputSectionToMemory(Section& sect);
+    void OutputSection(Section& sect);
     void OutputSectionRelocs(const Section& sect);
-    void OutputSectionToFile(const Section& sect);
+    void OutputSectionToFile(const Section& sect,
+                             SectionRenderer& renderer,
+                             unsigned int n);
 
     void OutputSymbol(Symbol& sym, bool all_syms, unsigned int* indx);
 
-    void OutputBSS();
+    void OutputBSS(unsigned long bss_size);
 
     // BytecodeOutput overrides
     bool ConvertValueToBytes(Value& value,
                              Location loc,
                              NumericOutput& num_out);
-    void DoOutputGap(unsigned long size, SourceLocation source);
-    void DoOutputBytes(const Bytes& bytes, SourceLocation source);
 
 private:
-    llvm::raw_ostream& m_os;
-
-    RdfSection* m_rdfsect;
     Object& m_object;
     BytecodeNoOutput m_no_output;
+};
+
+class RdfRenderer : public SectionRenderer
+{
+public:
+    RdfRenderer(Object& object, Diagnostic& diags);
+    ~RdfRenderer();
+
+protected:
+    void RenderSection(Section& sect,
+                       llvm::raw_ostream& os,
+                       Diagnostic& diags);
 
-    unsigned long m_bss_size;       // total BSS size
+private:
+    Object& m_object;
 };
 } // anonymous namespace
 
 RdfOutput::RdfOutput(llvm::raw_ostream& os, Object& object, Diagnostic& diags)
-    : BytecodeOutput(diags)
-    , m_os(os)
+    : BytecodeStreamOutput(os, diags)
     , m_object(object)
     , m_no_output(diags)
-    , m_bss_size(0)
 {
 }
 
@@ -215,26 +224,12 @@ RdfOutput::ConvertValueToBytes(Value& value,
 }
 
 void
-RdfOutput::DoOutputGap(unsigned long size, SourceLocation source)
-{
-    Diag(source, diag::warn_uninit_zero);
-    m_rdfsect->raw_data.insert(m_rdfsect->raw_data.end(), size, 0);
-}
-
-void
-RdfOutput::DoOutputBytes(const Bytes& bytes, SourceLocation source)
-{
-    m_rdfsect->raw_data.insert(m_rdfsect->raw_data.end(), bytes.begin(),
-                               bytes.end());
-}
-
-void
-RdfOutput::OutputSectionToMemory(Section& sect)
+RdfOutput::OutputSection(Section& sect)
 {
     BytecodeOutput* outputter = this;
 
-    m_rdfsect = sect.getAssocData<RdfSection>();
-    assert(m_rdfsect != 0);
+    RdfSection* rdfsect = sect.getAssocData<RdfSection>();
+    assert(rdfsect != 0);
 
     if (sect.isBSS())
     {
@@ -242,11 +237,8 @@ RdfOutput::OutputSectionToMemory(Section& sect)
         outputter = &m_no_output;
     }
 
-    // See UGH comment in output() for why we're doing this
-    m_rdfsect->raw_data.clear();
-    unsigned long size = 0;
-
     // Output bytecodes
+    uint64_t size = 0;
     for (Section::bc_iterator i=sect.bytecodes_begin(),
          end=sect.bytecodes_end(); i != end; ++i)
     {
@@ -254,17 +246,31 @@ RdfOutput::OutputSectionToMemory(Section& sect)
             size += i->getTotalLen();
     }
 
+    if (getDiagnostics().hasErrorOccurred())
+        return;
+
     // Sanity check final section size
     assert(size == sect.bytecodes_back().getNextOffset());
+    rdfsect->size = sect.isBSS() ? 0 : static_cast<unsigned long>(size);
+}
 
-    if (sect.isBSS())
-    {
-        m_bss_size += size;
-        return;
-    }
+RdfRenderer::RdfRenderer(Object& object, Diagnostic& diags)
+    : SectionRenderer(object, diags)
+    , m_object(object)
+{
+}
 
-    // Sanity check raw data size
-    assert(m_rdfsect->raw_data.size() == size);
+RdfRenderer::~RdfRenderer()
+{
+}
+
+void
+RdfRenderer::RenderSection(Section& sect,
+                           llvm::raw_ostream& os,
+                           Diagnostic& diags)
+{
+    RdfOutput out(os, m_object, diags);
+    out.OutputSection(sect);
 }
 
 void
@@ -288,7 +294,9 @@ RdfOutput::OutputSectionRelocs(const Section& sect)
 }
 
 void
-RdfOutput::OutputSectionToFile(const Section& sect)
+RdfOutput::OutputSectionToFile(const Section& sect,
+                               SectionRenderer& renderer,
+                               unsigned int n)
 {
     const RdfSection* rdfsect = sect.getAssocData<RdfSection>();
     assert(rdfsect != 0);
@@ -300,7 +308,7 @@ RdfOutput::OutputSectionToFile(const Section& sect)
     }
 
     // Empty?  Go on to next section
-    if (rdfsect->raw_data.empty())
+    if (rdfsect->size == 0)
         return;
 
     // Section header
@@ -310,7 +318,7 @@ RdfOutput::OutputSectionToFile(const Section& sect)
     m_os << bytes;
 
     // Section data
-    m_os << rdfsect->raw_data;
+    renderer.Output(n, m_os);
 }
 
 enum RdfSymbolFlags
@@ -507,16 +515,16 @@ RdfOutput::OutputSymbol(Symbol& sym, bool all_syms, unsigned int* indx)
 }
 
 void
-RdfOutput::OutputBSS()
+RdfOutput::OutputBSS(unsigned long bss_size)
 {
-    if (m_bss_size == 0)
+    if (bss_size == 0)
         return;
 
     Bytes& bytes = getScratch();
     bytes.setLittleEndian();
     Write8(bytes, RDFREC_BSS);      // record type
     Write8(bytes, 4);               // record length
-    Write32(bytes, m_bss_size);     // total BSS size
+    Write32(bytes, bss_size);       // total BSS size
     m_os << bytes;
 }
 
@@ -578,29 +586,32 @@ RdfObject::Output(llvm::raw_fd_ostream& os,
     // we only know if we have relocs when we output the sections, we have
     // to output the section data before we have output the relocs.  But
     // we also don't know how much space to preallocate for relocs, so....
-    // we output into memory buffers first (thus the UGH).
+    // we render the sections without keeping the output first, and render
+    // them again for the section data (thus the UGH).
     //
     // Stupid object format design, if you ask me (basically all other
     // object formats put the relocs *after* the section data to avoid this
     // exact problem).
     //
-    // We also calculate the total size of all BSS sections here.
-    //
-    for (Object::section_iterator i = m_object.sections_begin(),
-         end = m_object.sections_end(); i != end; ++i)
-    {
-        out.OutputSectionToMemory(*i);
-    }
+    RdfRenderer renderer(m_object, diags);
+    renderer.Prepare(m_object.getConfig().OutputThreads);
 
-    // Output all relocs
+    if (diags.hasErrorOccurred())
+        return;
+
+    // Output all relocs.  We also calculate the total size of all BSS
+    // sections here.
+    unsigned long bss_size = 0;
     for (Object::const_section_iterator i = m_object.sections_begin(),
          end = m_object.sections_end(); i != end; ++i)
     {
         out.OutputSectionRelocs(*i);
+        if (i->isBSS())
+            bss_size += i->bytecodes_back().getNextOffset();
     }
 
     // Output BSS record
-    out.OutputBSS();
+    out.OutputBSS(bss_size);
 
     // Determine header length
     uint64_t pos = os.tell();
@@ -612,11 +623,14 @@ RdfObject::Output(llvm::raw_fd_ostream& os,
     unsigned long headerlen = static_cast<unsigned long>(pos);
 
     // Section data (to file)
+    renderer.Start(m_object.getConfig().OutputThreads);
+    unsigned int sectnum = 0;
     for (Object::const_section_iterator i = m_object.sections_begin(),
-         end = m_object.sections_end(); i != end; ++i)
+         end = m_object.sections_end(); i != end; ++i, ++sectnum)
     {
-        out.OutputSectionToFile(*i);
+        out.OutputSectionToFile(*i, renderer, sectnum);
     }
+    renderer.Finish();
 
     // NULL section to end file
     {
@@ -42,6 +42,7 @@ RdfSection::RdfSection(Type type_, SymbolRef sym_)
     , scnum(0)
     , type(type_)
     , reserved(0)
+    , size(0)
 {
 }
 
@@ -58,7 +59,7 @@ RdfSection::Write(pugi::xml_node out) const
     append_child(root, "Sym", sym);
     root.append_attribute("scnum") = scnum;
     append_child(root, "Reserved", reserved);
-    append_child(root, "RawData", raw_data);
+    append_child(root, "Size", size);
     return root;
 }
 #endif // WITH_XML
@@ -70,7 +71,7 @@ RdfSection::Write(Bytes& bytes, const Section& sect) const
     Write16(bytes, type);               // type
     Write16(bytes, scnum);              // number
     Write16(bytes, reserved);           // reserved
-    Write32(bytes, raw_data.size());    // length
+    Write32(bytes, size);               // length
 }
 
 void
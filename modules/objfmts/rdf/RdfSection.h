@@ -81,7 +81,7 @@ struct YASM_STD_EXPORT RdfSection : public AssocData
     unsigned int scnum;     ///< section number (0=first section)
     Type type;              ///< section type
     unsigned int reserved;  ///< reserved data
-    Bytes raw_data;         ///< raw section data, only used during output
+    unsigned long size;     ///< section data size, only used during output
 };
 
 }} // namespace yasm::objfmt
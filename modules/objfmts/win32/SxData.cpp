@@ -49,7 +49,7 @@ public:
 
     /// Calculates the minimum size of a bytecode.
     bool CalcLen(Bytecode& bc,
-                 /*@out@*/ unsigned long* len,
+                 /*@out@*/ uint64_t* len,
                  const Bytecode::AddSpanFunc& add_span,
                  Diagnostic& diags);
 
@@ -87,7 +87,7 @@ SxData::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 SxData::CalcLen(Bytecode& bc,
-                /*@out@*/ unsigned long* len,
+                /*@out@*/ uint64_t* len,
                 const Bytecode::AddSpanFunc& add_span,
                 Diagnostic& diags)
 {
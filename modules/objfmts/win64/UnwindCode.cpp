@@ -52,13 +52,13 @@ UnwindCode::Finalize(Bytecode& bc, Diagnostic& diags)
 
 bool
 UnwindCode::CalcLen(Bytecode& bc,
-                    /*@out@*/ unsigned long* len,
+                    /*@out@*/ uint64_t* len,
                     const Bytecode::AddSpanFunc& add_span,
                     Diagnostic& diags)
 {
     *len = 0;
     int span = 0;
-    long low, high, mask;
+    int64_t low, high, mask;
 
     *len += 1;  // Code and info
 
@@ -107,7 +107,7 @@ UnwindCode::CalcLen(Bytecode& bc,
     IntNum intn;
     if (m_off.getIntNum(&intn, false, diags))
     {
-        long intv = intn.getInt();
+        int64_t intv = intn.getInt64();
         if (intv > high)
         {
             // Expand it ourselves here if we can and we're already larger
@@ -138,13 +138,13 @@ UnwindCode::CalcLen(Bytecode& bc,
 
 bool
 UnwindCode::Expand(Bytecode& bc,
-                   unsigned long* len,
+                   uint64_t* len,
                    int span,
-                   long old_val,
-                   long new_val,
+                   int64_t old_val,
+                   int64_t new_val,
                    bool* keep,
-                   /*@out@*/ long* neg_thres,
-                   /*@out@*/ long* pos_thres,
+                   /*@out@*/ int64_t* neg_thres,
+                   /*@out@*/ int64_t* pos_thres,
                    Diagnostic& diags)
 {
     if (new_val < 0)
@@ -93,17 +93,17 @@ public:
 
     virtual bool Finalize(Bytecode& bc, Diagnostic& diags);
     virtual bool CalcLen(Bytecode& bc,
-                         /*@out@*/ unsigned long* len,
+                         /*@out@*/ uint64_t* len,
                          const Bytecode::AddSpanFunc& add_span,
                          Diagnostic& diags);
     virtual bool Expand(Bytecode& bc,
-                        unsigned long* len,
+                        uint64_t* len,
                         int span,
-                        long old_val,
-                        long new_val,
+                        int64_t old_val,
+                        int64_t new_val,
                         bool* keep,
-                        /*@out@*/ long* neg_thres,
-                        /*@out@*/ long* pos_thres,
+                        /*@out@*/ int64_t* neg_thres,
+                        /*@out@*/ int64_t* pos_thres,
                         Diagnostic& diags);
     virtual bool Output(Bytecode& bc, BytecodeOutput& bc_out);
     llvm::StringRef getType() const;
@@ -44,6 +44,7 @@
 #include "yasmx/Location_util.h"
 #include "yasmx/Object.h"
 #include "yasmx/Section.h"
+#include "yasmx/SectionRenderer.h"
 #include "yasmx/Symbol.h"
 
 #include "XdfReloc.h"
@@ -97,6 +98,9 @@ public:
     ~XdfOutput();
 
     void OutputSection(Section& sect);
+    void OutputSectionToFile(Section& sect,
+                             SectionRenderer& renderer,
+                             unsigned int n);
     void OutputSymbol(const Symbol& sym,
                       bool all_syms,
                       unsigned long* strtab_offset);
@@ -110,6 +114,21 @@ private:
     Object& m_object;
     BytecodeNoOutput m_no_output;
 };
+
+class XdfRenderer : public SectionRenderer
+{
+public:
+    XdfRenderer(Object& object, Diagnostic& diags);
+    ~XdfRenderer();
+
+protected:
+    void RenderSection(Section& sect,
+                       llvm::raw_ostream& os,
+                       Diagnostic& diags);
+
+private:
+    Object& m_object;
+};
 } // anonymous namespace
 
 XdfOutput::XdfOutput(llvm::raw_ostream& os, Object& object, Diagnostic& diags)
@@ -176,22 +195,9 @@ XdfOutput::OutputSection(Section& sect)
     XdfSection* xsect = sect.getAssocData<XdfSection>();
     assert(xsect != NULL);
 
-    uint64_t pos;
+    // Don't output BSS sections.
     if (sect.isBSS())
-    {
-        // Don't output BSS sections.
         outputter = &m_no_output;
-        pos = 0;    // position = 0 because it's not in the file
-    }
-    else
-    {
-        pos = m_os.tell();
-        if (m_os.has_error())
-        {
-            Diag(SourceLocation(), diag::err_file_output_position);
-            return;
-        }
-    }
 
     // Output bytecodes
     xsect->size = 0;
@@ -202,8 +208,36 @@ XdfOutput::OutputSection(Section& sect)
             xsect->size += i->getTotalLen();
     }
 
+    if (getDiagnostics().hasErrorOccurred())
+        return;
+
     // Sanity check final section size
     assert(xsect->size == sect.bytecodes_back().getNextOffset());
+}
+
+void
+XdfOutput::OutputSectionToFile(Section& sect,
+                               SectionRenderer& renderer,
+                               unsigned int n)
+{
+    XdfSection* xsect = sect.getAssocData<XdfSection>();
+    assert(xsect != NULL);
+
+    uint64_t pos;
+    if (sect.isBSS())
+        pos = 0;    // position = 0 because it's not in the file
+    else
+    {
+        pos = m_os.tell();
+        if (m_os.has_error())
+        {
+            Diag(SourceLocation(), diag::err_file_output_position);
+            return;
+        }
+    }
+    renderer.Output(n, m_os);
+    if (getDiagnostics().hasErrorOccurred())
+        return;
 
     // Empty?  Go on to next section
     if (xsect->size == 0)
@@ -234,6 +268,25 @@ XdfOutput::OutputSection(Section& sect)
     }
 }
 
+XdfRenderer::XdfRenderer(Object& object, Diagnostic& diags)
+    : SectionRenderer(object, diags)
+    , m_object(object)
+{
+}
+
+XdfRenderer::~XdfRenderer()
+{
+}
+
+void
+XdfRenderer::RenderSection(Section& sect,
+                           llvm::raw_ostream& os,
+                           Diagnostic& diags)
+{
+    XdfOutput out(os, m_object, diags);
+    out.OutputSection(sect);
+}
+
 void
 XdfOutput::OutputSymbol(const Symbol& sym,
                         bool all_syms,
@@ -373,11 +426,18 @@ XdfObject::Output(llvm::raw_fd_ostream& os,
     }
 
     // Output section data/relocs
+    XdfRenderer renderer(m_object, diags);
+    renderer.Start(m_object.getConfig().OutputThreads);
+    unsigned int sectnum = 0;
     for (Object::section_iterator i=m_object.sections_begin(),
-         end=m_object.sections_end(); i != end; ++i)
+         end=m_object.sections_end(); i != end; ++i, ++sectnum)
     {
-        out.OutputSection(*i);
+        out.OutputSectionToFile(*i, renderer, sectnum);
     }
+    renderer.Finish();
+
+    if (diags.hasErrorOccurred())
+        return;
 
     // Write headers
     os.seek(0);
@@ -40,6 +40,7 @@
 #include "yasmx/Config/export.h"
 #include "yasmx/Parse/Parser.h"
 #include "yasmx/Parse/ParserImpl.h"
+#include "yasmx/Parse/Token.h"
 #include "yasmx/Insn.h"
 #include "yasmx/IntNum.h"
 
@@ -65,6 +66,7 @@ namespace parser
 #define YYCTYPE         char
 
 class GasParser;
+class GasIrpPasses;
 struct GasDirLookup
 {
     const char* name;
@@ -72,6 +74,30 @@ struct GasDirLookup
     unsigned int param;
 };
 
+/// A .macro definition.  The body is lexed once when the macro is defined
+/// and kept as a token vector; parameters are substituted at the token level
+/// when the macro is expanded.
+struct GasMacro
+{
+    typedef std::vector<Token> Tokens;
+
+    struct Param
+    {
+        IdentifierInfo* name;
+        Tokens def;             // default value
+        bool required;          // :req
+        bool vararg;            // :vararg
+    };
+
+    GasMacro() : has_escapes(false), expansions(0) {}
+
+    std::vector<Param> params;
+    Tokens body;
+    SourceLocation source;
+    bool has_escapes;           // body contains \ escape sequences
+    unsigned long expansions;   // number of times macro has been expanded
+};
+
 class YASM_STD_EXPORT GasParser : public ParserImpl
 {
 public:
@@ -89,6 +115,16 @@ public:
     void Parse(Object& object, Directives& dirs, Diagnostic& diags);
 
 private:
+    friend class GasDirHash;
+    friend class GasIrpPasses;
+
+    /// Look up a GAS-specific directive by name.  The fixed directives
+    /// are found through a perfect hash table generated at build time
+    /// (see GasParser_dirs.gperf); arch-sized directives are checked after.
+    /// @param name     directive name, including leading '.'; must be
+    ///                 followed by a NUL character in memory
+    /// @return Directive lookup entry, or NULL if not a GAS directive.
+    const GasDirLookup* FindGasDir(llvm::StringRef name) const;
 
     /// Get the local label name for the given numeric index + suffix.
     /// @param name     label name (output)
@@ -121,6 +157,7 @@ private:
     bool ParseDirMacro(unsigned int, SourceLocation source);
     bool ParseDirEndm(unsigned int, SourceLocation source);
     bool ParseDirRept(unsigned int, SourceLocation source);
+    bool ParseDirIrp(unsigned int is_irpc, SourceLocation source);
     bool ParseDirEndr(unsigned int, SourceLocation source);
     bool ParseDirAlign(unsigned int power2, SourceLocation source);
     bool ParseDirOrg(unsigned int, SourceLocation source);
@@ -155,6 +192,44 @@ private:
 
     bool ParseDirSyntax(unsigned int intel, SourceLocation source);
 
+    /// Lex and save tokens until the .endr (or .endm if is_macro) matching
+    /// the current block.  The terminating directive is not consumed.
+    /// @param body     body tokens (output)
+    /// @param is_macro true for a .macro body, false for .rept/.irp/.irpc
+    /// @param source   source location of the block directive
+    /// @return False if end of file was reached first.
+    bool CollectBody(GasMacro::Tokens* body, bool is_macro,
+                     SourceLocation source);
+
+    /// Parse a single macro or .irp argument up to a separating comma or
+    /// whitespace, or end of statement.  If vararg is true, the rest of the
+    /// statement is included in the argument.
+    void ParseMacroArg(GasMacro::Tokens* arg, bool vararg);
+
+    /// Expand a macro invocation; the current token is the first token
+    /// after the macro name.
+    bool ExpandMacro(GasMacro& macro, llvm::StringRef name,
+                     SourceLocation source);
+
+    /// Append body to out, replacing each \name by the matching value
+    /// tokens, \@ by count, and removing \().
+    void SubstituteTokens(GasMacro::Tokens* out,
+                          const GasMacro::Tokens& body,
+                          IdentifierInfo* const* names,
+                          const GasMacro::Tokens* values,
+                          unsigned int num_names,
+                          unsigned long count);
+
+    /// Append tok to out.  If paste is true and both tok and the last
+    /// token of out are identifiers or numbers, they are pasted together.
+    void AppendMacroToken(GasMacro::Tokens* out, const Token& tok, bool paste);
+
+    /// Turn tok into an identifier, label, or numeric constant token with
+    /// the given spelling, without re-lexing.
+    void MakeMacroToken(Token* tok, llvm::StringRef text);
+
+    bool isMacroEscape(const Token& tok) const;
+
     Insn::Ptr ParseInsn();
     bool ParseDirective(NameValues* nvs);
     Operand ParseMemoryAddress();
@@ -195,8 +270,13 @@ private:
     /*@null@*/ Bytecode* m_bc;
 
     GasDirLookup m_sized_gas_dirs[1];
-    typedef llvm::StringMap<const GasDirLookup*> GasDirMap;
-    GasDirMap m_gas_dirs;
+
+    // Macro definitions, keyed by lowercase name.
+    typedef llvm::StringMap<GasMacro> GasMacroMap;
+    GasMacroMap m_macros;
+
+    // Total number of macro expansions (value of \@).
+    unsigned long m_macro_count;
 
     // last "base" label for local (.) labels
     std::string m_locallabel_base;
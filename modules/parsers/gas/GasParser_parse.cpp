@@ -27,12 +27,19 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 //
+#define DEBUG_TYPE "GasParser"
+
 #include <cctype>
 #include <climits>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/SourceManager.h"
 #include "yasmx/Parse/Directive.h"
@@ -53,9 +60,22 @@
 #include "GasStringParser.h"
 
 
+STATISTIC(num_macro_expansions, "Number of macros expanded");
+
 using namespace yasm;
 using namespace yasm::parser;
 
+/// Macro names are case insensitive; get the lowercase lookup key.
+static llvm::StringRef
+getMacroKey(llvm::SmallVectorImpl<char>& buf, llvm::StringRef name)
+{
+    buf.clear();
+    for (llvm::StringRef::iterator i=name.begin(), end=name.end(); i != end;
+         ++i)
+        buf.push_back(tolower(static_cast<unsigned char>(*i)));
+    return llvm::StringRef(buf.data(), buf.size());
+}
+
 bool
 GasParser::getLocalLabel(llvm::SmallVectorImpl<char>& name,
                          llvm::StringRef num,
@@ -138,19 +158,35 @@ next:
                 break;
             }
 
-            // possibly a directive; try to parse it
             llvm::StringRef name = ii->getName();
+
+            // See if it's a macro invocation
+            if (!m_macros.empty())
+            {
+                llvm::SmallString<32> keybuf;
+                GasMacroMap::iterator m =
+                    m_macros.find(getMacroKey(keybuf, name));
+                if (m != m_macros.end())
+                {
+                    ConsumeToken();
+                    return ExpandMacro(m->getValue(), m->getKey(), exp_source);
+                }
+            }
+
+            // possibly a directive; try to parse it
             if (name[0] == '.')
             {
                 SourceLocation id_source = ConsumeToken();
 
-                // See if it's a gas-specific directive
-                GasDirMap::iterator p = m_gas_dirs.find(name);
-                if (p != m_gas_dirs.end())
+                // See if it's a gas-specific directive; the lookup result
+                // is cached on the identifier so it's only hashed once.
+                if (!ii->isDirLookupDone())
+                    ii->setDirective(FindGasDir(name));
+                if (const GasDirLookup* gasdir =
+                    ii->getDirective<const GasDirLookup>())
                 {
                     // call directive handler (function in this class) w/parameter
-                    return (this->*(p->second->handler))(p->second->param,
-                                                         id_source);
+                    return (this->*(gasdir->handler))(gasdir->param, id_source);
                 }
 
                 DirectiveInfo dirinfo(*m_object, m_container->getEndLoc(),
@@ -481,6 +517,441 @@ GasParser::ParseDirInclude(unsigned int param, SourceLocation source)
     return m_gas_preproc.HandleInclude(filename, filename_source);
 }
 
+bool
+GasParser::isMacroEscape(const Token& tok) const
+{
+    if (tok.isNot(GasToken::unknown) || tok.getLength() != 1)
+        return false;
+    char buf[1];
+    const char* spelling = buf;
+    m_preproc.getSpelling(tok, spelling);
+    return spelling[0] == '\\';
+}
+
+static inline bool
+isPasteable(const Token& tok)
+{
+    return tok.getIdentifierInfo() != 0 ||
+           tok.is(GasToken::numeric_constant);
+}
+
+static inline llvm::StringRef
+getPasteText(const Token& tok)
+{
+    if (IdentifierInfo* ii = tok.getIdentifierInfo())
+        return ii->getName();
+    return tok.getLiteral();
+}
+
+void
+GasParser::MakeMacroToken(Token* tok, llvm::StringRef text)
+{
+    tok->setLength(text.size());
+    if (!text.empty() && isdigit(static_cast<unsigned char>(text[0])))
+    {
+        // Numeric parsers expect a nul-terminated literal, so keep a copy.
+        char* buf = static_cast<char*>(
+            m_preproc.getPreprocessorAllocator().Allocate(text.size()+1, 1));
+        std::memcpy(buf, text.data(), text.size());
+        buf[text.size()] = '\0';
+        tok->setKind(GasToken::numeric_constant);
+        tok->setFlag(Token::Literal);
+        tok->setLiteralData(buf);
+        return;
+    }
+
+    tok->clearFlag(Token::Literal);
+    IdentifierInfo* ii = m_preproc.getIdentifierInfo(text);
+    tok->setIdentifierInfo(ii);
+    unsigned int kind = ii->getTokenKind();
+    if (kind == Token::unknown)
+    {
+        if (!text.empty() && (text[0] == '.' || text[0] == '_'))
+            kind = GasToken::label;
+        else
+            kind = GasToken::identifier;
+    }
+    tok->setKind(kind);
+}
+
+void
+GasParser::AppendMacroToken(GasMacro::Tokens* out, const Token& tok, bool paste)
+{
+    if (paste && !out->empty() && isPasteable(out->back()) && isPasteable(tok))
+    {
+        llvm::SmallString<64> text;
+        text += getPasteText(out->back());
+        text += getPasteText(tok);
+        MakeMacroToken(&out->back(), text);
+        return;
+    }
+    out->push_back(tok);
+}
+
+void
+GasParser::SubstituteTokens(GasMacro::Tokens* out,
+                            const GasMacro::Tokens& body,
+                            IdentifierInfo* const* names,
+                            const GasMacro::Tokens* values,
+                            unsigned int num_names,
+                            unsigned long count)
+{
+    // Set after a substitution; the next token is pasted onto the
+    // substituted text if there is no whitespace between them.
+    bool paste = false;
+
+    for (GasMacro::Tokens::size_type i=0, n=body.size(); i<n; ++i)
+    {
+        const Token& tok = body[i];
+        if (i+1 < n && !body[i+1].hasLeadingSpace() && isMacroEscape(tok))
+        {
+            const Token& next = body[i+1];
+
+            // \() just separates a parameter from following text.
+            if (next.is(GasToken::l_paren) && i+2 < n &&
+                body[i+2].is(GasToken::r_paren) &&
+                !body[i+2].hasLeadingSpace())
+            {
+                i += 2;
+                paste = true;
+                continue;
+            }
+
+            // \@ is the number of macros executed so far.
+            if (next.is(GasToken::at))
+            {
+                Token num = tok;
+                MakeMacroToken(&num, llvm::utostr(count));
+                AppendMacroToken(out, num, !tok.hasLeadingSpace());
+                ++i;
+                paste = true;
+                continue;
+            }
+
+            // \name is replaced by the parameter value.
+            IdentifierInfo* ii = next.getIdentifierInfo();
+            unsigned int j = 0;
+            if (ii)
+            {
+                while (j < num_names && names[j] != ii)
+                    ++j;
+            }
+            if (ii && j < num_names)
+            {
+                const GasMacro::Tokens& value = values[j];
+                for (GasMacro::Tokens::size_type k=0; k<value.size(); ++k)
+                {
+                    if (k != 0)
+                    {
+                        out->push_back(value[k]);
+                        continue;
+                    }
+                    // First token takes on the whitespace of the \.
+                    Token first = value[0];
+                    first.setFlagValue(Token::StartOfLine,
+                                       tok.isAtStartOfLine());
+                    first.setFlagValue(Token::LeadingSpace,
+                                       tok.hasLeadingSpace());
+                    AppendMacroToken(out, first, !tok.hasLeadingSpace());
+                }
+                ++i;
+                paste = true;
+                continue;
+            }
+        }
+        AppendMacroToken(out, tok, paste && !tok.hasLeadingSpace());
+        paste = false;
+    }
+}
+
+static bool
+isMacroArgOperator(const Token& tok)
+{
+    switch (tok.getKind())
+    {
+        case GasToken::plus:
+        case GasToken::minus:
+        case GasToken::star:
+        case GasToken::slash:
+        case GasToken::percent:
+        case GasToken::amp:
+        case GasToken::pipe:
+        case GasToken::caret:
+        case GasToken::exclaim:
+        case GasToken::tilde:
+        case GasToken::lessless:
+        case GasToken::greatergreater:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void
+GasParser::ParseMacroArg(GasMacro::Tokens* arg, bool vararg)
+{
+    int paren_depth = 0;
+    while (!m_token.isEndOfStatement())
+    {
+        // Arguments are separated by commas or whitespace, but whitespace
+        // around an operator keeps an expression together.
+        if (paren_depth == 0 && !vararg)
+        {
+            if (m_token.is(GasToken::comma))
+                break;
+            if (!arg->empty() && m_token.hasLeadingSpace() &&
+                !isMacroArgOperator(arg->back()) &&
+                !isMacroArgOperator(m_token))
+                break;
+        }
+        if (m_token.is(GasToken::l_paren))
+            ++paren_depth;
+        else if (m_token.is(GasToken::r_paren) && paren_depth > 0)
+            --paren_depth;
+        arg->push_back(m_token);
+        ConsumeAnyToken();
+    }
+}
+
+bool
+GasParser::CollectBody(GasMacro::Tokens* body,
+                       bool is_macro,
+                       SourceLocation source)
+{
+    int depth = 1;
+    for (;;)
+    {
+        if (m_token.is(GasToken::eof))
+            return false;
+        if (m_token.isAtStartOfLine() && m_token.is(GasToken::label))
+        {
+            IdentifierInfo* ii = m_token.getIdentifierInfo();
+            if (is_macro)
+            {
+                if (ii->isStr(".endm") && --depth == 0)
+                    return true;
+                if (ii->isStr(".macro"))
+                    ++depth;
+            }
+            else
+            {
+                if (ii->isStr(".endr") && --depth == 0)
+                    return true;
+                // handle nesting
+                if (ii->isStr(".rept") || ii->isStr(".irp") ||
+                    ii->isStr(".irpc"))
+                    ++depth;
+            }
+        }
+        body->push_back(m_token);
+        ConsumeAnyToken();
+    }
+}
+
+bool
+GasParser::ParseDirMacro(unsigned int param, SourceLocation source)
+{
+    IdentifierInfo* ii = m_token.getIdentifierInfo();
+    if (!ii)
+    {
+        Diag(m_token, diag::err_expected_ident);
+        return false;
+    }
+
+    llvm::SmallString<32> namebuf;
+    llvm::StringRef name = getMacroKey(namebuf, ii->getName());
+    SourceLocation name_source = ConsumeToken();
+    if (m_token.is(GasToken::comma))
+        ConsumeToken();
+
+    GasMacro macro;
+    macro.source = source;
+
+    // Parameters: name[:req|:vararg][=default], separated by commas or
+    // whitespace.
+    bool ok = true;
+    while (!m_token.isEndOfStatement())
+    {
+        GasMacro::Param param;
+        param.name = m_token.getIdentifierInfo();
+        param.required = false;
+        param.vararg = false;
+        if (!param.name)
+        {
+            Diag(m_token, diag::err_expected_ident);
+            ok = false;
+            break;
+        }
+        ConsumeToken();
+
+        if (m_token.is(GasToken::colon))
+        {
+            ConsumeToken();
+            IdentifierInfo* qual = m_token.getIdentifierInfo();
+            if (qual && qual->isStr("req"))
+                param.required = true;
+            else if (qual && qual->isStr("vararg"))
+                param.vararg = true;
+            else
+            {
+                Diag(m_token, diag::err_expected_ident);
+                ok = false;
+                break;
+            }
+            ConsumeToken();
+        }
+
+        if (m_token.is(GasToken::equal))
+        {
+            ConsumeToken();
+            ParseMacroArg(&param.def, false);
+        }
+
+        macro.params.push_back(param);
+        if (m_token.is(GasToken::comma))
+            ConsumeToken();
+    }
+    while (!m_token.isEndOfStatement())
+        ConsumeAnyToken();
+
+    // Lex and save tokens until we get an .endm.  The body is saved even
+    // if there was an error above so it isn't parsed as regular code.
+    if (!CollectBody(&macro.body, true, source))
+    {
+        Diag(source, diag::err_macro_without_endm);
+        return false;
+    }
+    ConsumeToken(); // consume the .endm
+
+    if (!ok)
+        return false;
+
+    if (m_macros.count(name) != 0)
+    {
+        Diag(name_source, diag::err_macro_redefined) << name;
+        return false;
+    }
+
+    for (GasMacro::Tokens::const_iterator i=macro.body.begin(),
+         end=macro.body.end(); i != end; ++i)
+    {
+        if (isMacroEscape(*i))
+        {
+            macro.has_escapes = true;
+            break;
+        }
+    }
+
+    m_macros[name] = macro;
+    return true;
+}
+
+bool
+GasParser::ParseDirEndm(unsigned int param, SourceLocation source)
+{
+    // Shouldn't ever get here unless we didn't get a .macro first
+    Diag(source, diag::err_endm_without_macro);
+    return false;
+}
+
+bool
+GasParser::ExpandMacro(GasMacro& macro,
+                       llvm::StringRef name,
+                       SourceLocation source)
+{
+    unsigned int num_params = macro.params.size();
+    std::vector<GasMacro::Tokens> values(num_params);
+    std::vector<bool> given(num_params, false);
+    unsigned int pos = 0;
+
+    while (!m_token.isEndOfStatement())
+    {
+        // Keyword argument (name=value)?
+        unsigned int i = num_params;
+        IdentifierInfo* ii = m_token.getIdentifierInfo();
+        if (ii && NextToken().is(GasToken::equal))
+        {
+            for (i=0; i<num_params; ++i)
+            {
+                if (macro.params[i].name == ii)
+                    break;
+            }
+            if (i != num_params)
+            {
+                ConsumeToken();
+                ConsumeToken(); // also eat the =
+            }
+        }
+
+        // Otherwise it's the next positional argument.
+        if (i == num_params)
+        {
+            while (pos < num_params && given[pos])
+                ++pos;
+            if (pos == num_params)
+            {
+                Diag(m_token, diag::err_macro_too_many_args) << name;
+                return false;
+            }
+            i = pos++;
+        }
+
+        ParseMacroArg(&values[i], macro.params[i].vararg);
+        given[i] = true;
+        if (m_token.is(GasToken::comma))
+            ConsumeToken();
+    }
+
+    // Fill in defaults for missing arguments.
+    for (unsigned int i=0; i<num_params; ++i)
+    {
+        if (!values[i].empty())
+            continue;
+        if (macro.params[i].required)
+        {
+            Diag(source, diag::err_macro_missing_arg)
+                << macro.params[i].name->getName() << name;
+            return false;
+        }
+        values[i] = macro.params[i].def;
+    }
+
+    // Catch infinite recursion before it exhausts the stack.
+    if (m_preproc.isIncludeStackFull())
+    {
+        Diag(source, diag::err_macro_too_deep) << name;
+        return false;
+    }
+
+    ++macro.expansions;
+    ++num_macro_expansions;
+
+    // If there's nothing to substitute, lex directly from the stored body.
+    if (!macro.has_escapes)
+    {
+        ++m_macro_count;
+        m_preproc.EnterTokenStream(macro.body.empty() ? 0 : &macro.body[0],
+                                   macro.body.size(), false, false);
+        return true;
+    }
+
+    llvm::SmallVector<IdentifierInfo*, 8> names;
+    for (unsigned int i=0; i<num_params; ++i)
+        names.push_back(macro.params[i].name);
+
+    GasMacro::Tokens expanded;
+    expanded.reserve(macro.body.size());
+    SubstituteTokens(&expanded, macro.body, names.empty() ? 0 : &names[0],
+                     values.empty() ? 0 : &values[0], num_params,
+                     m_macro_count);
+    ++m_macro_count;
+
+    Token* alloc_tokens = new Token[expanded.size()];
+    std::copy(expanded.begin(), expanded.end(), alloc_tokens);
+    m_preproc.EnterTokenStream(alloc_tokens, expanded.size(), false, true);
+    return true;
+}
+
 bool
 GasParser::ParseDirRept(unsigned int param, SourceLocation source)
 {
@@ -507,42 +978,148 @@ GasParser::ParseDirRept(unsigned int param, SourceLocation source)
     unsigned long count = intn.getUInt();
 
     // Lex and save tokens until we get an .endr
-    llvm::SmallVector<Token, 8> tokens;
-    int depth = 1;
-    for (;;)
+    GasMacro::Tokens tokens;
+    if (!CollectBody(&tokens, false, source))
+    {
+        Diag(source, diag::err_rept_without_endr);
+        return false;
+    }
+
+    // Only keep one copy of the body; the token lexer replays it count times.
+    // Nested .rept blocks are part of the body and are expanded in turn as
+    // each repetition is parsed.
+    Token* alloc_tokens = new Token[tokens.size()];
+    std::copy(tokens.begin(), tokens.end(), alloc_tokens);
+    m_preproc.EnterTokenStream(alloc_tokens, tokens.size(), false, true,
+                               count);
+    ConsumeToken(); // consume the .endr and get the first repeated token
+    return true;
+}
+
+namespace yasm { namespace parser {
+/// The passes of an .irp or .irpc: the body with each value substituted
+/// in turn.  Only the current pass is kept expanded.
+class GasIrpPasses : public TokenPassSource
+{
+public:
+    GasIrpPasses(GasParser& parser,
+                 IdentifierInfo* name,
+                 GasMacro::Tokens& body,
+                 std::vector<GasMacro::Tokens>& values,
+                 unsigned long count)
+        : m_parser(parser), m_name(name), m_count(count)
+    {
+        m_body.swap(body);
+        m_values.swap(values);
+    }
+
+    void getPass(unsigned long pass, const Token** toks, unsigned* num_toks)
+    {
+        m_expanded.clear();
+        m_parser.SubstituteTokens(&m_expanded, m_body, &m_name,
+                                  &m_values[pass], 1, m_count);
+        *toks = m_expanded.empty() ? 0 : &m_expanded[0];
+        *num_toks = m_expanded.size();
+    }
+
+private:
+    GasParser& m_parser;
+    IdentifierInfo* m_name;
+    GasMacro::Tokens m_body;
+    std::vector<GasMacro::Tokens> m_values;
+    unsigned long m_count;              // value of \@
+    GasMacro::Tokens m_expanded;        // current pass
+};
+}} // namespace yasm::parser
+
+bool
+GasParser::ParseDirIrp(unsigned int is_irpc, SourceLocation source)
+{
+    IdentifierInfo* name = m_token.getIdentifierInfo();
+    std::vector<GasMacro::Tokens> values;
+    bool ok = true;
+    if (!name)
+    {
+        Diag(m_token, diag::err_expected_ident);
+        ok = false;
+    }
+    else
     {
-        if (m_token.isAtStartOfLine() && m_token.is(GasToken::label) &&
-            m_token.getIdentifierInfo()->isStr(".endr"))
+        ConsumeToken();
+        if (m_token.is(GasToken::comma))
+            ConsumeToken();
+        while (!m_token.isEndOfStatement())
         {
-            if (depth == 1)
-                break;
-            --depth;
+            values.push_back(GasMacro::Tokens());
+            ParseMacroArg(&values.back(), false);
+            if (m_token.is(GasToken::comma))
+                ConsumeToken();
         }
-        // handle nesting
-        if (m_token.isAtStartOfLine() && m_token.is(GasToken::label) &&
-            m_token.getIdentifierInfo()->isStr(".rept"))
-            ++depth;
-        if (m_token.is(GasToken::eof))
+    }
+    while (!m_token.isEndOfStatement())
+        ConsumeAnyToken();
+
+    // Lex and save tokens until we get an .endr
+    GasMacro::Tokens body;
+    if (!CollectBody(&body, false, source))
+    {
+        Diag(source, diag::err_irp_without_endr)
+            << (is_irpc ? ".irpc" : ".irp");
+        return false;
+    }
+    if (!ok)
+        return false;
+
+    if (is_irpc)
+    {
+        // Each character of the value is a separate iteration.
+        std::vector<GasMacro::Tokens> chars;
+        llvm::SmallString<64> buf;
+        for (std::vector<GasMacro::Tokens>::const_iterator
+             i=values.begin(), end=values.end(); i != end; ++i)
         {
-            Diag(source, diag::err_rept_without_endr);
-            // TODO: Push remaining tokens back on so we can continue working
-#if 0
-            Token* alloc_tokens = new Token[tokens.size()];
-            std::copy(tokens.begin(), tokens.end(), alloc_tokens);
-            m_preproc.EnterTokenStream(alloc_tokens, tokens.size(), false,
-                                       true);
-            ConsumeToken(); // get the first token of stream
-#endif
-            return false;
+            for (GasMacro::Tokens::const_iterator j=i->begin(),
+                 jend=i->end(); j != jend; ++j)
+            {
+                llvm::StringRef text;
+                if (isPasteable(*j))
+                    text = getPasteText(*j);
+                else
+                    text = m_preproc.getSpelling(*j, buf);
+                for (unsigned int k=0; k<text.size(); ++k)
+                {
+                    chars.push_back(GasMacro::Tokens(1, *j));
+                    Token& ch = chars.back().back();
+                    ch.setLocation(j->getLocation().getFileLocWithOffset(k));
+                    ch.clearFlag(Token::LeadingSpace);
+                    char c = text[k];
+                    if (isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+                        c == '.' || c == '$')
+                        MakeMacroToken(&ch, text.substr(k, 1));
+                    else
+                    {
+                        ch.clearFlag(Token::Literal);
+                        ch.setIdentifierInfo(0);
+                        ch.setKind(GasToken::unknown);
+                        ch.setLength(1);
+                    }
+                }
+            }
         }
-        tokens.push_back(m_token);
-        ConsumeToken();
+        values.swap(chars);
     }
-    Token* alloc_tokens = new Token[count*tokens.size()];
-    for (unsigned long i=0; i<count; ++i)
-        std::copy(tokens.begin(), tokens.end(), &alloc_tokens[i*tokens.size()]);
-    m_preproc.EnterTokenStream(alloc_tokens, count*tokens.size(), false, true);
-    ConsumeToken(); // consume the .endr and get the first repeated token
+
+    // With no values, the body is expanded once with an empty value.
+    if (values.empty())
+        values.push_back(GasMacro::Tokens());
+
+    // Only keep one copy of the body, and substitute each value into it
+    // as its pass is reached, like .rept replays its body.
+    unsigned long passes = values.size();
+    std::auto_ptr<TokenPassSource> irp(
+        new GasIrpPasses(*this, name, body, values, m_macro_count));
+    m_preproc.EnterTokenStream(irp, passes, false);
+    ConsumeToken(); // consume the .endr and get the first expanded token
     return true;
 }
 
@@ -834,15 +1411,16 @@ GasParser::ParseDirData(unsigned int size, SourceLocation source)
         return true;
 
     SourceLocation lastcomma = m_token.getLocation().getFileLocWithOffset(-1);
+    Expr e;     // reused for every item in the list
     for (;;)
     {
         SourceLocation cur_source = m_token.getLocation();
-        std::auto_ptr<Expr> e(new Expr);
-        if (!ParseExpr(*e))
+        e.Clear();
+        if (!ParseExpr(e))
         {
             Diag(lastcomma.getFileLocWithOffset(1),
                  diag::warn_zero_assumed_for_missing_expression);
-            *e = 0;
+            e = 0;
         }
         AppendData(*m_container, e, size, *m_arch, cur_source,
                    m_preproc.getDiagnostics());
@@ -2314,7 +2892,7 @@ GasParser::ParseExpr(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr0(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -2344,7 +2922,7 @@ GasParser::ParseExpr0(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr1(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -2370,7 +2948,7 @@ GasParser::ParseExpr1(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr2(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -2397,7 +2975,7 @@ GasParser::ParseExpr2(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr3(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -2423,7 +3001,7 @@ GasParser::ParseExpr3(Expr& e, const ParseExprTerm* parse_term)
             SourceLocation op_source = ConsumeToken();
             if (!ParseExpr3(e, parse_term))
                 return false;
-            e.Calc(Op::NEG, op_source);
+            e.CalcFold(Op::NEG, op_source);
             break;
         }
         case GasToken::tilde:
@@ -2431,7 +3009,7 @@ GasParser::ParseExpr3(Expr& e, const ParseExprTerm* parse_term)
             SourceLocation op_source = ConsumeToken();
             if (!ParseExpr3(e, parse_term))
                 return false;
-            e.Calc(Op::NOT, op_source);
+            e.CalcFold(Op::NOT, op_source);
             break;
         }
         case GasToken::l_square:
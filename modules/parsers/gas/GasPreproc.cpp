@@ -74,7 +74,7 @@ GasPreproc::HandleInclude(llvm::StringRef filename, SourceLocation source)
     }
 
     // Check that we don't have infinite #include recursion.
-    if (m_include_macro_stack.size() == MaxAllowedIncludeStackDepth-1)
+    if (isIncludeStackFull())
     {
         Diag(source, diag::err_pp_include_too_deep);
         return false;
@@ -36,6 +36,7 @@
 
 #include "llvm/ADT/Statistic.h"
 #include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Parse/CharScan.h"
 #include "yasmx/Parse/Preprocessor.h"
 
 
@@ -94,10 +95,16 @@ NasmLexer::LexIdentifier(Token* result, const char* cur_ptr, bool is_label)
 {
     // Match [_$#@~.?A-Za-z0-9]*, we have already matched [_?@A-Za-z]
     unsigned int size;
-    unsigned char ch = *cur_ptr++;
-    while (isIdentifierBody(ch))
-        ch = *cur_ptr++;
-    --cur_ptr;  // Back up over the skipped character.
+    // The block scanner handles [A-Za-z0-9_]; check the others one at a time.
+    unsigned char ch;
+    for (;;)
+    {
+        cur_ptr = ScanIdentifier(cur_ptr);
+        ch = *cur_ptr;
+        if (!isIdentifierBody(ch))
+            break;
+        ++cur_ptr;
+    }
 
     // Fast path, no \ in identifier found.  '\' might be an escaped newline.
     if (ch != '\\')
@@ -187,6 +194,7 @@ NasmLexer::LexStringLiteral(Token* result, const char* cur_ptr, char endch)
 {
     const char* nulch = 0; // Does this string contain the \0 character?
   
+    cur_ptr = ScanStringLiteral(cur_ptr, endch);
     char ch = getAndAdvanceChar(cur_ptr, result);
     while (ch != endch)
     {
@@ -203,6 +211,13 @@ NasmLexer::LexStringLiteral(Token* result, const char* cur_ptr, char endch)
             nulch = cur_ptr-1;
         }
         char prevch = ch;
+        // Skipped characters never include a backslash.
+        const char* plain_end = ScanStringLiteral(cur_ptr, endch);
+        if (plain_end != cur_ptr)
+        {
+            prevch = plain_end[-1];
+            cur_ptr = plain_end;
+        }
         ch = getAndAdvanceChar(cur_ptr, result);
         // skip over escaped endch in escaped strings
         if (endch == '`' && ch == '`' && prevch == '\\')
@@ -242,9 +257,7 @@ LexNextToken:
     // Small amounts of horizontal whitespace is very common between tokens.
     if ((*cur_ptr == ' ') || (*cur_ptr == '\t'))
     {
-        ++cur_ptr;
-        while ((*cur_ptr == ' ') || (*cur_ptr == '\t'))
-            ++cur_ptr;
+        cur_ptr = ScanHorzSpace(cur_ptr+1);
     
 #if 0
         // If we are keeping whitespace and other tokens, just return what we
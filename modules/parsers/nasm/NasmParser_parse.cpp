@@ -756,6 +756,7 @@ NasmParser::ParseExp()
             ConsumeToken();
 
             unsigned int nvals = 0;
+            Expr e;     // reused for every item in the list
             for (;;)
             {
                 if (m_token.is(NasmToken::string_literal))
@@ -774,14 +775,15 @@ NasmParser::ParseExp()
                             AppendData(*m_container, str.getString(strbuf),
                                        pseudo->size, false);
                         }
+                        ++nvals;
                         ConsumeToken();
                         goto dv_done;
                     }
                 }
                 {
-                    Expr::Ptr e(new Expr);
                     NasmParseDataExprTerm parse_data_term;
-                    if (ParseExpr(*e, &parse_data_term))
+                    e.Clear();
+                    if (ParseExpr(e, &parse_data_term))
                     {
                         ++nvals;
                         // Check to see if we're in a TIMES with a single data
@@ -793,8 +795,11 @@ NasmParser::ParseExp()
                         {
                             Expr::Ptr multcopy(new Expr);
                             multcopy->swap(m_times);
+                            Expr::Ptr value(new Expr);
+                            value->swap(e);
                             AppendFill(*m_times_outer_container, multcopy,
-                                       pseudo->size, e, *m_arch, exp_source,
+                                       pseudo->size, value, *m_arch,
+                                       exp_source,
                                        m_preproc.getDiagnostics());
                             break;
                         }
@@ -1267,7 +1272,7 @@ NasmParser::ParseMemoryAddress()
             Expr f;                                   \
             if (!rightfunc(f, parse_term))            \
                 return false;                         \
-            e.Calc(op, f, op_source);                 \
+            e.CalcFold(op, f, op_source);             \
         }                                             \
         return true;                                  \
     } while(0)
@@ -1341,7 +1346,7 @@ NasmParser::ParseExpr3(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr4(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -1365,7 +1370,7 @@ NasmParser::ParseExpr4(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr5(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -1392,7 +1397,7 @@ NasmParser::ParseExpr5(Expr& e, const ParseExprTerm* parse_term)
         Expr f;
         if (!ParseExpr6(f, parse_term))
             return false;
-        e.Calc(op, f, op_source);
+        e.CalcFold(op, f, op_source);
     }
 }
 
@@ -1415,7 +1420,7 @@ NasmParseDirExprTerm::operator() (Expr& e,
             SourceLocation op_source = parser.ConsumeToken();
             if (!nasm_parser->ParseExpr6(e, this))
                 return false;
-            e.Calc(Op::NOT, op_source);
+            e.CalcFold(Op::NOT, op_source);
             *handled = true;
             return true;
         }
@@ -1540,7 +1545,7 @@ NasmParser::ParseExpr6(Expr& e, const ParseExprTerm* parse_term)
             SourceLocation op_source = ConsumeToken();
             if (!ParseExpr6(e, parse_term))
                 return false;
-            e.Calc(Op::NEG, op_source);
+            e.CalcFold(Op::NEG, op_source);
             return true;
         }
         case NasmToken::tilde:
@@ -1548,7 +1553,7 @@ NasmParser::ParseExpr6(Expr& e, const ParseExprTerm* parse_term)
             SourceLocation op_source = ConsumeToken();
             if (!ParseExpr6(e, parse_term))
                 return false;
-            e.Calc(Op::NOT, op_source);
+            e.CalcFold(Op::NOT, op_source);
             return true;
         }
         case NasmToken::kw_seg:
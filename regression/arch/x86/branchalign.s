@@ -0,0 +1,18 @@
+# [yasm -f bin -p gas --branches-within-32B-boundaries]
+# branches are padded so they don't cross or end on a 32-byte boundary
+.code64
+.fill 29, 1, 0x90       # out: 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90
+jmp 1f                  # out: 0f 1f 00 eb 3c
+.fill 28, 1, 0x90       # out: 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90
+# fused cmp+jcc pair is kept together
+cmp %eax, %ebx          # out: 66 90 39 c3
+jne 1f                  # out: 75 1a
+.fill 25, 1, 0x90       # out: 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90
+ret                     # out: c3
+1: call *%rax           # out: 66 90 ff d0
+.fill 2, 1, 0x90        # out: 90 90
+jmp 1b                  # out: eb f8
+# cmp with memory and immediate doesn't fuse
+cmpl $1, (%rax)         # out: 83 38 01
+.fill 20, 1, 0x90       # out: 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90
+jz 1b                   # out: 0f 1f 00 74 dc
@@ -0,0 +1,19 @@
+; [yasm -f bin --tune=atom]
+; padding that fits in a 16-byte fetch block is a single prefixed NOP
+bits 64
+nop         ; out: 90
+align 32
+; out: 66 66 66 66 66 66 2e 0f 1f 84 00 00 00 00 00
+; out: 66 66 66 66 66 66 2e 0f 1f 84 00 00 00 00 00
+; out: 90
+ret         ; out: c3
+align 16
+; out: 66 66 66 66 66 66 2e 0f 1f 84 00 00 00 00 00
+ret         ; out: c3
+xor eax, eax ; out: 31 c0
+align 16
+; out: 66 66 66 66 2e 0f 1f 84 00 00 00 00 00
+cpu atomnop
+ret         ; out: c3
+align 16
+; out: 66 66 66 66 66 66 2e 0f 1f 84 00 00 00 00 00
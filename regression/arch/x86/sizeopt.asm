@@ -0,0 +1,27 @@
+; [yasm -f bin -Os]
+; shortest equivalent encodings are selected
+bits 64
+mov rax, 1              ; out: b8 01 00 00 00
+mov rax, 0x80000000     ; out: b8 00 00 00 80
+mov r9, 0xfffffff0      ; out: 41 b9 f0 ff ff ff
+mov rax, -5             ; out: 48 c7 c0 fb ff ff ff
+mov rcx, 0x100000000    ; out: 48 b9 00 00 00 00 01 00 00 00
+mov rax, strict qword 1 ; out: 48 b8 01 00 00 00 00 00 00 00
+test rax, 1             ; out: a8 01
+test rbx, 0x10          ; out: f6 c3 10
+test rsi, 0x10          ; out: 40 f6 c6 10
+test r10, 0x10          ; out: 41 f6 c2 10
+test ax, 0x10           ; out: a8 10
+test rbx, 0x80          ; out: f7 c3 80 00 00 00
+test qword [rbx], 1     ; out: 48 f7 03 01 00 00 00
+and rbx, 0x7fff         ; out: 81 e3 ff 7f 00 00
+and rax, 0xff           ; out: 25 ff 00 00 00
+and qword [rbx], 1      ; out: 48 83 23 01
+or rax, 1               ; out: 48 83 c8 01
+xor rcx, rcx            ; out: 31 c9
+xor r8, r8              ; out: 45 31 c0
+sub rdx, rdx            ; out: 29 d2
+xor rcx, rdx            ; out: 48 31 d1
+bits 32
+test esi, 1             ; out: f7 c6 01 00 00 00
+test ebx, 1             ; out: f6 c3 01
@@ -0,0 +1,24 @@
+; [yasm -f elf32 -j8] [fail]
+; Sections are rendered on worker threads (the object is larger than the
+; parallel threshold); output diagnostics must still be reported in order.
+extern ext
+section .s0
+times 3000 dd ext+0
+section .s1
+times 3000 dd ext+1
+dq ext+1
+section .s2
+times 3000 dd ext+2
+section .s3
+times 3000 dd ext+3
+dq ext+3
+section .s4
+times 3000 dd ext+4
+section .s5
+times 3000 dd ext+5
+dq ext+5
+section .s6
+times 3000 dd ext+6
+section .s7
+times 3000 dd ext+7
+dq ext+7
@@ -0,0 +1,13 @@
+# [yasm -f elf64 -p gas -g dwarf64pass]
+# 64-bit DWARF .debug_frame; .eh_frame stays 32-bit.
+.text
+f:
+.cfi_startproc
+pushq %rbp
+.cfi_def_cfa_offset 16
+.cfi_offset 6, -16
+popq %rbp
+.cfi_def_cfa_offset 8
+ret
+.cfi_endproc
+.cfi_sections .eh_frame, .debug_frame
@@ -0,0 +1,26 @@
+# [oformat elf64]
+# FDEs share a CIE only if their personality routines match.
+.text
+f:
+.cfi_startproc
+.cfi_personality 0x9b, p1
+ret
+.cfi_endproc
+g:
+.cfi_startproc
+.cfi_personality 0x9b, p2
+ret
+.cfi_endproc
+h:
+.cfi_startproc
+.cfi_personality 0x9b, p1
+.cfi_def_cfa_offset 16
+ret
+.cfi_endproc
+i:
+.cfi_startproc
+.cfi_personality 0x9b, p2
+nop
+.cfi_def_cfa_offset 16
+ret
+.cfi_endproc
@@ -0,0 +1,25 @@
+# [ygas -64]
+# .file numbering: a gap below a later .file stays empty until it is
+# given, a repeated .file N replaces the earlier entry, and the same
+# name in different directories keeps separate entries.
+.file 3 "a.c"
+.file 1 "b.c"
+.file 1 "c.c"
+.file 4 "x/a.c"
+.file 5 "y/a.c"
+.file 6 "a.c"
+.file 3 "d.c"
+.file 2 "x/a.c"
+.text
+.loc 1 1
+nop
+.loc 2 2
+nop
+.loc 3 3
+nop
+.loc 4 4
+nop
+.loc 5 5
+nop
+.loc 6 6
+nop
@@ -0,0 +1,16 @@
+; [oformat elf64]
+; Section sizes, symbol values and distances past 4 GiB.
+[section .bss nobits]
+start:
+resb 0xC0000000
+resb 0x80000000
+mid:
+resb 16
+end:
+
+[section .data]
+incbin "largesect.inc", 0, 8
+incbin "largesect.inc", 8
+dq mid
+dq end - start
+dq mid - start
@@ -0,0 +1,9 @@
+# [ygas -64 --compress-debug-sections --nocompress-debug-sections]
+# The later option wins, so .debug_str is written uncompressed even though
+# it would compress well.
+.section .debug_str
+.rept 64
+.ascii "0123456789abcdef"
+.endr
+.text
+.byte 0
@@ -0,0 +1,21 @@
+; [yasm -f win64 --bigobj]
+; Big object header, 32-bit section numbers and 20-byte symbols.
+extern ext
+global func
+
+section .text
+func:
+	call ext
+	lea rax, [rel data]
+	ret
+
+section .data
+data:
+	dq func
+	dd ext
+
+section .rdata$a_long_section_name
+	db "bigobj", 0
+
+section .bss
+	resb 16
@@ -0,0 +1,16 @@
+# alignment and org ahead of any jump have a statically known size
+.byte 1				# out: 01
+.p2align 2			# out: 8d 74 00
+.byte 2				# out: 02
+.org 0x10			# out: 00 00 00 00 00 00 00 00 00 00 00
+.byte 3				# out: 03
+.balign 8, 0xcc			# out: cc cc cc cc cc cc cc
+.p2align 3			# aligned already; no padding
+movl $1, %eax			# out: 66 b8 01 00 00 00
+.p2align 4			# out: 89 f6
+ret				# out: c3
+.org 0x24, 0xee			# out: ee ee ee
+jmp 1f				# out: eb 02
+.p2align 2			# out: 89 f6
+1: ret				# out: c3
+.org 0x2a, 0xee			# out: ee
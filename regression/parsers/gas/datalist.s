@@ -0,0 +1,6 @@
+lbl:
+.byte 1, -1, 255, lbl+4, 2		# out: 01 ff ff 04 02
+.short -2, 0x1234, lbl+1, 3		# out: fe ff 34 12 01 00 03 00
+.long -1, 0x12345678, lbl		# out: ff ff ff ff 78 56 34 12 00 00 00 00
+.quad -2, 1 << 40			# out: fe ff ff ff ff ff ff ff 00 00 00 00 00 01 00 00
+.octa 1					# out: 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00
@@ -0,0 +1,26 @@
+.irp r, 1, 2, 3
+.byte \r
+.endr			# out: 01 02 03
+.irp r
+.byte 4
+.endr			# out: 04
+.irpc c, 567
+.byte \c
+.endr			# out: 05 06 07
+.irp r, 1, 2
+.irpc c, 34
+.byte \r\c
+.endr
+.endr			# out: 0d 0e 17 18
+.macro seven
+.byte 7
+.endm
+.irp r, 8, 9
+seven
+.byte \r
+.endr			# out: 07 08 07 09
+.rept 2
+.irp r, 1, 2
+.byte \r
+.endr
+.endr			# out: 01 02 01 02
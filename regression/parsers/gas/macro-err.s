@@ -0,0 +1,14 @@
+# [fail]
+.macro m1 x:req
+.byte \x
+.endm
+m1
+.macro m2 a
+.byte \a
+.endm
+m2 1, 2
+.endm
+.macro m1
+.endm
+.macro open
+.byte 1
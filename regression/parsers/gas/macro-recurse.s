@@ -0,0 +1,15 @@
+# [fail]
+.macro forever n
+.byte \n
+forever \n
+.endm
+forever 1
+.macro ping
+pong
+.endm
+.macro pong
+.byte 2
+ping
+.endm
+ping
+.byte 3
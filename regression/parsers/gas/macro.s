@@ -0,0 +1,32 @@
+.macro emit a, b=7
+.byte \a, \b
+.endm
+.macro lbl name
+\name\()_x: .byte 0x10
+.long \name\()_x
+.endm
+.macro req x:req, rest:vararg
+.byte \x, \rest
+.endm
+.macro cnt
+.byte \@
+.endm
+.macro noargs
+nop
+.endm
+emit 1, 2		# out: 01 02
+emit 3			# out: 03 07
+emit b=5, a=4		# out: 04 05
+EMIT 1 2		# out: 01 02
+emit 1 + 2 3		# out: 03 03
+lbl foo			# out: 10 0a 00 00 00
+req 1, 2, 3		# out: 01 02 03
+cnt			# out: 07
+cnt			# out: 08
+noargs			# out: 90
+.macro outer v
+.rept 2
+.byte \v
+.endr
+.endm
+outer 9			# out: 09 09
@@ -0,0 +1,7 @@
+.byte 12, 0xc, 014, 0b1100		# out: 0c 0c 0c 0c
+.quad 18446744073709551615		# out: ff ff ff ff ff ff ff ff
+.quad 0xffffffffffffffff		# out: ff ff ff ff ff ff ff ff
+.quad 01777777777777777777777		# out: ff ff ff ff ff ff ff ff
+.quad 9223372036854775808		# out: 00 00 00 00 00 00 00 80
+.quad 18446744073709551616 >> 1		# out: 00 00 00 00 00 00 00 80
+.quad 0x10000000000000001 >> 4		# out: 00 00 00 00 00 00 00 10
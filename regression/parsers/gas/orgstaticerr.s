@@ -0,0 +1,5 @@
+# [fail]
+# an org ahead of any jump that moves backwards is reported only once
+.byte 1, 2, 3, 4, 5, 6
+.org 4
+.byte 7
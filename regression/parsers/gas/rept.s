@@ -0,0 +1,15 @@
+.rept 3
+.byte 1
+.endr			# out: 01 01 01
+.rept 2
+.byte 2
+.rept 2
+.byte 3, 4
+.endr
+.endr			# out: 02 03 04 03 04 02 03 04 03 04
+.rept 0
+.byte 5
+.endr
+.rept 1
+.byte 6
+.endr			# out: 06
@@ -0,0 +1,7 @@
+lbl:
+db 1, -1, 255, lbl+4, 2		; out: 01 ff ff 04 02
+dw -2, 0x1234, lbl+1, 3		; out: fe ff 34 12 01 00 03 00
+dd -1, 0x12345678, lbl		; out: ff ff ff ff 78 56 34 12 00 00 00 00
+dq -2, 1 << 40			; out: fe ff ff ff ff ff ff ff 00 00 00 00 00 01 00 00
+dt 1				; out: 01 00 00 00 00 00 00 00 00 00
+times 3 db 7			; out: 07 07 07
@@ -0,0 +1,10 @@
+db 12, 0ch, 0x0c, $0c, 14q, 14o, 1100b, 0b1100	; out: 0c 0c 0c 0c 0c 0c 0c 0c
+db 1_2, 0x1_2, 1010_1010b		; out: 0c 12 aa
+dq 18446744073709551615			; out: ff ff ff ff ff ff ff ff
+dq 0xffff_ffff_ffff_ffff		; out: ff ff ff ff ff ff ff ff
+dq 1777777777777777777777q		; out: ff ff ff ff ff ff ff ff
+dq 0x8000000000000000			; out: 00 00 00 00 00 00 00 80
+dq 9223372036854775808			; out: 00 00 00 00 00 00 00 80
+dq 18446744073709551616 >> 1		; out: 00 00 00 00 00 00 00 80
+dq 0x1_0000_0000_0000_0001 >> 4		; out: 00 00 00 00 00 00 00 10
+dq 2000000000000000000000q >> 3		; out: 00 00 00 00 00 00 00 20
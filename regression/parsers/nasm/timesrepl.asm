@@ -0,0 +1,6 @@
+times 3 db 1, 2			; out: 01 02 01 02 01 02
+times 2 db "ab", 0		; out: 61 62 00 61 62 00
+times 2 dw 0x1234		; out: 34 12 34 12
+times 0 db 5
+times 4 db 0			; out: 00 00 00 00
+times 2 dd 0, 1			; out: 00 00 00 00 01 00 00 00 00 00 00 00 01 00 00 00
@@ -240,10 +240,12 @@ class Test(object):
         start = time.time()
         env = os.environ.copy()
         env["YASM_TEST_SUITE"] = "1"
+        # Run from the test's directory so relative incbin paths resolve.
         proc = subprocess.Popen(yasmargs, bufsize=4096,
                                 executable=(ygasoverride and ygasexe or yasmexe),
                                 stdin=subprocess.PIPE, stdout=subprocess.PIPE,
-                                stderr=subprocess.PIPE, env=env)
+                                stderr=subprocess.PIPE, env=env,
+                                cwd=os.path.dirname(self.fullpath))
         (stdoutdata, stderrdata) = proc.communicate(self.inputfile)
         end = time.time()
 
@@ -326,9 +328,9 @@ if __name__ == "__main__":
         lprint("    <path to yasm executable>", file=sys.stderr)
         lprint("    <path to ygas executable>", file=sys.stderr)
         sys.exit(2)
-    outdir = sys.argv[2]
-    yasmexe = sys.argv[3]
-    ygasexe = sys.argv[4]
+    outdir = os.path.abspath(sys.argv[2])
+    yasmexe = os.path.abspath(sys.argv[3])
+    ygasexe = os.path.abspath(sys.argv[4])
     all_ok = run_all(sys.argv[1])
     if all_ok:
         sys.exit(0)
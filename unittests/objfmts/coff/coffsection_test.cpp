@@ -0,0 +1,142 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "yasmx/Basic/SourceLocation.h"
+#include "yasmx/Bytes.h"
+#include "yasmx/IntNum.h"
+#include "yasmx/Reloc.h"
+#include "yasmx/Section.h"
+#include "yasmx/SymbolRef.h"
+
+#include "modules/objfmts/coff/CoffSection.h"
+
+using namespace yasm;
+using namespace yasm::objfmt;
+
+namespace {
+class TestReloc : public Reloc
+{
+public:
+    TestReloc(unsigned long addr) : Reloc(addr, SymbolRef()) {}
+    std::string getTypeName() const { return "test"; }
+};
+} // anonymous namespace
+
+static unsigned long
+ReadLE(const Bytes& bytes, Bytes::size_type off, int size)
+{
+    unsigned long val = 0;
+    for (int i=size-1; i>=0; --i)
+        val = (val << 8) | bytes[off+i];
+    return val;
+}
+
+class CoffSectionTest : public ::testing::Test
+{
+protected:
+    Section sect;
+    CoffSection coffsect;
+    Bytes bytes;
+
+    CoffSectionTest()
+        : sect(".text", true, false, SourceLocation())
+        , coffsect(SymbolRef())
+    {
+        coffsect.m_flags = CoffSection::TEXT;
+    }
+
+    void AddRelocs(unsigned long n)
+    {
+        for (unsigned long i=0; i<n; ++i)
+            sect.AddReloc(std::auto_ptr<Reloc>(new TestReloc(i*4)));
+    }
+};
+
+TEST_F(CoffSectionTest, RelocCount)
+{
+    AddRelocs(0xFFFE);
+    coffsect.Write(bytes, sect);
+    ASSERT_EQ(40U, bytes.size());
+    EXPECT_EQ(0xFFFEUL, ReadLE(bytes, 32, 2));              // s_nreloc
+
+    bytes.resize(0);
+    coffsect.WriteRelocOverflow(bytes, sect);
+    EXPECT_EQ(0U, bytes.size());
+}
+
+TEST_F(CoffSectionTest, RelocOverflow)
+{
+    AddRelocs(70000);
+    coffsect.m_flags |= CoffSection::NRELOC_OVFL;
+    coffsect.Write(bytes, sect);
+    ASSERT_EQ(40U, bytes.size());
+    EXPECT_EQ(0xFFFFUL, ReadLE(bytes, 32, 2));              // s_nreloc
+    EXPECT_NE(0UL, ReadLE(bytes, 36, 4) & CoffSection::NRELOC_OVFL);
+
+    // the first relocation holds the count, including itself
+    bytes.resize(0);
+    coffsect.WriteRelocOverflow(bytes, sect);
+    ASSERT_EQ(10U, bytes.size());
+    EXPECT_EQ(70001UL, ReadLE(bytes, 0, 4));                // r_vaddr
+    EXPECT_EQ(0UL, ReadLE(bytes, 4, 4));                    // r_symndx
+    EXPECT_EQ(0UL, ReadLE(bytes, 8, 2));                    // r_type
+}
+
+TEST_F(CoffSectionTest, RelocOverflowBoundary)
+{
+    AddRelocs(0xFFFF);
+    coffsect.m_flags |= CoffSection::NRELOC_OVFL;
+    coffsect.Write(bytes, sect);
+    EXPECT_EQ(0xFFFFUL, ReadLE(bytes, 32, 2));              // s_nreloc
+
+    bytes.resize(0);
+    coffsect.WriteRelocOverflow(bytes, sect);
+    ASSERT_EQ(10U, bytes.size());
+    EXPECT_EQ(0x10000UL, ReadLE(bytes, 0, 4));              // r_vaddr
+}
+
+TEST_F(CoffSectionTest, LongNameDecimal)
+{
+    Section longsect(".text$a_long_name", true, false, SourceLocation());
+    coffsect.m_strtab_name = 5;
+    coffsect.Write(bytes, longsect);
+    ASSERT_EQ(40U, bytes.size());
+    EXPECT_EQ(std::string("/5\0\0\0\0\0\0", 8),
+              std::string(reinterpret_cast<const char*>(&bytes[0]), 8));
+}
+
+TEST_F(CoffSectionTest, LongNameBase64)
+{
+    Section longsect(".text$a_long_name", true, false, SourceLocation());
+    coffsect.m_strtab_name = 10000000;
+    coffsect.Write(bytes, longsect);
+    ASSERT_EQ(40U, bytes.size());
+    EXPECT_EQ("//AAmJaA",
+              std::string(reinterpret_cast<const char*>(&bytes[0]), 8));
+}
@@ -0,0 +1,315 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "llvm/Config/config.h"
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/SourceLocation.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Support/registry.h"
+#include "yasmx/System/plugin.h"
+#include "yasmx/Arch.h"
+#include "yasmx/BytecodeContainer.h"
+#include "yasmx/DebugFormat.h"
+#include "yasmx/Expr.h"
+#include "yasmx/Object.h"
+#include "yasmx/ObjectFormat.h"
+#include "yasmx/Section.h"
+#include "yasmx/Symbol.h"
+
+#include "modules/objfmts/elf/ElfTypes.h"
+
+#include "unittests/diag_mock.h"
+
+using namespace yasm;
+using namespace yasm::objfmt;
+
+static unsigned long
+ReadLE(const std::string& data, std::string::size_type off, int size)
+{
+    unsigned long val = 0;
+    for (int i=size-1; i>=0; --i)
+        val = (val << 8) | static_cast<unsigned char>(data[off+i]);
+    return val;
+}
+
+/// Assembles a small object with a few sections directly through the
+/// object format and reads the section headers of the written file back.
+class ElfCompressTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        ASSERT_TRUE(LoadStandardPlugins());
+    }
+
+    ::testing::StrictMock<yasmunit::MockDiagnosticId> mock_client;
+    Diagnostic diags;
+    SourceManager smgr;
+    std::string info;       // uncompressed .debug_info contents
+    std::string file;       // written object file
+    bool elf64;
+
+    ElfCompressTest()
+        : diags(&mock_client)
+        , smgr(diags)
+        , elf64(true)
+    {
+        diags.setSourceManager(&smgr);
+
+        // Compresses well, and is large enough to be rendered in parallel.
+        // The compressed bytes depend on the zlib version, so they are
+        // only ever checked by inflating them again.
+        for (int i=0; i<8192; ++i)
+            info += "0123456789abcdef";
+    }
+
+    /// Assemble and write the object.
+    /// .debug_info gets #info followed by a 4-byte reference to an
+    /// external symbol (so it has a relocation), .debug_str gets a string
+    /// too short to compress, and .text gets a copy of #info.
+    void Assemble(const char* objfmt_keyword,
+                  const char* machine,
+                  bool compress,
+                  unsigned int threads = 1)
+    {
+        elf64 = llvm::StringRef(objfmt_keyword) == "elf64";
+
+        std::auto_ptr<ArchModule> arch_module = LoadModule<ArchModule>("x86");
+        ASSERT_TRUE(arch_module.get() != 0);
+        std::auto_ptr<Arch> arch = arch_module->Create();
+        ASSERT_TRUE(arch->setMachine(machine));
+
+        std::auto_ptr<ObjectFormatModule> objfmt_module =
+            LoadModule<ObjectFormatModule>(objfmt_keyword);
+        ASSERT_TRUE(objfmt_module.get() != 0);
+        std::auto_ptr<DebugFormatModule> dbgfmt_module =
+            LoadModule<DebugFormatModule>("null");
+        ASSERT_TRUE(dbgfmt_module.get() != 0);
+
+        Object object("elfcompress_test.asm", "elfcompress_test.o",
+                      arch.get());
+        std::auto_ptr<ObjectFormat> objfmt = objfmt_module->Create(object);
+        ASSERT_TRUE(objfmt.get() != 0);
+        objfmt->InitSymbols("nasm");
+        objfmt->AddDefaultSection();
+        std::auto_ptr<DebugFormat> dbgfmt = dbgfmt_module->Create(object);
+        ASSERT_TRUE(dbgfmt.get() != 0);
+
+        object.getConfig().CompressDebug = compress;
+        object.getConfig().OutputThreads = threads;
+
+        SymbolRef ext = object.getSymbol("ext");
+        ext->Declare(Symbol::EXTERN);
+
+        Section* sect = objfmt->AppendSection(".debug_info", SourceLocation(),
+                                              diags);
+        AppendData(*sect, info, false);
+        AppendData(*sect, std::auto_ptr<Expr>(new Expr(ext)), 4, *arch,
+                   SourceLocation(), diags);
+
+        sect = objfmt->AppendSection(".debug_str", SourceLocation(), diags);
+        AppendData(*sect, "abc", true);
+
+        sect = object.FindSection(".text");
+        ASSERT_TRUE(sect != 0);
+        AppendData(*sect, info, false);
+
+        object.Finalize(diags);
+        object.Optimize(diags);
+        dbgfmt->Generate(*objfmt, smgr, diags);
+
+        const char* filename = "elfcompress_test.o";
+        {
+            std::string err;
+            llvm::raw_fd_ostream os(filename, err,
+                                    llvm::raw_fd_ostream::F_Binary);
+            ASSERT_TRUE(err.empty()) << err;
+            objfmt->Output(os, false, *dbgfmt, diags);
+        }
+        std::auto_ptr<llvm::MemoryBuffer>
+            in(llvm::MemoryBuffer::getFile(filename));
+        ASSERT_TRUE(in.get() != 0);
+        file = in->getBuffer();
+        std::remove(filename);
+    }
+
+    /// Section header fields.
+    struct Shdr
+    {
+        unsigned long flags, offset, size, addralign;
+    };
+
+    /// Find a section header by name.
+    bool FindSection(llvm::StringRef name, Shdr* shdr)
+    {
+        unsigned long shoff, shnum, shstrndx, shentsize;
+        if (elf64)
+        {
+            shoff = ReadLE(file, 0x28, 8);
+            shnum = ReadLE(file, 0x3c, 2);
+            shstrndx = ReadLE(file, 0x3e, 2);
+            shentsize = 64;
+        }
+        else
+        {
+            shoff = ReadLE(file, 0x20, 4);
+            shnum = ReadLE(file, 0x30, 2);
+            shstrndx = ReadLE(file, 0x32, 2);
+            shentsize = 40;
+        }
+
+        int wsize = elf64 ? 8 : 4;
+        unsigned long strtab =
+            ReadLE(file, shoff+shstrndx*shentsize+(elf64 ? 24 : 16), wsize);
+        for (unsigned long i=1; i<shnum; ++i)
+        {
+            unsigned long sh = shoff+i*shentsize;
+            const char* shname = file.c_str() + strtab + ReadLE(file, sh, 4);
+            if (name != shname)
+                continue;
+            shdr->flags = ReadLE(file, sh+8, wsize);
+            shdr->offset = ReadLE(file, sh+8+wsize*2, wsize);
+            shdr->size = ReadLE(file, sh+8+wsize*3, wsize);
+            shdr->addralign = ReadLE(file, sh+16+wsize*4, wsize);
+            return true;
+        }
+        return false;
+    }
+
+    /// Check a compressed section's header and payload against the
+    /// original contents.
+    void CheckCompressed(const Shdr& shdr,
+                         const std::string& orig,
+                         unsigned long orig_align)
+    {
+        unsigned long chdr_size = elf64 ? 24 : 12;
+        EXPECT_TRUE((shdr.flags & SHF_COMPRESSED) != 0);
+        EXPECT_EQ(elf64 ? 8UL : 4UL, shdr.addralign);
+        ASSERT_GT(shdr.size, chdr_size);
+        EXPECT_LT(shdr.size, static_cast<unsigned long>(orig.size()));
+        EXPECT_EQ(0UL, shdr.offset % shdr.addralign);
+
+        EXPECT_EQ(static_cast<unsigned long>(ELFCOMPRESS_ZLIB),
+                  ReadLE(file, shdr.offset, 4));            // ch_type
+        if (elf64)
+        {
+            EXPECT_EQ(static_cast<unsigned long>(orig.size()),
+                      ReadLE(file, shdr.offset+8, 8));      // ch_size
+            EXPECT_EQ(orig_align,
+                      ReadLE(file, shdr.offset+16, 8));     // ch_addralign
+        }
+        else
+        {
+            EXPECT_EQ(static_cast<unsigned long>(orig.size()),
+                      ReadLE(file, shdr.offset+4, 4));      // ch_size
+            EXPECT_EQ(orig_align,
+                      ReadLE(file, shdr.offset+8, 4));      // ch_addralign
+        }
+
+        // the payload must be a complete zlib stream of the contents
+        std::string inflated(orig.size() + 1, '\0');
+        uLongf inflated_len = static_cast<uLongf>(inflated.size());
+        ASSERT_EQ(Z_OK, uncompress(
+            reinterpret_cast<Bytef*>(&inflated[0]), &inflated_len,
+            reinterpret_cast<const Bytef*>(file.data() + shdr.offset +
+                                           chdr_size),
+            static_cast<uLong>(shdr.size - chdr_size)));
+        inflated.resize(inflated_len);
+        EXPECT_EQ(orig, inflated);
+    }
+};
+
+TEST_F(ElfCompressTest, Elf64)
+{
+    Assemble("elf64", "amd64", true);
+    std::string orig = info + std::string(4, '\0');
+
+    Shdr shdr;
+    ASSERT_TRUE(FindSection(".debug_info", &shdr));
+    CheckCompressed(shdr, orig, 1);
+
+    // relocations still refer to the uncompressed contents
+    ASSERT_TRUE(FindSection(".rela.debug_info", &shdr));
+    EXPECT_EQ(24UL, shdr.size);
+
+    // not smaller when compressed; left as is
+    ASSERT_TRUE(FindSection(".debug_str", &shdr));
+    EXPECT_EQ(0UL, shdr.flags & SHF_COMPRESSED);
+    EXPECT_EQ(4UL, shdr.size);
+    EXPECT_EQ(std::string("abc", 4), file.substr(shdr.offset, 4));
+
+    // only debugging sections are compressed
+    ASSERT_TRUE(FindSection(".text", &shdr));
+    EXPECT_EQ(0UL, shdr.flags & SHF_COMPRESSED);
+    EXPECT_EQ(static_cast<unsigned long>(info.size()), shdr.size);
+    EXPECT_EQ(info, file.substr(shdr.offset, shdr.size));
+}
+
+TEST_F(ElfCompressTest, Elf32)
+{
+    Assemble("elf32", "x86", true);
+    std::string orig = info + std::string(4, '\0');
+
+    Shdr shdr;
+    ASSERT_TRUE(FindSection(".debug_info", &shdr));
+    CheckCompressed(shdr, orig, 1);
+
+    ASSERT_TRUE(FindSection(".rel.debug_info", &shdr));
+    EXPECT_EQ(8UL, shdr.size);
+}
+
+TEST_F(ElfCompressTest, Threaded)
+{
+    Assemble("elf64", "amd64", true);
+    std::string serial = file;
+    Assemble("elf64", "amd64", true, 4);
+    EXPECT_EQ(serial, file);
+}
+
+TEST_F(ElfCompressTest, NotRequested)
+{
+    Assemble("elf64", "amd64", false);
+
+    Shdr shdr;
+    ASSERT_TRUE(FindSection(".debug_info", &shdr));
+    EXPECT_EQ(0UL, shdr.flags & SHF_COMPRESSED);
+    EXPECT_EQ(static_cast<unsigned long>(info.size() + 4), shdr.size);
+    EXPECT_EQ(info, file.substr(shdr.offset, info.size()));
+}
+
+#endif // HAVE_ZLIB_H && HAVE_LIBZ
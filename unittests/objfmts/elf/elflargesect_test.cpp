@@ -0,0 +1,163 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/DataTypes.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/SourceLocation.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Support/registry.h"
+#include "yasmx/System/plugin.h"
+#include "yasmx/Arch.h"
+#include "yasmx/Bytecode.h"
+#include "yasmx/BytecodeContainer.h"
+#include "yasmx/Bytes.h"
+#include "yasmx/DebugFormat.h"
+#include "yasmx/Expr.h"
+#include "yasmx/IntNum.h"
+#include "yasmx/Object.h"
+#include "yasmx/ObjectFormat.h"
+#include "yasmx/Section.h"
+
+#include "modules/objfmts/elf/ElfSection.h"
+
+#include "unittests/diag_mock.h"
+#include "unittests/unittest_config.h"
+
+using namespace yasm;
+using namespace yasm::objfmt;
+
+static uint64_t
+ReadLE64(const std::string& data, std::string::size_type off)
+{
+    uint64_t val = 0;
+    for (int i=7; i>=0; --i)
+        val = (val << 8) | static_cast<unsigned char>(data[off+i]);
+    return val;
+}
+
+class ElfLargeSectTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        ASSERT_TRUE(LoadStandardPlugins());
+    }
+};
+
+// A PROGBITS section larger than 4 GiB, made of incbin data around a gap
+// (as from resb).  The object is written to the null device, and the
+// layout is checked through the ELF section data.
+TEST_F(ElfLargeSectTest, ProgbitsPast4G)
+{
+    ::testing::StrictMock<yasmunit::MockDiagnosticId> mock_client;
+    Diagnostic diags(&mock_client);
+    SourceManager smgr(diags);
+    diags.setSourceManager(&smgr);
+
+    std::auto_ptr<ArchModule> arch_module = LoadModule<ArchModule>("x86");
+    ASSERT_TRUE(arch_module.get() != 0);
+    std::auto_ptr<Arch> arch = arch_module->Create();
+    ASSERT_TRUE(arch->setMachine("amd64"));
+    std::auto_ptr<ObjectFormatModule> objfmt_module =
+        LoadModule<ObjectFormatModule>("elf64");
+    ASSERT_TRUE(objfmt_module.get() != 0);
+    std::auto_ptr<DebugFormatModule> dbgfmt_module =
+        LoadModule<DebugFormatModule>("null");
+    ASSERT_TRUE(dbgfmt_module.get() != 0);
+
+    Object object("largesect.asm", "largesect.o", arch.get());
+    std::auto_ptr<ObjectFormat> objfmt = objfmt_module->Create(object);
+    ASSERT_TRUE(objfmt.get() != 0);
+    objfmt->InitSymbols("nasm");
+    objfmt->AddDefaultSection();
+    std::auto_ptr<DebugFormat> dbgfmt = dbgfmt_module->Create(object);
+    ASSERT_TRUE(dbgfmt.get() != 0);
+    object.getConfig().OutputThreads = 1;
+
+    std::string incfile;
+    if (const char* srcdir = getenv("CMAKE_SOURCE_DIR"))
+        incfile = srcdir;
+    else
+        incfile = CMAKE_SOURCE_DIR;
+    incfile += "/regression/objfmts/elf64/largesect.inc";
+
+    const uint64_t four_gig = static_cast<uint64_t>(1) << 32;
+    Section* data = objfmt->AppendSection(".data", SourceLocation(), diags);
+    AppendIncbin(*data, incfile, std::auto_ptr<Expr>(0),
+                 std::auto_ptr<Expr>(0), SourceLocation());
+    data->AppendGap(four_gig, SourceLocation());
+    AppendIncbin(*data, incfile, std::auto_ptr<Expr>(new Expr(8)),
+                 std::auto_ptr<Expr>(0), SourceLocation());
+    Section* rodata = objfmt->AppendSection(".rodata", SourceLocation(),
+                                            diags);
+    AppendData(*rodata, "abc", true);
+
+    object.Finalize(diags);
+    object.Optimize(diags);
+    dbgfmt->Generate(*objfmt, smgr, diags);
+    ASSERT_EQ(16+four_gig+8, data->bytecodes_back().getNextOffset());
+
+    std::string err;
+    llvm::raw_fd_ostream os("/dev/null", err);
+    ASSERT_TRUE(err.empty()) << err;
+    objfmt->Output(os, false, *dbgfmt, diags);
+    os.flush();
+
+    ElfSection* data_elf = data->getAssocData<ElfSection>();
+    ASSERT_TRUE(data_elf != 0);
+    EXPECT_EQ(16+four_gig+8, data_elf->getSize().getUInt64());
+    uint64_t data_off = data_elf->getFileOffset();
+    EXPECT_LT(data_off, four_gig);
+
+    // the following section starts past 4 GiB
+    ElfSection* rodata_elf = rodata->getAssocData<ElfSection>();
+    ASSERT_TRUE(rodata_elf != 0);
+    uint64_t rodata_off = rodata_elf->getFileOffset();
+    EXPECT_LE(data_off+16+four_gig+8, rodata_off);
+    EXPECT_GT(data_off+16+four_gig+8+rodata->getAlign(), rodata_off);
+    EXPECT_EQ(4U, rodata_elf->getSize().getUInt64());
+
+    // everything up to the section contents was written in sequence
+    EXPECT_LT(rodata_off+4, static_cast<uint64_t>(os.tell()));
+
+    // the section headers keep the upper bits of offset and size
+    Bytes scratch;
+    std::string headers;
+    llvm::raw_string_ostream hos(headers);
+    data_elf->Write(hos, scratch);
+    rodata_elf->Write(hos, scratch);
+    hos.flush();
+    EXPECT_EQ(data_off, ReadLE64(headers, 24));             // sh_offset
+    EXPECT_EQ(16+four_gig+8, ReadLE64(headers, 32));        // sh_size
+    EXPECT_EQ(rodata_off, ReadLE64(headers, 64+24));
+    EXPECT_EQ(4U, ReadLE64(headers, 64+32));
+}
@@ -0,0 +1,106 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/DataTypes.h"
+#include "yasmx/Bytes.h"
+
+#include "modules/objfmts/elf/ElfConfig.h"
+#include "modules/objfmts/elf/ElfSection.h"
+#include "modules/objfmts/elf/ElfTypes.h"
+
+using namespace yasm;
+using namespace yasm::objfmt;
+
+static uint64_t
+ReadLE64(const std::string& data, std::string::size_type off)
+{
+    uint64_t val = 0;
+    for (int i=7; i>=0; --i)
+        val = (val << 8) | static_cast<unsigned char>(data[off+i]);
+    return val;
+}
+
+class ElfSectionTest : public ::testing::Test
+{
+protected:
+    ElfConfig config;
+    Bytes scratch;
+    std::string data;
+    llvm::raw_string_ostream os;
+    uint64_t four_gig;
+
+    ElfSectionTest()
+        : os(data)
+        , four_gig(static_cast<uint64_t>(1) << 32)
+    {
+        config.cls = ELFCLASS64;
+        config.encoding = ELFDATA2LSB;
+    }
+};
+
+TEST_F(ElfSectionTest, FileOffsetPast4G)
+{
+    ElfSection sect(config, SHT_PROGBITS, SHF_ALLOC);
+
+    // unaligned
+    EXPECT_EQ(four_gig + 1, sect.setFileOffset(four_gig + 1));
+    EXPECT_EQ(four_gig + 1, sect.getFileOffset());
+
+    // alignment must not truncate the upper bits
+    sect.setAlign(16);
+    EXPECT_EQ(four_gig + 16, sect.setFileOffset(four_gig + 1));
+    EXPECT_EQ(four_gig + 16, sect.getFileOffset());
+
+    sect.setRelFileOffset(four_gig * 3 + 8);
+    EXPECT_EQ(four_gig * 3 + 8, sect.getRelFileOffset());
+}
+
+TEST_F(ElfSectionTest, WriteHeaderPast4G)
+{
+    ElfSection sect(config, SHT_PROGBITS, SHF_ALLOC);
+    sect.setAlign(16);
+    sect.setFileOffset(four_gig * 2 + 0x40);
+    sect.setSize(four_gig + 0x1000);
+    sect.Write(os, scratch);
+    os.flush();
+
+    ASSERT_EQ(static_cast<std::string::size_type>(SHDR64_SIZE), data.size());
+    EXPECT_EQ(four_gig * 2 + 0x40, ReadLE64(data, 24));     // sh_offset
+    EXPECT_EQ(four_gig + 0x1000, ReadLE64(data, 32));       // sh_size
+}
+
+TEST_F(ElfSectionTest, SectionHeaderTablePast4G)
+{
+    config.secthead_pos = four_gig * 5 + 0x10;
+    config.WriteProgramHeader(os, scratch);
+    os.flush();
+
+    ASSERT_EQ(static_cast<std::string::size_type>(EHDR64_SIZE), data.size());
+    EXPECT_EQ(four_gig * 5 + 0x10, ReadLE64(data, 40));     // e_shoff
+}
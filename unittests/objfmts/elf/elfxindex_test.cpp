@@ -0,0 +1,190 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/SourceLocation.h"
+#include "yasmx/Bytes.h"
+#include "yasmx/Bytes_util.h"
+#include "yasmx/Section.h"
+
+#include "modules/objfmts/elf/ElfConfig.h"
+#include "modules/objfmts/elf/ElfSection.h"
+#include "modules/objfmts/elf/ElfSymbol.h"
+#include "modules/objfmts/elf/ElfTypes.h"
+
+#include "unittests/diag_mock.h"
+
+using namespace yasm;
+using namespace yasm::objfmt;
+
+static unsigned long
+ReadLE(const std::string& data, std::string::size_type off, int size)
+{
+    unsigned long val = 0;
+    for (int i=size-1; i>=0; --i)
+        val = (val << 8) | static_cast<unsigned char>(data[off+i]);
+    return val;
+}
+
+class ElfXIndexTest : public ::testing::Test
+{
+protected:
+    ::testing::StrictMock<yasmunit::MockDiagnosticId> mock_client;
+    Diagnostic diags;
+    ElfConfig config;
+    Bytes scratch;
+    std::string data;
+    llvm::raw_string_ostream os;
+
+    ElfXIndexTest()
+        : diags(&mock_client)
+        , os(data)
+    {
+        config.cls = ELFCLASS64;
+        config.encoding = ELFDATA2LSB;
+    }
+
+    /// Write the ELF header followed by the null section header.
+    void WriteHeaders()
+    {
+        ElfSection null_sect(config, SHT_NULL, 0);
+        config.secthead_pos = EHDR64_SIZE;
+        config.setExtendedNumbering(null_sect);
+        config.WriteProgramHeader(os, scratch);
+        null_sect.Write(os, scratch);
+        os.flush();
+        ASSERT_EQ(static_cast<std::string::size_type>(EHDR64_SIZE +
+                                                      SHDR64_SIZE),
+                  data.size());
+    }
+};
+
+TEST_F(ElfXIndexTest, SectionCountsInHeader)
+{
+    config.secthead_count = SHN_LORESERVE - 1;
+    config.shstrtab_index = SHN_LORESERVE - 2;
+    WriteHeaders();
+
+    EXPECT_EQ(static_cast<unsigned long>(SHN_LORESERVE - 1),
+              ReadLE(data, 60, 2));                         // e_shnum
+    EXPECT_EQ(static_cast<unsigned long>(SHN_LORESERVE - 2),
+              ReadLE(data, 62, 2));                         // e_shstrndx
+    EXPECT_EQ(0UL, ReadLE(data, EHDR64_SIZE+32, 8));        // sh_size
+    EXPECT_EQ(0UL, ReadLE(data, EHDR64_SIZE+40, 4));        // sh_link
+}
+
+TEST_F(ElfXIndexTest, SectionCountsInNullSection)
+{
+    config.secthead_count = 0x10005;
+    config.shstrtab_index = 0xff10;
+    WriteHeaders();
+
+    EXPECT_EQ(0UL, ReadLE(data, 60, 2));                    // e_shnum
+    EXPECT_EQ(static_cast<unsigned long>(SHN_XINDEX),
+              ReadLE(data, 62, 2));                         // e_shstrndx
+    EXPECT_EQ(0x10005UL, ReadLE(data, EHDR64_SIZE+32, 8));  // sh_size
+    EXPECT_EQ(0xff10UL, ReadLE(data, EHDR64_SIZE+40, 4));   // sh_link
+
+    // reading the header back picks up the real values
+    std::auto_ptr<llvm::MemoryBuffer>
+        in(llvm::MemoryBuffer::getMemBuffer(data));
+    ElfConfig readconfig;
+    ASSERT_TRUE(readconfig.ReadProgramHeader(*in));
+    EXPECT_EQ(0x10005U, readconfig.secthead_count);
+    EXPECT_EQ(0xff10U, readconfig.shstrtab_index);
+}
+
+TEST_F(ElfXIndexTest, SymbolSectionIndex)
+{
+    ElfSection elfsect(config, SHT_PROGBITS, SHF_ALLOC);
+    ElfSymbol sym;
+    sym.setElfSection(&elfsect);
+
+    elfsect.setIndex(SHN_LORESERVE - 1);
+    sym.Write(scratch, config, diags);
+    ASSERT_EQ(static_cast<Bytes::size_type>(SYMTAB64_SIZE), scratch.size());
+    EXPECT_EQ(0U, sym.getExtendedIndex());
+    EXPECT_EQ(0xffU, scratch[6]);                           // st_shndx
+    EXPECT_EQ(0xfeU, scratch[7]);
+
+    // too large; the real index goes in .symtab_shndx
+    elfsect.setIndex(0xff05);
+    scratch.resize(0);
+    sym.Write(scratch, config, diags);
+    EXPECT_EQ(0xff05U, sym.getExtendedIndex());
+    EXPECT_EQ(0xffU, scratch[6]);                           // SHN_XINDEX
+    EXPECT_EQ(0xffU, scratch[7]);
+}
+
+TEST_F(ElfXIndexTest, ReadSymbolSectionIndex)
+{
+    // symbol table with the null symbol and one symbol in section 0xff05,
+    // followed by the extended section index table
+    ElfSection elfsect(config, SHT_PROGBITS, SHF_ALLOC);
+    elfsect.setIndex(0xff05);
+    ElfSymbol sym;
+    sym.setElfSection(&elfsect);
+
+    ElfSymbol().Write(scratch, config, diags);
+    os << scratch;
+    scratch.resize(0);
+    sym.Write(scratch, config, diags);
+    os << scratch;
+    scratch.resize(0);
+    scratch.setLittleEndian();
+    Write32(scratch, 0);
+    Write32(scratch, sym.getExtendedIndex());
+    os << scratch;
+    os.flush();
+
+    ElfSection symtab_sect(config, SHT_SYMTAB, 0, true);
+    symtab_sect.setFileOffset(0);
+    ElfSection shndx_sect(config, SHT_SYMTAB_SHNDX, 0);
+    shndx_sect.setFileOffset(2*SYMTAB64_SIZE);
+
+    // only the referenced section needs to exist
+    Section sect(".data", false, false, SourceLocation());
+    std::auto_ptr<ElfSection> sect_elfsect(
+        new ElfSection(config, SHT_PROGBITS, SHF_ALLOC));
+    sect_elfsect->setIndex(0xff05);
+    sect.AddAssocData(sect_elfsect);
+    std::vector<Section*> sections(0xff10, static_cast<Section*>(0));
+    sections[0xff05] = &sect;
+    config.secthead_count = 0xff10;
+
+    std::auto_ptr<llvm::MemoryBuffer>
+        in(llvm::MemoryBuffer::getMemBuffer(data));
+    ElfSymbol readsym(config, *in, symtab_sect, &shndx_sect, 1, &sections[0],
+                      diags);
+    EXPECT_EQ(0xff05U, readsym.getExtendedIndex());
+}
@@ -0,0 +1,100 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include "yasmx/Bytecode.h"
+#include "yasmx/BytecodeContainer.h"
+#include "yasmx/Bytes_util.h"
+#include "yasmx/Location.h"
+
+#include "unittests/diag_mock.h"
+
+
+using namespace yasm;
+using namespace yasmunit;
+
+static void
+NoAddSpan(Bytecode& bc, int id, const Value& value, long neg_thres,
+          long pos_thres)
+{
+}
+
+TEST(BytecodeContainerTest, FuseBytecodes)
+{
+    MockDiagnosticId mock_client;
+    Diagnostic diags(&mock_client);
+    BytecodeContainer container(0);
+
+    // two fixed-only bytecodes, a gap, then two more fixed-only
+    Bytecode& bc1 = container.StartBytecode();
+    Write8(bc1.getFixed(), 1);
+    Write8(bc1.getFixed(), 2);
+    Bytecode& bc2 = container.StartBytecode();
+    Write8(bc2.getFixed(), 3);
+    Location loc2 = {&bc2, 1};
+    container.StartBytecode();
+    container.AppendGap(4, SourceLocation());
+    Bytecode& bc3 = container.StartBytecode();
+    Write8(bc3.getFixed(), 4);
+    Bytecode& bc4 = container.StartBytecode();
+    Write8(bc4.getFixed(), 5);
+    Location loc4 = {&bc4, 0};
+
+    ASSERT_EQ(6U, container.size());
+    container.FuseBytecodes();
+    ASSERT_EQ(4U, container.size());
+
+    // Hosts carry the fused data; fused bytecodes keep their own length.
+    EXPECT_EQ(3U, bc1.getFixedLen());
+    EXPECT_EQ(1U, bc2.getFixedLen());
+    EXPECT_EQ(0U, bc2.getTailLen());
+    EXPECT_EQ(1U, bc2.getTotalLen());
+    EXPECT_EQ(&bc1, bc2.getFusedHost());
+    EXPECT_EQ(2U, bc3.getFixedLen());
+    EXPECT_EQ(1U, bc4.getFixedLen());
+    EXPECT_EQ(&bc3, bc4.getFusedHost());
+    EXPECT_TRUE(bc3.getFusedHost() == 0);
+
+    int nfused = 0;
+    for (BytecodeContainer::const_bc_iterator i = container.fused_begin(),
+         end = container.fused_end(); i != end; ++i)
+        ++nfused;
+    EXPECT_EQ(2, nfused);
+
+    // Offsets of fused bytecodes follow their hosts.
+    for (BytecodeContainer::bc_iterator i = container.bytecodes_begin(),
+         end = container.bytecodes_end(); i != end; ++i)
+        i->CalcLen(NoAddSpan, diags);
+    container.UpdateOffsets(diags);
+    EXPECT_EQ(0U, bc1.getOffset());
+    EXPECT_EQ(2U, bc2.getOffset());
+    EXPECT_EQ(3U, bc2.getNextOffset());
+    EXPECT_EQ(3U, loc2.getOffset());
+    EXPECT_EQ(7U, bc3.getOffset());
+    EXPECT_EQ(8U, bc4.getOffset());
+    EXPECT_EQ(9U, bc4.getNextOffset());
+    EXPECT_EQ(8U, loc4.getOffset());
+    EXPECT_EQ(bc3.getIndex(), bc4.getIndex());
+}
@@ -0,0 +1,107 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/BytecodeOutput.h"
+
+#include "unittests/diag_mock.h"
+
+
+using namespace yasm;
+using namespace yasmunit;
+
+namespace {
+
+// Records each DoOutputBytes() call; uses the base DoOutputBuffer().
+class ChunkOutput : public BytecodeOutput
+{
+public:
+    ChunkOutput(Diagnostic& diags) : BytecodeOutput(diags), m_calls(0) {}
+
+    bool ConvertValueToBytes(Value& value, Location loc, NumericOutput& num_out)
+    { return true; }
+
+    std::string m_data;
+    unsigned int m_calls;
+
+protected:
+    void DoOutputGap(uint64_t size, SourceLocation source) {}
+    void DoOutputBytes(const Bytes& bytes, SourceLocation source)
+    {
+        m_data.append(bytes.begin(), bytes.end());
+        ++m_calls;
+    }
+};
+
+class StreamOutput : public BytecodeStreamOutput
+{
+public:
+    StreamOutput(llvm::raw_ostream& os, Diagnostic& diags)
+        : BytecodeStreamOutput(os, diags)
+    {}
+
+    bool ConvertValueToBytes(Value& value, Location loc, NumericOutput& num_out)
+    { return true; }
+};
+
+} // anonymous namespace
+
+TEST(BytecodeOutputTest, OutputBufferChunked)
+{
+    MockDiagnosticId mock_client;
+    Diagnostic diags(&mock_client);
+    ChunkOutput out(diags);
+
+    std::string data;
+    for (unsigned long i=0; i<200000; ++i)
+        data.push_back(static_cast<char>(i*7));
+
+    out.OutputBuffer(reinterpret_cast<const unsigned char*>(data.data()),
+                     data.size(), SourceLocation());
+    EXPECT_EQ(data, out.m_data);
+    EXPECT_EQ(200000UL, out.getNumOutput());
+    EXPECT_EQ(4U, out.m_calls);     // 3 full 64K blocks plus remainder
+
+    out.OutputBuffer(0, 0, SourceLocation());
+    EXPECT_EQ(4U, out.m_calls);
+}
+
+TEST(BytecodeOutputTest, OutputBufferStream)
+{
+    MockDiagnosticId mock_client;
+    Diagnostic diags(&mock_client);
+    std::string result;
+    llvm::raw_string_ostream os(result);
+    StreamOutput out(os, diags);
+
+    static const unsigned char data[] = {1, 2, 3, 0, 5};
+    out.OutputBuffer(data, 5, SourceLocation());
+    os.flush();
+    EXPECT_EQ(std::string("\x01\x02\x03\x00\x05", 5), result);
+    EXPECT_EQ(5UL, out.getNumOutput());
+}
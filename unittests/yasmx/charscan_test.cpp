@@ -0,0 +1,130 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "yasmx/Parse/CharScan.h"
+
+using namespace yasm;
+
+// Each test places the input at every offset within a 64 byte window so
+// that the stop character lands in every position of a block, and on
+// either side of a block boundary.
+class CharScanTest : public ::testing::Test
+{
+protected:
+    char m_buf[256];
+
+    const char* Place(const char* str, unsigned int offset)
+    {
+        std::memset(m_buf, 'x', sizeof(m_buf));
+        std::strcpy(m_buf + offset, str);
+        return m_buf + offset;
+    }
+};
+
+TEST_F(CharScanTest, HorzSpace)
+{
+    static const char* strs[] =
+    {
+        "a", " a", " \t \t\tb", "                                    ;",
+        "   ", "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\n",
+        " \f", ""
+    };
+    static const unsigned int lens[] = {0, 1, 5, 36, 3, 30, 1, 0};
+    for (unsigned int i=0; i<sizeof(strs)/sizeof(strs[0]); ++i)
+    {
+        for (unsigned int off=0; off<64; ++off)
+        {
+            const char* str = Place(strs[i], off);
+            EXPECT_EQ(lens[i], static_cast<unsigned int>(
+                ScanHorzSpace(str) - str)) << i << " @ " << off;
+        }
+    }
+}
+
+TEST_F(CharScanTest, LineComment)
+{
+    static const char* strs[] =
+    {
+        "\n", "abc\r\n", "comment with \\ backslash",
+        "a much longer comment that crosses at least one block boundary\n",
+        "no newline at all", "\x80\xff high bytes\n"
+    };
+    static const unsigned int lens[] = {0, 3, 13, 62, 17, 13};
+    for (unsigned int i=0; i<sizeof(strs)/sizeof(strs[0]); ++i)
+    {
+        for (unsigned int off=0; off<64; ++off)
+        {
+            const char* str = Place(strs[i], off);
+            EXPECT_EQ(lens[i], static_cast<unsigned int>(
+                ScanLineComment(str) - str)) << i << " @ " << off;
+        }
+    }
+}
+
+TEST_F(CharScanTest, Identifier)
+{
+    static const char* strs[] =
+    {
+        "+", "a+", "foo_Bar09 ",
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        "x.y", "Z[", "z{", "9:", "_@", "a`", "a\x80", "ab$"
+    };
+    static const unsigned int lens[] = {0, 1, 9, 52, 1, 1, 1, 1, 1, 1, 1, 2};
+    for (unsigned int i=0; i<sizeof(strs)/sizeof(strs[0]); ++i)
+    {
+        for (unsigned int off=0; off<64; ++off)
+        {
+            const char* str = Place(strs[i], off);
+            EXPECT_EQ(lens[i], static_cast<unsigned int>(
+                ScanIdentifier(str) - str)) << i << " @ " << off;
+        }
+    }
+}
+
+TEST_F(CharScanTest, StringLiteral)
+{
+    static const char* strs[] =
+    {
+        "\"", "abc'def\"", "abc\\\"", "line\nbreak\"",
+        "a string long enough to span more than one block of input'",
+        "unterminated"
+    };
+    static const unsigned int dq_lens[] = {0, 7, 3, 4, 58, 12};
+    static const unsigned int sq_lens[] = {1, 3, 3, 4, 57, 12};
+    for (unsigned int i=0; i<sizeof(strs)/sizeof(strs[0]); ++i)
+    {
+        for (unsigned int off=0; off<64; ++off)
+        {
+            const char* str = Place(strs[i], off);
+            EXPECT_EQ(dq_lens[i], static_cast<unsigned int>(
+                ScanStringLiteral(str, '"') - str)) << i << " @ " << off;
+            EXPECT_EQ(sq_lens[i], static_cast<unsigned int>(
+                ScanStringLiteral(str, '\'') - str)) << i << " @ " << off;
+        }
+    }
+}
@@ -109,6 +109,39 @@ TEST_F(ExprTest, Contains)
     EXPECT_TRUE(x.Contains(ExprTerm::REG));
 }
 
+// Expr::CalcFold() tests
+TEST_F(ExprTest, CalcFold)
+{
+    x = 4;
+    x.CalcFold(Op::MUL, Expr(8));
+    x.CalcFold(Op::ADD, Expr(2));
+    EXPECT_EQ("34", String::Format(x));
+
+    x = 1;
+    x.CalcFold(Op::SHL, Expr(12));
+    x.CalcFold(Op::SUB, Expr(1));
+    x.CalcFold(Op::NOT);
+    EXPECT_EQ("-4096", String::Format(x));
+
+    // non-integer operands build a tree
+    x = a;
+    x.CalcFold(Op::ADD, Expr(2));
+    EXPECT_EQ("a+2", String::Format(x));
+
+    x = 2;
+    x.CalcFold(Op::MUL, Expr(a));
+    EXPECT_EQ("2*a", String::Format(x));
+
+    // errors are left for Simplify() to report
+    x = 5;
+    x.CalcFold(Op::DIV, Expr(0));
+    EXPECT_EQ("5/0", String::Format(x));
+
+    x = 5;
+    x.CalcFold(Op::SIGNMOD, Expr(0));
+    EXPECT_EQ("5%%0", String::Format(x));
+}
+
 // Expr::TransformNeg() tests
 TEST_F(ExprTest, TransformNeg)
 {
@@ -0,0 +1,87 @@
+//
+//  Copyright (C) 2010  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/StringTable.h"
+
+using namespace yasm;
+
+static std::string
+Contents(const StringTable& strtab)
+{
+    std::string s;
+    llvm::raw_string_ostream os(s);
+    strtab.Write(os);
+    os.flush();
+    return s;
+}
+
+TEST(StringTableTest, Append)
+{
+    StringTable strtab;
+    EXPECT_EQ(1UL, strtab.getIndex(".text"));
+    EXPECT_EQ(7UL, strtab.getIndex(".text"));
+    EXPECT_EQ(std::string("\0.text\0.text\0", 13), Contents(strtab));
+}
+
+TEST(StringTableTest, MergeDuplicates)
+{
+    StringTable strtab(4, true);
+    EXPECT_EQ(4UL, strtab.getIndex(""));
+    EXPECT_EQ(5UL, strtab.getIndex("foo"));
+    EXPECT_EQ(9UL, strtab.getIndex("bar"));
+    EXPECT_EQ(5UL, strtab.getIndex("foo"));
+    EXPECT_EQ(9UL, strtab.getIndex("bar"));
+    EXPECT_EQ(9UL, strtab.getSize());
+}
+
+TEST(StringTableTest, MergeTails)
+{
+    StringTable strtab(0, true);
+    strtab.Add(".text");
+    strtab.Add(".data");
+    strtab.Add(".rela.text");
+    strtab.Add("text");
+    strtab.Add(".rela.data");
+    strtab.Add(".text");
+    strtab.Finalize();
+
+    EXPECT_EQ(std::string("\0.rela.text\0.rela.data\0", 23),
+              Contents(strtab));
+    EXPECT_EQ(1UL, strtab.getIndex(".rela.text"));
+    EXPECT_EQ(6UL, strtab.getIndex(".text"));
+    EXPECT_EQ(7UL, strtab.getIndex("text"));
+    EXPECT_EQ(12UL, strtab.getIndex(".rela.data"));
+    EXPECT_EQ(17UL, strtab.getIndex(".data"));
+    EXPECT_EQ(".text", strtab.getString(6).str());
+
+    // Strings not added before Finalize() are appended.
+    EXPECT_EQ(23UL, strtab.getIndex(".bss"));
+    EXPECT_EQ(23UL, strtab.getIndex(".bss"));
+    EXPECT_EQ(28UL, strtab.getSize());
+}